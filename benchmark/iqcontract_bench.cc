@@ -0,0 +1,172 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+//
+// Times the contraction of two IQTensors with many
+// small blocks, as in a DMRG calculation conserving two
+// quantum numbers (e.g. the Hubbard model with U(1)xU(1)).
+//
+// IQTensor::operator* (which groups blocks by their
+// contracted sectors) is compared to the previous
+// algorithm: a double loop over all pairs of blocks
+// matched by sums of uniqueReals, and a linear search
+// for the result block.
+//
+#include "core.h"
+
+using namespace itensor;
+using std::vector;
+
+//Bond index with sectors (Sz,Nf) for |Sz| <= S, 0 <= Nf <= 2S,
+//each of dimension m
+IQIndex static
+bondIndex(const std::string& name, int S, int m, Arrow dir)
+    {
+    vector<IndexQN> iq;
+    for(int sz = -S; sz <= S; ++sz)
+    for(int nf = 0; nf <= 2*S; ++nf)
+        {
+        iq.push_back(IndexQN(Index(nameint(name,iq.size()+1),m),QN(sz,nf)));
+        }
+    return IQIndex(name,iq,dir);
+    }
+
+//Hubbard site: empty, up, down, doubly occupied
+IQIndex static
+siteIndex(const std::string& name)
+    {
+    return IQIndex(name,
+                   Index(name+"0",1,Site),QN(0,0),
+                   Index(name+"Up",1,Site),QN(+1,1),
+                   Index(name+"Dn",1,Site),QN(-1,1),
+                   Index(name+"UD",1,Site),QN(0,2),
+                   Out);
+    }
+
+//Random IQTensor with a block for every sector
+//with qn(l1)+qn(s) == qn(l2)
+IQTensor static
+randomMPSTensor(const IQIndex& l1, const IQIndex& s, const IQIndex& l2)
+    {
+    IQTensor T(l1,s,l2);
+    for(int i = 1; i <= l1.nindex(); ++i)
+    for(int j = 1; j <= s.nindex(); ++j)
+    for(int k = 1; k <= l2.nindex(); ++k)
+        {
+        if(!(l1.qn(i)+s.qn(j) == l2.qn(k))) continue;
+        ITensor b(l1.index(i),s.index(j),l2.index(k));
+        b.randomize();
+        T += b;
+        }
+    return T;
+    }
+
+bool static
+containsUR(const vector<Real>& v, Real r)
+    {
+    Foreach(const Real& x, v)
+        {
+        if(fabs(r-x) <= UniqueRealAccuracy) return true;
+        }
+    return false;
+    }
+
+//Block matching and accumulation as done
+//previously by IQTensor::operator*=
+void static
+legacyContract(const IQTensor& A, const IQTensor& B,
+               const IQIndex& c, vector<ITensor>& res)
+    {
+    vector<Real> common_inds;
+    Foreach(const Index& i, c.indices())
+        common_inds.push_back(i.uniqueReal());
+
+    vector<Real> rB;
+    Foreach(const ITensor& t, B.blocks())
+        {
+        Real r = 0;
+        Foreach(const Index& I, t.indices())
+            if(containsUR(common_inds,I.uniqueReal())) r += I.uniqueReal();
+        rB.push_back(r);
+        }
+
+    res.clear();
+    ITensor prod;
+    Foreach(const ITensor& t, A.blocks())
+        {
+        Real r = 0;
+        Foreach(const Index& I, t.indices())
+            if(containsUR(common_inds,I.uniqueReal())) r += I.uniqueReal();
+        int n = 0;
+        Foreach(const ITensor& u, B.blocks())
+            {
+            if(fabs(r-rB[n++]) > UniqueRealAccuracy) continue;
+            prod = t;
+            prod *= u;
+            vector<ITensor>::iterator it = find(res.begin(),res.end(),prod.indices());
+            if(it == res.end()) res.push_back(prod);
+            else                *it += prod;
+            }
+        }
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    //Max |Sz|, giving (2S+1)^2 sectors per bond,
+    //and the dimension of each sector
+    int S = 7,
+        m = 4;
+    if(argc > 1) S = atoi(argv[1]);
+    if(argc > 2) m = atoi(argv[2]);
+
+    const IQIndex l1 = bondIndex("l1",S,m,In),
+                 l2 = bondIndex("l2",S,m,Out),
+                 l3 = bondIndex("l3",S,m,Out),
+                 s1 = siteIndex("s1"),
+                 s2 = siteIndex("s2");
+
+    const IQTensor A = randomMPSTensor(l1,s1,l2),
+                   B = randomMPSTensor(dag(l2),s2,l3);
+
+    printfln("%d sectors per bond of dimension %d",l1.nindex(),m);
+    printfln("Blocks: A %d, B %d",A.blocks().size(),B.blocks().size());
+
+    const int nrep = 5;
+
+    Real t0 = wallTime();
+    IQTensor C;
+    for(int k = 0; k < nrep; ++k) C = A*B;
+    const Real tnew = (wallTime()-t0)/nrep;
+
+    //Threaded block products (needs OpenMP, 
+    //set the number of threads with OMP_NUM_THREADS)
+    Global::opts("ThreadedBlocks",true);
+    t0 = wallTime();
+    IQTensor Ct;
+    for(int k = 0; k < nrep; ++k) Ct = A*B;
+    const Real tthr = (wallTime()-t0)/nrep;
+    Global::opts("ThreadedBlocks",false);
+
+    t0 = wallTime();
+    vector<ITensor> L;
+    for(int k = 0; k < nrep; ++k) legacyContract(A,B,l2,L);
+    const Real told = (wallTime()-t0)/nrep;
+
+    Real diff = 0;
+    Foreach(const ITensor& t, L)
+        {
+        diff += (C.blocks().get(t.indices())-t).norm();
+        }
+    const bool same = (int(L.size()) == C.blocks().size() && diff < 1E-10);
+
+    printfln("Result blocks: %d",C.blocks().size());
+    printfln("IQTensor::operator*   %10.3f ms",tnew*1E3);
+    printfln("  with ThreadedBlocks %10.3f ms%s",tthr*1E3,
+             ((Ct-C).norm() == 0 ? "" : "  RESULTS DIFFER"));
+    printfln("Previous algorithm    %10.3f ms  (%.1fx)%s",
+             told*1E3,told/tnew,(same ? "" : "  RESULTS DIFFER"));
+
+    return 0;
+    }
@@ -0,0 +1,81 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+//
+// Compares the zip-up MPO product nmultMPO with the
+// variational fitMultMPO by squaring Hamiltonian MPOs,
+// reporting run time, the largest bond dimension of H*H
+// and the relative error of <psi|H*H|psi> for a low
+// energy state psi:
+//
+//  err: |<psi|HH|psi> - <psi|H H|psi>| / <psi|H H|psi>
+//
+#include "core.h"
+#include "sites/spinhalf.h"
+#include "sites/hubbard.h"
+#include "hams/Heisenberg.h"
+#include "hams/HubbardChain.h"
+
+using namespace itensor;
+
+int static
+maxLinkM(const IQMPO& H)
+    {
+    int m = 0;
+    for(int b = 1; b < H.N(); ++b) m = std::max(m,linkInd(H,b).m());
+    return m;
+    }
+
+void static
+runCase(const std::string& name,
+        const SiteSet& sites,
+        const IQMPO& H)
+    {
+    const int N = sites.N();
+    InitState init(sites);
+    for(int j = 1; j <= N; ++j) init.set(j,(j%2==1 ? "Up" : "Dn"));
+    IQMPS psi(init);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10,20;
+    dmrg(psi,H,sweeps,Opt("Quiet"));
+
+    const Real exact = psiHKphi(psi,H,H,psi);
+    const OptSet opts = Opt("Cutoff",1E-12) & Opt("Maxm",5000);
+
+    for(int j = 0; j < 2; ++j)
+        {
+        IQMPO HH;
+        const Real t0 = wallTime();
+        if(j == 0) nmultMPO(H,H,HH,opts);
+        else       fitMultMPO(H,H,HH,opts);
+        const Real t = wallTime()-t0;
+
+        printfln("%-22s k %3d  %-10s  %8.3f s  k(HH) %4d  err %8.2E",
+                 name,maxLinkM(H),(j == 0 ? "nmultMPO" : "fitMultMPO"),t,maxLinkM(HH),
+                 fabs(psiHphi(psi,HH,psi)-exact)/fabs(exact));
+        }
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    //Length of the Heisenberg chain
+    //(the other systems scale with it)
+    int N = 40;
+    if(argc > 1) N = atoi(argv[1]);
+
+    SpinHalf chain(N);
+    runCase(format("Heisenberg chain N=%d",N),chain,Heisenberg(chain));
+
+    Hubbard hchain(N/2);
+    runCase(format("Hubbard chain N=%d",N/2),hchain,HubbardChain(hchain,Opt("U",4.)));
+
+    for(int Nx = N/10; Nx <= 3*N/20; Nx += N/20)
+        {
+        SpinHalf cyl(4*Nx);
+        runCase(format("Heisenberg 4x%d",Nx),cyl,Heisenberg(cyl,Opt("Ny",4)));
+        }
+
+    return 0;
+    }
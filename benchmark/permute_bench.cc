@@ -0,0 +1,154 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+//
+// Times the dense tensor permutation kernel permuteData
+// (used by ITensor reshapes before matrix multiplication)
+// over a range of tensor shapes and permutations and
+// compares it to the memcpy bandwidth of the machine.
+//
+#include "permute.h"
+#include <algorithm>
+#include <vector>
+
+using namespace itensor;
+using std::vector;
+
+//Straightforward loop over src used to check results
+void static
+referencePermute(const vector<int>& dims,
+                 const vector<int>& dest,
+                 const vector<Real>& src,
+                 vector<Real>& dst)
+    {
+    const int r = dims.size();
+    vector<long> nstride(r);
+    vector<int> ndims(r);
+    for(int j = 0; j < r; ++j) ndims[dest[j]] = dims[j];
+    long s = 1;
+    vector<long> ps(r);
+    for(int k = 0; k < r; ++k) { ps[k] = s; s *= ndims[k]; }
+    for(int j = 0; j < r; ++j) nstride[j] = ps[dest[j]];
+
+    vector<int> i(r,0);
+    for(size_t n = 0; n < src.size(); ++n)
+        {
+        long off = 0;
+        for(int j = 0; j < r; ++j) off += i[j]*nstride[j];
+        dst[off] = src[n];
+        for(int j = 0; j < r; ++j)
+            {
+            if(++i[j] < dims[j]) break;
+            i[j] = 0;
+            }
+        }
+    }
+
+void static
+runCase(const vector<int>& dims, const vector<int>& dest)
+    {
+    long size = 1;
+    for(size_t j = 0; j < dims.size(); ++j) size *= dims[j];
+
+    vector<Real> src(size), dst(size), ref(size);
+    for(long n = 0; n < size; ++n) src[n] = Global::random();
+
+    //Repeat enough times to move roughly 2GB
+    const int nrep = std::max(1L,(1L<<28)/size);
+
+    Real t0 = wallTime();
+    for(int k = 0; k < nrep; ++k)
+        std::copy(src.begin(),src.end(),dst.begin());
+    const Real tcopy = (wallTime()-t0)/nrep;
+
+    t0 = wallTime();
+    for(int k = 0; k < nrep; ++k)
+        permuteData(dims.size(),&dims[0],&dest[0],&src[0],&dst[0]);
+    const Real tperm = (wallTime()-t0)/nrep;
+
+    referencePermute(dims,dest,src,ref);
+    Real maxdiff = 0;
+    for(long n = 0; n < size; ++n)
+        maxdiff = std::max(maxdiff,fabs(ref[n]-dst[n]));
+
+    const Real gbytes = 2.*sizeof(Real)*size*1E-9;
+
+    std::string shape, perm;
+    for(size_t j = 0; j < dims.size(); ++j)
+        {
+        shape += format("%s%d",(j==0?"":"x"),dims[j]);
+        perm += format("%d",dest[j]+1);
+        }
+    printfln("%-22s (%s)  %8.3f ms  %6.2f GB/s  %5.1f%% of copy%s",
+             shape,perm,tperm*1E3,gbytes/tperm,100*tcopy/tperm,
+             (maxdiff == 0 ? "" : "  WRONG RESULT"));
+    }
+
+//Make a vector from a list of up to NMAX ints, ended by -1
+vector<int> static
+ilist(int i1, int i2, int i3 = -1, int i4 = -1,
+      int i5 = -1, int i6 = -1, int i7 = -1, int i8 = -1)
+    {
+    const int a[] = { i1, i2, i3, i4, i5, i6, i7, i8 };
+    vector<int> v;
+    for(int j = 0; j < NMAX && a[j] >= 0; ++j) v.push_back(a[j]);
+    return v;
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    const char* ont = getenv("OMP_NUM_THREADS");
+    if(ont != NULL)
+        println("OMP_NUM_THREADS = ",ont);
+
+    //Bond dimension m and site dimension d
+    //of the shapes swept below
+    int m = 200;
+    if(argc > 1) m = atoi(argv[1]);
+    const int d = 4,
+              k = 5; //MPO bond dimension
+
+    println("Rank 2");
+    runCase(ilist(m*d,m*d),ilist(1,0));
+    runCase(ilist(4*m*d,m),ilist(1,0));
+
+    println("Rank 3");
+    const vector<int> dims3 = ilist(m,d,m);
+    runCase(dims3,ilist(1,0,2));
+    runCase(dims3,ilist(1,2,0));
+    runCase(dims3,ilist(2,0,1));
+    runCase(dims3,ilist(0,2,1));
+    runCase(dims3,ilist(2,1,0));
+
+    println("Rank 4");
+    const vector<int> dims4 = ilist(m,d,k,m);
+    runCase(dims4,ilist(0,1,3,2));
+    runCase(dims4,ilist(0,2,1,3));
+    runCase(dims4,ilist(1,2,0,3));
+    runCase(dims4,ilist(1,2,3,0));
+    runCase(dims4,ilist(0,3,1,2));
+    runCase(dims4,ilist(1,0,2,3));
+    runCase(dims4,ilist(2,3,0,1));
+    runCase(dims4,ilist(3,2,1,0));
+
+    println("Rank 5");
+    const vector<int> dims5 = ilist(m/2,d,d,k,m/2);
+    runCase(dims5,ilist(2,0,3,4,1));
+    runCase(dims5,ilist(0,3,1,4,2));
+    runCase(dims5,ilist(4,3,2,1,0));
+    runCase(dims5,ilist(1,2,3,4,0));
+
+    println("Rank 6");
+    const vector<int> dims6 = ilist(m/4,d,d,k,k,m/4);
+    runCase(dims6,ilist(1,3,0,2,4,5));
+    runCase(dims6,ilist(2,3,0,4,5,1));
+    runCase(dims6,ilist(5,4,3,2,1,0));
+
+    println("Rank 8");
+    runCase(ilist(3,4,5,6,6,5,4,3),ilist(7,6,5,4,3,2,1,0));
+    runCase(ilist(8,3,4,5,6,6,5,4),ilist(1,2,3,4,5,6,7,0));
+
+    return 0;
+    }
@@ -0,0 +1,122 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+//
+// Compares the dense SVD routines selectable through
+// the "SVDMethod" option of svdRank2 (Iterative, gesdd,
+// Jacobi and Randomized) over a range of matrix sizes and 
+// condition numbers, reporting run time and accuracy:
+//
+//  resid: |A - U*D*V| / |A|
+//  orth:  |U.t()*U - 1| + |V*V.t() - 1|
+//  relsv: max relative error of the singular values
+//         larger than 1E-12 times the largest one
+//
+// Randomized only computes the largest k = min(n,m)/8 
+// singular values (relsv is computed for these only), 
+// so its resid is the truncation error.
+//
+#include "core.h"
+
+using namespace itensor;
+
+//Random n x n orthogonal matrix
+Matrix static
+randomOrthog(int n)
+    {
+    Matrix S(n,n);
+    S.Randomize();
+    S += S.t();
+    Matrix O;
+    Vector evals;
+    EigenValues(S,evals,O);
+    return O;
+    }
+
+Real static
+frobNorm(const Matrix& M)
+    {
+    return Norm(Matrix(M).TreatAsVector());
+    }
+
+void static
+runCase(int n, int m, Real cond)
+    {
+    //A = Uo * diag(s) * Vo with s
+    //geometric from 1 down to 1/cond
+    const int k = std::min(n,m);
+    Vector exact(k);
+    Matrix DD(k,k);
+    DD = 0;
+    for(int i = 1; i <= k; ++i)
+        {
+        exact(i) = pow(cond,-(i-1.)/(k-1.));
+        DD(i,i) = exact(i);
+        }
+    Matrix A = randomOrthog(n).SubMatrix(1,n,1,k)
+             * DD
+             * randomOrthog(m).SubMatrix(1,k,1,m);
+    const Real Anorm = frobNorm(A);
+
+    const int kr = k/8;
+    const std::string methods[] = { "Iterative", "gesdd", "Jacobi", "Randomized" };
+    for(int j = 0; j < 4; ++j)
+        {
+        Matrix U,V;
+        Vector D;
+
+        const int nrep = std::max(1,(int)(2E7/(Real(n)*m*k)));
+        Real t0 = wallTime();
+        for(int r = 0; r < nrep; ++r)
+            {
+            if(j == 0)      SVD(A,U,D,V);
+            else if(j == 1) SVDgesdd(A,U,D,V);
+            else if(j == 2) SVDJacobi(A,U,D,V);
+            else            SVDRandomized(A,U,D,V,kr);
+            }
+        const Real t = (wallTime()-t0)/nrep;
+
+        Matrix Dm(D.Length(),D.Length());
+        Dm = 0;
+        Dm.Diagonal() = D;
+        const Real resid = frobNorm(A - U*Dm*V)/Anorm;
+
+        Matrix Iu(U.Ncols(),U.Ncols()),
+               Iv(V.Nrows(),V.Nrows());
+        Iu = 1;
+        Iv = 1;
+        const Real orth = frobNorm(U.t()*U-Iu)+frobNorm(V*V.t()-Iv);
+
+        Real relsv = 0;
+        for(int i = 1; i <= (j == 3 ? kr : k); ++i)
+            {
+            if(exact(i) < 1E-12*exact(1)) break;
+            relsv = std::max(relsv,fabs(D(i)-exact(i))/exact(i));
+            }
+
+        printfln("%4d x %-4d  cond %7.1E  %-10s  %9.3f ms  resid %8.2E  orth %8.2E  relsv %8.2E",
+                 n,m,cond,methods[j],t*1E3,resid,orth,relsv);
+        }
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    //Largest matrix size
+    int nmax = 400;
+    if(argc > 1) nmax = atoi(argv[1]);
+
+    const Real conds[] = { 1E2, 1E8, 1E14 };
+
+    for(int n = 50; n <= nmax; n *= 2)
+        {
+        for(int c = 0; c < 3; ++c)
+            {
+            runCase(n,2*n,conds[c]);
+            }
+        println();
+        }
+
+    return 0;
+    }
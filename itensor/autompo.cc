@@ -0,0 +1,595 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "autompo.h"
+#include <algorithm>
+
+namespace itensor {
+
+using std::string;
+using std::vector;
+using std::map;
+using std::make_pair;
+
+typedef AutoMPO::SiteTerm
+SiteTerm;
+
+typedef AutoMPO::SiteTermProd
+SiteTermProd;
+
+typedef AutoMPO::HTerm
+HTerm;
+
+bool
+operator<(const SiteTerm& a, const SiteTerm& b)
+    {
+    if(a.i != b.i) return a.i < b.i;
+    return a.op < b.op;
+    }
+
+bool
+operator==(const SiteTerm& a, const SiteTerm& b)
+    {
+    return a.i == b.i && a.op == b.op;
+    }
+
+//
+// AutoMPO::Accumulator
+//
+
+AutoMPO::Accumulator::
+Accumulator(AutoMPO& ampo, Real coef)
+    :
+    ampo_(&ampo),
+    active_(true),
+    bad_(false)
+    {
+    term_.coef = coef;
+    }
+
+AutoMPO::Accumulator::
+Accumulator(AutoMPO& ampo, const string& op)
+    :
+    ampo_(&ampo),
+    active_(true),
+    bad_(false),
+    op_(op)
+    {
+    term_.coef = 1;
+    }
+
+AutoMPO::Accumulator::
+Accumulator(const Accumulator& other)
+    :
+    ampo_(other.ampo_),
+    active_(other.active_),
+    bad_(other.bad_),
+    term_(other.term_),
+    op_(other.op_)
+    {
+    other.active_ = false;
+    }
+
+AutoMPO::Accumulator::
+~Accumulator()
+    {
+    if(!active_) return;
+    //Errors are reported by toIQMPO
+    //rather than thrown from a destructor
+    if(bad_ || !op_.empty() || term_.ops.empty())
+        {
+        ampo_->bad_term_ = "AutoMPO: terms must be a coefficient followed by pairs of operator names and sites";
+        return;
+        }
+    ampo_->addTerm(term_);
+    }
+
+AutoMPO::Accumulator& AutoMPO::Accumulator::
+operator,(const string& op)
+    {
+    if(!op_.empty()) bad_ = true;
+    op_ = op;
+    return *this;
+    }
+
+AutoMPO::Accumulator& AutoMPO::Accumulator::
+operator,(int i)
+    {
+    if(op_.empty())
+        {
+        bad_ = true;
+        return *this;
+        }
+    term_.ops.push_back(SiteTerm(i,op_));
+    op_.clear();
+    return *this;
+    }
+
+//
+// AutoMPO
+//
+
+AutoMPO::
+AutoMPO(const SiteSet& sites)
+    :
+    sites_(&sites)
+    { }
+
+void AutoMPO::
+add(Real coef,
+    const string& op1, int i1,
+    const string& op2, int i2,
+    const string& op3, int i3,
+    const string& op4, int i4)
+    {
+    HTerm t;
+    t.coef = coef;
+    if(op1 != "") t.ops.push_back(SiteTerm(i1,op1));
+    if(op2 != "") t.ops.push_back(SiteTerm(i2,op2));
+    if(op3 != "") t.ops.push_back(SiteTerm(i3,op3));
+    if(op4 != "") t.ops.push_back(SiteTerm(i4,op4));
+    if(t.ops.empty()) Error("AutoMPO::add: no operators given");
+    addTerm(t);
+    }
+
+void AutoMPO::
+addTerm(const HTerm& t)
+    {
+    terms_.push_back(t);
+    }
+
+bool static
+isFermionic(const string& op)
+    {
+    return !op.empty() && op[0] == 'C';
+    }
+
+struct SiteLess
+    {
+    bool
+    operator()(const SiteTerm& a, const SiteTerm& b) const { return a.i < b.i; }
+    };
+
+//
+// Puts the operators of t in site order (with a sign for
+// each exchange of two fermionic operators) and combines
+// those on the same site into a single operator named
+// "A*B*...", appending the Jordan-Wigner string operator F
+// on every site having an odd number of fermionic
+// operators to its right.
+//
+HTerm static
+siteOrder(const HTerm& t, int N)
+    {
+    const SiteTermProd& ops = t.ops;
+    const int nop = int(ops.size());
+
+    HTerm res;
+    res.coef = t.coef;
+
+    int nferm = 0;
+    for(int a = 0; a < nop; ++a)
+        {
+        if(ops[a].i < 1 || ops[a].i > N)
+            {
+            Error(format("AutoMPO: site %d of operator \"%s\" out of range",ops[a].i,ops[a].op));
+            }
+        if(!isFermionic(ops[a].op)) continue;
+        ++nferm;
+        for(int b = a+1; b < nop; ++b)
+            {
+            if(ops[b].i < ops[a].i && isFermionic(ops[b].op)) res.coef *= -1;
+            }
+        }
+    if(nferm%2 == 1) Error("AutoMPO: terms must have an even number of fermionic operators");
+
+    SiteTermProd sorted(ops);
+    std::stable_sort(sorted.begin(),sorted.end(),SiteLess());
+
+    //Go from the rightmost site to the leftmost,
+    //counting the fermionic operators passed
+    int nright = 0;
+    int k = nop-1;
+    for(int j = sorted.back().i; j >= sorted.front().i; --j)
+        {
+        string name;
+        int nhere = 0;
+        for(; k >= 0 && sorted[k].i == j; --k)
+            {
+            name = (name.empty() ? sorted[k].op : sorted[k].op + "*" + name);
+            if(isFermionic(sorted[k].op)) ++nhere;
+            }
+        if(nright%2 == 1) name = (name.empty() ? string("F") : name + "*F");
+        if(!name.empty()) res.ops.push_back(SiteTerm(j,name));
+        nright += nhere;
+        }
+    std::reverse(res.ops.begin(),res.ops.end());
+    return res;
+    }
+
+//
+// Site operators and their quantum number flux,
+// computed once for each site and name
+//
+class SiteOpCache
+    {
+    public:
+
+    SiteOpCache(const SiteSet& sites) : sites_(sites) { }
+
+    const IQTensor&
+    op(const SiteTerm& st)
+        {
+        map<SiteTerm,IQTensor>::const_iterator it = ops_.find(st);
+        if(it != ops_.end()) return it->second;
+
+        IQTensor& T = ops_[st];
+        size_t pos = 0;
+        while(true)
+            {
+            const size_t next = st.op.find('*',pos);
+            const IQTensor f = sites_.op(st.op.substr(pos,next-pos),st.i);
+            T = (T.valid() ? multSiteOps(T,f) : f);
+            if(next == string::npos) break;
+            pos = next+1;
+            }
+        flux_[st] = div(T);
+        return T;
+        }
+
+    QN
+    flux(const SiteTerm& st)
+        {
+        if(!flux_.count(st)) op(st);
+        return flux_[st];
+        }
+
+    QN
+    flux(const SiteTermProd& p)
+        {
+        QN q;
+        Foreach(const SiteTerm& st, p) q += flux(st);
+        return q;
+        }
+
+    private:
+
+    const SiteSet& sites_;
+    map<SiteTerm,IQTensor> ops_;
+    map<SiteTerm,QN> flux_;
+    };
+
+//
+// Coefficients connecting the left parts (rows) and right
+// parts (columns) of the terms crossing a bond, for right
+// parts with quantum number flux q, and their SVD
+//
+struct BondBlock
+    {
+    QN q;
+    vector<SiteTermProd> rows,
+                         cols;
+    map<SiteTermProd,int> row_ind,
+                          col_ind;
+    vector<std::pair<std::pair<int,int>,Real> > coefs;
+    Matrix M;
+    Vector D;
+    Matrix US, //rows x nkeep
+           V;  //nkeep x cols
+    int nkeep,
+        offset; //position of first state on link
+
+    BondBlock() : nkeep(0), offset(0) { }
+
+    int static
+    index(const SiteTermProd& p,
+          vector<SiteTermProd>& ps,
+          map<SiteTermProd,int>& ind)
+        {
+        map<SiteTermProd,int>::const_iterator it = ind.find(p);
+        if(it != ind.end()) return it->second;
+        ps.push_back(p);
+        return (ind[p] = int(ps.size())-1);
+        }
+
+    void
+    add(const SiteTermProd& l, const SiteTermProd& r, Real coef)
+        {
+        const int i = index(l,rows,row_ind),
+                  j = index(r,cols,col_ind);
+        coefs.push_back(make_pair(make_pair(i,j),coef));
+        }
+
+    void
+    svd()
+        {
+        M.ReDimension(int(rows.size()),int(cols.size()));
+        M = 0;
+        for(size_t n = 0; n < coefs.size(); ++n)
+            {
+            M(coefs[n].first.first+1,coefs[n].first.second+1) += coefs[n].second;
+            }
+        SVDgesdd(M,US,D,V);
+        }
+
+    void
+    truncate(Real smin)
+        {
+        nkeep = 0;
+        while(nkeep < D.Length() && D(nkeep+1) > smin) ++nkeep;
+        if(nkeep == 0) return;
+        if(nkeep == M.Ncols())
+            {
+            //Nothing to compress: keeping the right parts
+            //themselves as states leaves the MPO sparse
+            US = M;
+            V.ReDimension(nkeep,nkeep);
+            V = 0;
+            for(int k = 1; k <= nkeep; ++k) V(k,k) = 1;
+            return;
+            }
+        Matrix U(US);
+        US.ReDimension(U.Nrows(),nkeep);
+        for(int r = 1; r <= U.Nrows(); ++r)
+        for(int k = 1; k <= nkeep; ++k)
+            {
+            US(r,k) = U(r,k)*D(k);
+            }
+        Matrix VV(V);
+        V.ReDimension(nkeep,VV.Ncols());
+        for(int k = 1; k <= nkeep; ++k)
+        for(int c = 1; c <= VV.Ncols(); ++c)
+            {
+            V(k,c) = VV(k,c);
+            }
+        }
+    };
+
+struct Bond
+    {
+    vector<BondBlock> blocks;
+    map<QN,int> block_ind;
+
+    BondBlock&
+    block(const QN& q)
+        {
+        map<QN,int>::const_iterator it = block_ind.find(q);
+        if(it != block_ind.end()) return blocks[it->second];
+        block_ind[q] = int(blocks.size());
+        blocks.push_back(BondBlock());
+        blocks.back().q = q;
+        return blocks.back();
+        }
+    };
+
+typedef std::pair<string,std::pair<int,int> >
+WKey;
+
+//Finds the sector s and the position i within it
+//of the state at position p of the IQIndex I
+void static
+locate(const IQIndex& I, int p, int& s, int& i)
+    {
+    for(s = 1; s <= I.nindex(); ++s)
+        {
+        const int m = I.index(s).m();
+        if(p <= m)
+            {
+            i = p;
+            return;
+            }
+        p -= m;
+        }
+    Error("AutoMPO: link state out of range");
+    }
+
+IQMPO AutoMPO::
+toIQMPO(const OptSet& opts) const
+    {
+    if(!bad_term_.empty()) Error(bad_term_);
+
+    const SiteSet& sites = *sites_;
+    const int N = sites.N();
+    const Real cutoff = opts.getReal("Cutoff",1E-13);
+
+    //States common to all links
+    const int end = 1,
+              start = 2;
+
+    SiteOpCache cache(sites);
+
+    vector<HTerm> terms;
+    terms.reserve(terms_.size());
+    Foreach(const HTerm& t, terms_)
+        {
+        if(t.coef == 0) continue;
+        terms.push_back(siteOrder(t,N));
+        if(cache.flux(terms.back().ops) != QN())
+            {
+            Error("AutoMPO: term does not conserve quantum numbers");
+            }
+        }
+
+    //Coefficient matrices of the bonds
+    //(bonds[b] is between sites b and b+1)
+    vector<Bond> bonds(N);
+    Foreach(const HTerm& t, terms)
+        {
+        const SiteTermProd& ops = t.ops;
+        for(size_t s = 1; s < ops.size(); ++s)
+            {
+            const SiteTermProd l(ops.begin(),ops.begin()+s),
+                               r(ops.begin()+s,ops.end());
+            const QN q = cache.flux(r);
+            for(int b = ops[s-1].i; b < ops[s].i; ++b)
+                {
+                bonds.at(b).block(q).add(l,r,t.coef);
+                }
+            }
+        }
+
+    //Compress each bond, and make the link indices
+    vector<IQIndex> links(N+1);
+    for(int b = 0; b <= N; ++b)
+        {
+        Real smax = 0;
+        if(b >= 1 && b < N)
+            {
+            Foreach(BondBlock& B, bonds[b].blocks)
+                {
+                B.svd();
+                if(B.D.Length() > 0) smax = std::max(smax,B.D(1));
+                }
+            }
+
+        vector<IndexQN> iq;
+        int m0 = 2;
+        if(b >= 1 && b < N)
+            {
+            Foreach(BondBlock& B, bonds[b].blocks)
+                {
+                B.truncate(cutoff*smax);
+                if(B.q == QN())
+                    {
+                    B.offset = 3;
+                    m0 += B.nkeep;
+                    }
+                }
+            }
+        iq.push_back(IndexQN(Index(format("hl%d_0",b),m0),QN()));
+        int pos = m0+1;
+        if(b >= 1 && b < N)
+            {
+            Foreach(BondBlock& B, bonds[b].blocks)
+                {
+                if(B.q == QN() || B.nkeep == 0) continue;
+                B.offset = pos;
+                pos += B.nkeep;
+                iq.push_back(IndexQN(Index(format("hl%d_%d",b,int(iq.size())),B.nkeep),B.q));
+                }
+            }
+        links.at(b) = IQIndex(format("Hl%d",b),iq,Out);
+        }
+
+    IQMPO H(sites);
+
+    for(int n = 1; n <= N; ++n)
+        {
+        map<WKey,Real> w;
+
+        w[WKey("Id",make_pair(end,end))] += 1;
+        w[WKey("Id",make_pair(start,start))] += 1;
+
+        //Terms acting only on site n
+        Foreach(const HTerm& t, terms)
+            {
+            if(t.ops.size() == 1 && t.ops.front().i == n)
+                {
+                w[WKey(t.ops.front().op,make_pair(start,end))] += t.coef;
+                }
+            }
+
+        //Terms starting on site n
+        if(n < N)
+            {
+            Foreach(const BondBlock& B, bonds[n].blocks)
+            for(size_t l = 0; l < B.rows.size(); ++l)
+                {
+                const SiteTermProd& lp = B.rows[l];
+                if(lp.size() != 1 || lp.front().i != n) continue;
+                for(int k = 1; k <= B.nkeep; ++k)
+                    {
+                    w[WKey(lp.front().op,make_pair(start,B.offset+k-1))] += B.US(l+1,k);
+                    }
+                }
+            }
+
+        //Terms continuing from the left of site n
+        if(n > 1)
+            {
+            Foreach(const BondBlock& BL, bonds[n-1].blocks)
+            for(size_t r = 0; r < BL.cols.size(); ++r)
+                {
+                if(BL.nkeep == 0) continue;
+                const SiteTermProd& rp = BL.cols[r];
+                const bool here = (rp.front().i == n);
+                const string op = (here ? rp.front().op : string("Id"));
+                const SiteTermProd rest(rp.begin()+(here ? 1 : 0),rp.end());
+
+                if(rest.empty())
+                    {
+                    for(int kl = 1; kl <= BL.nkeep; ++kl)
+                        {
+                        w[WKey(op,make_pair(BL.offset+kl-1,end))] += BL.V(kl,r+1);
+                        }
+                    continue;
+                    }
+
+                const Bond& bond = bonds[n];
+                const BondBlock& BR = bond.blocks.at(bond.block_ind.find(cache.flux(rest))->second);
+                if(BR.nkeep == 0) continue;
+                const int c = BR.col_ind.find(rest)->second;
+                for(int kl = 1; kl <= BL.nkeep; ++kl)
+                for(int kr = 1; kr <= BR.nkeep; ++kr)
+                    {
+                    w[WKey(op,make_pair(BL.offset+kl-1,BR.offset+kr-1))] += BL.V(kl,r+1)*BR.V(kr,c+1);
+                    }
+                }
+            }
+
+        const IQIndex row = dag(links.at(n-1)),
+                      col = links.at(n);
+
+        IQTensor& W = H.Anc(n);
+        W = IQTensor(dag(sites.si(n)),sites.siP(n),row,col);
+
+        //Collect the coefficients of each operator
+        //into one block per pair of link sectors
+        map<WKey,ITensor> wblocks;
+        for(map<WKey,Real>::const_iterator it = w.begin(); it != w.end(); ++it)
+            {
+            if(std::fabs(it->second) < 1E-14) continue;
+            const WKey& k = it->first;
+            int rs = 0, ri = 0,
+                cs = 0, ci = 0;
+            locate(row,k.second.first,rs,ri);
+            locate(col,k.second.second,cs,ci);
+            const Index &ri_ = row.index(rs),
+                        &ci_ = col.index(cs);
+            ITensor& T = wblocks[WKey(k.first,make_pair(rs,cs))];
+            if(!T.valid()) T = ITensor(ri_,ci_);
+            T(ri_(ri),ci_(ci)) = it->second;
+            }
+
+        for(map<WKey,ITensor>::const_iterator it = wblocks.begin(); it != wblocks.end(); ++it)
+            {
+            IQTensor L(row,col);
+            L += it->second;
+            W += cache.op(SiteTerm(n,it->first.first)) * L;
+            }
+        }
+
+    H.Anc(1) *= IQTensor(links.at(0)(start));
+    H.Anc(N) *= IQTensor(dag(links.at(N))(end));
+
+    return H;
+    }
+
+std::ostream&
+operator<<(std::ostream& s, const AutoMPO& a)
+    {
+    s << "AutoMPO:\n";
+    Foreach(const AutoMPO::HTerm& t, a.terms())
+        {
+        s << format("  %.12f",t.coef);
+        Foreach(const AutoMPO::SiteTerm& st, t.ops)
+            {
+            s << format(" %s(%d)",st.op,st.i);
+            }
+        s << "\n";
+        }
+    return s;
+    }
+
+}; //namespace itensor
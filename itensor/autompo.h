@@ -0,0 +1,165 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_AUTOMPO_H
+#define __ITENSOR_AUTOMPO_H
+#include "mpo.h"
+
+namespace itensor {
+
+//
+// AutoMPO
+//
+// Builds the MPO of a sum of products of site operators
+// directly, instead of summing one product-operator MPO
+// (see HamBuilder) per term.
+//
+// Terms are added as a real coefficient followed by pairs of
+// operator names (as understood by SiteSet::op) and sites:
+//
+//   AutoMPO ampo(sites);
+//   for(int j = 1; j < N; ++j)
+//       {
+//       ampo += 0.5,"S+",j,"S-",j+1;
+//       ampo += 0.5,"S-",j,"S+",j+1;
+//       ampo +=     "Sz",j,"Sz",j+1;
+//       }
+//   IQMPO H = ampo;
+//
+// Operators within a term may be given in any site order
+// and several may act on the same site, in which case they
+// multiply in the order written (the rightmost acting first).
+// Operators whose name starts with 'C' ("C", "Cdag", "Cup",
+// "Cdagdn", ...) are taken to be fermionic: they anticommute
+// when the term is put in site order, and the Jordan-Wigner
+// string operator "F" is inserted automatically, so a term
+// such as "Cdag",i,"C",j needs no "F" operators for any i, j.
+// Each operator must carry a definite quantum number and
+// each term must conserve the total quantum numbers.
+//
+// The MPO is built as a finite state machine whose states at
+// each bond, besides the "start" and "end" (identity) states,
+// represent the parts of the terms to the right of the bond.
+// The matrix of coefficients connecting the left and right
+// parts of the terms crossing a bond is block diagonal in the
+// quantum number of the right parts; each block is compressed
+// with an SVD, keeping the singular values larger than the
+// option "Cutoff" (default 1E-13) times the largest one at
+// that bond. The resulting bond dimension is the minimal one
+// for the given terms (up to the cutoff), for example 5 for
+// the nearest-neighbor Heisenberg chain and 6 for the Hubbard
+// chain, and the MPO is exact up to the cutoff.
+//
+class AutoMPO
+    {
+    public:
+
+    struct SiteTerm
+        {
+        int i;
+        std::string op;
+
+        SiteTerm() : i(0) { }
+
+        SiteTerm(int i_, const std::string& op_) : i(i_), op(op_) { }
+        };
+
+    typedef std::vector<SiteTerm>
+    SiteTermProd;
+
+    struct HTerm
+        {
+        Real coef;
+        SiteTermProd ops;
+
+        HTerm() : coef(0) { }
+        };
+
+    //
+    // Helper returned by operator+= which collects
+    // the comma separated operator names and sites
+    // of a term and adds it when it goes out of scope
+    //
+    class Accumulator
+        {
+        public:
+
+        Accumulator(AutoMPO& ampo, Real coef);
+
+        Accumulator(AutoMPO& ampo, const std::string& op);
+
+        //Transfers the term being collected
+        Accumulator(const Accumulator& other);
+
+        ~Accumulator();
+
+        Accumulator&
+        operator,(const std::string& op);
+
+        Accumulator&
+        operator,(int i);
+
+        private:
+
+        AutoMPO* ampo_;
+        mutable bool active_;
+        bool bad_;
+        HTerm term_;
+        std::string op_;
+
+        void operator=(const Accumulator&);
+        };
+
+    AutoMPO(const SiteSet& sites);
+
+    const SiteSet&
+    sites() const { return *sites_; }
+
+    int
+    numTerms() const { return int(terms_.size()); }
+
+    const std::vector<HTerm>&
+    terms() const { return terms_; }
+
+    void
+    add(Real coef,
+        const std::string& op1, int i1,
+        const std::string& op2 = "", int i2 = 0,
+        const std::string& op3 = "", int i3 = 0,
+        const std::string& op4 = "", int i4 = 0);
+
+    Accumulator
+    operator+=(Real coef) { return Accumulator(*this,coef); }
+
+    Accumulator
+    operator+=(const std::string& op) { return Accumulator(*this,op); }
+
+    IQMPO
+    toIQMPO(const OptSet& opts = Global::opts()) const;
+
+    MPO
+    toMPO(const OptSet& opts = Global::opts()) const { return toIQMPO(opts).toMPO(); }
+
+    operator IQMPO() const { return toIQMPO(); }
+
+    operator MPO() const { return toMPO(); }
+
+    private:
+
+    const SiteSet* sites_;
+    std::vector<HTerm> terms_;
+    std::string bad_term_;
+
+    void
+    addTerm(const HTerm& t);
+
+    friend class Accumulator;
+    };
+
+std::ostream&
+operator<<(std::ostream& s, const AutoMPO& a);
+
+}; //namespace itensor
+
+#endif
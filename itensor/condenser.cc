@@ -41,8 +41,8 @@ dag()
 void Condenser::
 init(const std::string& smallind_name)
     {
-    static std::vector<QN> qns(10);
-    qns.resize(0);
+    std::vector<QN> qns;
+    qns.reserve(bigind_.nindex());
     Foreach(const IndexQN& x, bigind_.indices()) 
         qns.push_back(x.qn);
 
@@ -167,18 +167,13 @@ product(const IQTensor& t, IQTensor& res) const
                     break;
                     }
 
+            //Copy each sector of sind out of b
             for(int start = 0; start < sind.m(); )
                 {
                 const Index& bind = findBig(sind,start,maps_);
-                Matrix C(sind.m(),bind.m()); 
-                C = 0;
-                for(int kk = 1; kk <= bind.m(); ++kk) 
-                    { 
-                    C(start+kk,kk) = 1; 
-                    }
-                ITensor converter(sind,bind,C);
-                converter *= b;
-                res += converter;
+                ITensor piece(b);
+                piece.sliceIndex(sind,bind,start);
+                res += piece;
                 start += bind.m();
                 }
             }
@@ -195,7 +190,12 @@ product(const IQTensor& t, IQTensor& res) const
 
         res = IQTensor(iqinds);
 
-        Foreach(ITensor tt, t.blocks())
+        //Blocks of t whose sectors of bigind_ are
+        //condensed into the same sector of smallind_
+        //are copied into a single block
+        map<BlockKey,ITensor> nblocks;
+        array<Index,NMAX+1> group;
+        Foreach(const ITensor& tt, t.blocks())
             {
             bool gotit = false;
 
@@ -203,8 +203,15 @@ product(const IQTensor& t, IQTensor& res) const
                 if(hasindex(bigind_,K))
                     {
                     const IndexMap& m = findSmall(K,maps_);
-                    tt.expandIndex(K,m.small,m.i);
-                    res += tt;
+                    IndexSet<Index> nis;
+                    Foreach(const Index& I, tt.indices())
+                        {
+                        nis.addindex(I == K ? m.small : I);
+                        }
+                    ITensor& nb = nblocks[BlockKey(nis)];
+                    if(!nb) nb = ITensor(nis);
+                    group[1] = K;
+                    nb.embed(tt,group,1,m.small,m.i);
                     gotit = true;
                     break;
                     }
@@ -216,6 +223,12 @@ product(const IQTensor& t, IQTensor& res) const
                 Error("Combiner::product: Can't find common Index");
                 }
             }
+
+        for(map<BlockKey,ITensor>::const_iterator it = nblocks.begin();
+            it != nblocks.end(); ++it)
+            {
+            res += it->second;
+            }
         }
     }
 
@@ -0,0 +1,233 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "contract.h"
+#include <map>
+#include <list>
+
+namespace itensor {
+
+using std::vector;
+using std::map;
+
+//Above this many tensors, contract left to right
+//instead of searching all orders
+static const int MaxPlanTensors = 10;
+
+int static
+logBucket(Real x)
+    {
+    return int(floor(log(x)/log(2.)+0.5));
+    }
+
+//
+// The cache key: for each tensor its density bucket and,
+// for each of its indices, the tensor it is shared with
+// (or -1) and a bucket of its dimension
+//
+vector<int> static
+netKey(const ContractNet& net, const vector<vector<int> >& owners)
+    {
+    vector<int> key;
+    const int N = net.inds.size();
+    key.push_back(N);
+    for(int n = 0; n < N; ++n)
+        {
+        key.push_back(net.inds[n].size());
+        key.push_back(logBucket(net.density[n]));
+        Foreach(int j, net.inds[n])
+            {
+            const vector<int>& o = owners[j];
+            key.push_back(o.size() == 1 ? -1 : (o[0] == n ? o[1] : o[0]));
+            key.push_back(logBucket(net.m[j]));
+            }
+        }
+    return key;
+    }
+
+//Appends the steps contracting the tensors in
+//subset S to plan, returning where the result is
+int static
+addSteps(int S, const vector<int>& split, ContractPlan& plan)
+    {
+    if((S & (S-1)) == 0)
+        {
+        int n = 0;
+        while(!(S & (1 << n))) ++n;
+        return n;
+        }
+    const int a = addSteps(split[S],split,plan),
+              b = addSteps(S ^ split[S],split,plan);
+    plan.first.push_back(a);
+    plan.second.push_back(b);
+    return a;
+    }
+
+ContractPlan static
+findPlan(const ContractNet& net, const vector<vector<int> >& owners)
+    {
+    const int N = net.inds.size();
+    const int nind = net.m.size();
+
+    ContractPlan plan;
+    if(N > MaxPlanTensors)
+        {
+        for(int n = 1; n < N; ++n)
+            {
+            plan.first.push_back(0);
+            plan.second.push_back(n);
+            }
+        plan.result = 0;
+        return plan;
+        }
+
+    //For each subset S of the tensors (bit n set if
+    //tensor n is in S) find the indices left over
+    //after contracting S, its density, and the
+    //cheapest way to contract it
+    const int NS = 1 << N;
+    vector<vector<char> > open(NS,vector<char>(nind,0));
+    vector<Real> density(NS,0),
+                 cost(NS,0);
+    vector<int> split(NS,0);
+    for(int S = 1; S < NS; ++S)
+        {
+        for(int j = 0; j < nind; ++j)
+            {
+            int nin = 0;
+            Foreach(int n, owners[j])
+                {
+                if(S & (1 << n)) ++nin;
+                }
+            open[S][j] = (nin == 1);
+            }
+        for(int n = 0; n < N; ++n)
+            {
+            if(S & (1 << n)) density[S] = std::max(density[S],net.density[n]);
+            }
+
+        if((S & (S-1)) == 0) continue;
+
+        //Each split {A,S^A} is tried once, with
+        //A holding the lowest tensor in S
+        const int low = S & (-S);
+        bool found = false;
+        for(int A = (S-1) & S; A > 0; A = (A-1) & S)
+            {
+            if(!(A & low)) continue;
+            const int B = S ^ A;
+            Real c = density[A]*density[B];
+            for(int j = 0; j < nind; ++j)
+                {
+                if(open[A][j] || open[B][j]) c *= net.m[j];
+                }
+            c += cost[A] + cost[B];
+            if(!found || c < cost[S])
+                {
+                cost[S] = c;
+                split[S] = A;
+                found = true;
+                }
+            }
+        }
+
+    plan.result = addSteps(NS-1,split,plan);
+    return plan;
+    }
+
+ContractPlan
+contractPlan(const ContractNet& net)
+    {
+    vector<vector<int> > owners(net.m.size());
+    for(size_t n = 0; n < net.inds.size(); ++n)
+        {
+        Foreach(int j, net.inds[n])
+            {
+            owners.at(j).push_back(n);
+            if(owners[j].size() > 2) Error("contract: index appears on more than two tensors");
+            }
+        }
+
+    const vector<int> key = netKey(net,owners);
+
+    //Keys of the cached plans, most recently used first
+    typedef std::list<vector<int> > KeyList;
+    struct CachedPlan
+        {
+        ContractPlan plan;
+        KeyList::iterator pos;
+        };
+    typedef map<vector<int>,CachedPlan> PlanCache;
+    static PlanCache cache;
+    static KeyList recent;
+
+    ContractPlan plan;
+    bool cached = false;
+#ifdef _OPENMP
+#pragma omp critical(itensor_contractPlan)
+#endif
+    {
+    PlanCache::iterator it = cache.find(key);
+    if(it != cache.end())
+        {
+        plan = it->second.plan;
+        recent.splice(recent.begin(),recent,it->second.pos);
+        cached = true;
+        ++contractStats().ncached;
+        }
+    }
+    if(cached) return plan;
+
+    plan = findPlan(net,owners);
+
+#ifdef _OPENMP
+#pragma omp critical(itensor_contractPlan)
+#endif
+    {
+    //Another thread may have added key meanwhile
+    if(cache.count(key) == 0)
+        {
+        recent.push_front(key);
+        CachedPlan& c = cache[key];
+        c.plan = plan;
+        c.pos = recent.begin();
+        if(int(cache.size()) > MaxCachedPlans)
+            {
+            cache.erase(recent.back());
+            recent.pop_back();
+            }
+        }
+    ++contractStats().nplanned;
+    }
+    return plan;
+    }
+
+ContractStats&
+contractStats()
+    {
+    static ContractStats stats_;
+    return stats_;
+    }
+
+void
+resetContractStats() { contractStats() = ContractStats(); }
+
+Real
+contractDensity(const IQTensor& T)
+    {
+    Real dense = 1;
+    Foreach(const IQIndex& I, T.indices()) dense *= I.m();
+    Real nnz = 0;
+    Foreach(const ITensor& t, T.blocks())
+        {
+        Real bsize = 1;
+        Foreach(const Index& i, t.indices()) bsize *= i.m();
+        nnz += bsize;
+        }
+    //Count an IQTensor with no blocks as having
+    //one element so its density is not zero
+    return std::min(1.,std::max(1.,nnz)/dense);
+    }
+
+}; //namespace itensor
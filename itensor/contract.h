@@ -0,0 +1,200 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_CONTRACT_H
+#define __ITENSOR_CONTRACT_H
+#include "iqtensor.h"
+
+namespace itensor {
+
+//
+// Multi-tensor contraction.
+//
+// contract(ts) returns the product of all the tensors in ts,
+// multiplying them pairwise in the order estimated to need the
+// fewest floating point operations instead of left to right.
+// Default-constructed (null) tensors in ts are skipped, so
+// optional edge tensors may be passed directly.
+//
+// Each index may appear on at most two of the tensors.
+//
+// The cost of multiplying tensors A and B is estimated as
+// the product of the dimensions of all the indices of A and B
+// (each counted once) times the fraction of the elements of A
+// and of B which can be non-zero; for an IQTensor this fraction
+// is the size of its blocks over its dense size, and the product
+// of two tensors is taken to be as dense as the denser of the two.
+//
+// The order found is cached: a later call with tensors connected
+// in the same way, and with index dimensions (and IQTensor
+// densities) within a factor of about two, reuses it.
+// At most MaxCachedPlans orders are kept, dropping the
+// least recently used one beyond that.
+//
+
+static const int MaxCachedPlans = 256;
+
+template <class Tensor>
+Tensor
+contract(const std::vector<Tensor>& ts);
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C);
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C,
+         const Tensor& D);
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C,
+         const Tensor& D, const Tensor& E);
+
+//
+// Description of a tensor network used to
+// choose the order of a contraction
+//
+struct ContractNet
+    {
+    //Dimension of each distinct index
+    std::vector<Real> m;
+    //Positions (in m) of the indices of each tensor
+    std::vector<std::vector<int> > inds;
+    //Fraction of the elements of each
+    //tensor which can be non-zero
+    std::vector<Real> density;
+    };
+
+//
+// Contraction order: step j replaces tensor first[j] by its
+// product with tensor second[j]. The result ends up in
+// tensor number result.
+//
+struct ContractPlan
+    {
+    std::vector<int> first,
+                     second;
+    int result;
+
+    ContractPlan() : result(0) { }
+    };
+
+ContractPlan
+contractPlan(const ContractNet& net);
+
+//
+// Number of contraction orders found by contractPlan
+// and number taken from its cache
+//
+struct ContractStats
+    {
+    int nplanned,
+        ncached;
+
+    ContractStats()
+        :
+        nplanned(0),
+        ncached(0)
+        { }
+    };
+
+ContractStats&
+contractStats();
+
+void
+resetContractStats();
+
+Real inline
+contractDensity(const ITensor& T) { return 1; }
+
+Real
+contractDensity(const IQTensor& T);
+
+
+//
+//
+// Implementations
+//
+
+template <class Tensor>
+Tensor
+contract(const std::vector<Tensor>& ts)
+    {
+    typedef typename Tensor::IndexT
+    IndexT;
+
+    std::vector<Tensor> T;
+    T.reserve(ts.size());
+    Foreach(const Tensor& t, ts)
+        {
+        if(t) T.push_back(t);
+        }
+    if(T.empty()) Error("contract: all tensors are null");
+    if(T.size() == 1) return T.front();
+    if(T.size() == 2) return T.front()*T.back();
+
+    ContractNet net;
+    std::vector<IndexT> all;
+    net.inds.resize(T.size());
+    net.density.resize(T.size());
+    for(size_t n = 0; n < T.size(); ++n)
+        {
+        Foreach(const IndexT& I, T[n].indices())
+            {
+            size_t j = 0;
+            while(j < all.size() && !(all[j] == I)) ++j;
+            if(j == all.size())
+                {
+                all.push_back(I);
+                net.m.push_back(I.m());
+                }
+            net.inds[n].push_back(j);
+            }
+        net.density[n] = contractDensity(T[n]);
+        }
+
+    const ContractPlan plan = contractPlan(net);
+
+    for(size_t s = 0; s < plan.first.size(); ++s)
+        {
+        T.at(plan.first[s]) *= T.at(plan.second[s]);
+        T.at(plan.second[s]) = Tensor();
+        }
+    return T.at(plan.result);
+    }
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C)
+    {
+    std::vector<Tensor> ts(3);
+    ts[0] = A; ts[1] = B; ts[2] = C;
+    return contract(ts);
+    }
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C,
+         const Tensor& D)
+    {
+    std::vector<Tensor> ts(4);
+    ts[0] = A; ts[1] = B; ts[2] = C; ts[3] = D;
+    return contract(ts);
+    }
+
+template <class Tensor>
+Tensor
+contract(const Tensor& A, const Tensor& B, const Tensor& C,
+         const Tensor& D, const Tensor& E)
+    {
+    std::vector<Tensor> ts(5);
+    ts[0] = A; ts[1] = B; ts[2] = C; ts[3] = D; ts[4] = E;
+    return contract(ts);
+    }
+
+}; //namespace itensor
+
+#endif
@@ -0,0 +1,169 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_CORRELATION_H
+#define __ITENSOR_CORRELATION_H
+
+#include "mps.h"
+
+namespace itensor {
+
+//
+// Two-point correlation functions.
+//
+// correlationMatrix(psi,"A","B") returns the N x N Matrix C with
+//
+//   C(i,j) = <psi| A_i B_j |psi> / <psi|psi>
+//
+// where A_i is the operator "A" of psi.sites() at site i.
+// For i != j the two operators are applied in site order, with
+// the operator named by the option "String" (if given) on every
+// site strictly between them:
+//
+//   C(i,j) = <A_i S_{i+1} ... S_{j-1} B_j>   (i < j)
+//   C(i,j) = <B_j S_{j+1} ... S_{i-1} A_i>   (i > j)
+//
+// The diagonal is <(A*B)_i>. For a fermionic site set, using
+// the bare operators with String="F" gives the Jordan-Wigner
+// strings, for example
+//
+//   correlationMatrix(psi,"Cdag","C",Opt("String","F"))
+//
+// returns <c^dag_i c_j> for all i and j.
+//
+// Only the real part of each correlator is kept.
+//
+// With psi right-orthogonalized, the left environments of
+// psi with itself are computed once; each site i then starts
+// from its environment with A_i (and with B_i) inserted and
+// sweeps right, closing off with B_j (with A_j) at every j > i.
+// The whole matrix therefore costs O(N^2) site contractions
+// instead of O(N^3) for a full chain contraction per pair.
+// The sweeps from different sites i run in parallel when
+// compiled with OpenMP.
+//
+
+template <class Tensor>
+Matrix
+correlationMatrix(const MPSt<Tensor>& psi,
+                  const std::string& opA,
+                  const std::string& opB,
+                  const OptSet& opts = Global::opts());
+
+//
+// Implementations
+//
+
+//Returns the real part of the expectation value of
+//the (site-primed) operator product in T
+//against the bra tensor A at site j
+template <class Tensor>
+Real
+closeCorrelator(const Tensor& T,
+                const Tensor& A,
+                const typename Tensor::IndexT& rl)
+    {
+    if(rl) return BraKet(prime(A),prime(T,rl)).real();
+    return BraKet(prime(A),T).real();
+    }
+
+template <class Tensor>
+Matrix
+correlationMatrix(const MPSt<Tensor>& psi_,
+                  const std::string& opA,
+                  const std::string& opB,
+                  const OptSet& opts)
+    {
+    typedef typename Tensor::IndexT
+    IndexT;
+
+    const std::string sname = opts.getString("String","");
+    const bool dostring = (sname != "");
+
+    MPSt<Tensor> psi(psi_);
+    psi.position(1);
+    psi.normalize();
+
+    const int N = psi.N();
+    const SiteSet& sites = psi.sites();
+
+    //Site tensors of psi are copied out first
+    //since psi.A(j) is not safe to call from
+    //several threads
+    std::vector<Tensor> M(N+1),
+                        A(N+1),
+                        B(N+1),
+                        AB(N+1),
+                        S(N+1);
+    std::vector<IndexT> rl(N+1);
+    for(int j = 1; j <= N; ++j)
+        {
+        M[j] = psi.A(j);
+        A[j] = sites.op(opA,j);
+        B[j] = sites.op(opB,j);
+        AB[j] = multSiteOps(A[j],B[j]);
+        if(dostring) S[j] = sites.op(sname,j);
+        if(j < N) rl[j] = linkInd(psi,j);
+        }
+
+    //Left environments: E[i] is psi contracted
+    //with itself over sites 1,...,i-1 (null for i = 1)
+    //with the bra links primed
+    std::vector<Tensor> E(N+1);
+    for(int i = 2; i <= N; ++i)
+        {
+        E[i] = (E[i-1] ? E[i-1]*M[i-1] : M[i-1]);
+        E[i] *= dag(prime(M[i-1],Link));
+        }
+
+    Matrix C(N,N);
+    C = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i = 1; i <= N; ++i)
+        {
+        const Tensor& Ai = M[i];
+        const Tensor Ki = (E[i] ? E[i]*Ai : Ai);
+
+        C(i,i) = closeCorrelator(Ki*AB[i],Ai,rl[i]);
+        if(i == N) continue;
+
+        //LA carries A_i, LB carries B_i
+        Tensor LA = Ki*A[i],
+               LB = Ki*B[i];
+        LA *= dag(prime(Ai));
+        LB *= dag(prime(Ai));
+
+        for(int j = i+1; j <= N; ++j)
+            {
+            const Tensor& Aj = M[j];
+            LA *= Aj;
+            LB *= Aj;
+            C(i,j) = closeCorrelator(LA*B[j],Aj,rl[j]);
+            C(j,i) = closeCorrelator(LB*A[j],Aj,rl[j]);
+            if(j == N) break;
+            if(dostring)
+                {
+                LA *= S[j];
+                LB *= S[j];
+                LA *= dag(prime(Aj));
+                LB *= dag(prime(Aj));
+                }
+            else
+                {
+                LA *= dag(prime(Aj,Link));
+                LB *= dag(prime(Aj,Link));
+                }
+            }
+        }
+
+    return C;
+    }
+
+}; //namespace itensor
+
+
+#endif
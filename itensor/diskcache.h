@@ -0,0 +1,460 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_DISKCACHE_H
+#define __ITENSOR_DISKCACHE_H
+
+#include "global.h"
+#include <map>
+#include <deque>
+#include <pthread.h>
+
+namespace itensor {
+
+//
+// Counters for the disk traffic of a DiskCache.
+//
+// stall_time is the wall time (in seconds) the calling
+// thread spent waiting for disk reads or writes.
+//
+struct DiskStats
+    {
+    int nwrite,   //number of tensors written
+        nread,    //number of tensors requested by get
+        nhit,     //of these, number already in memory
+        nstall;   //of these, number which had to wait
+    Real stall_time;
+
+    DiskStats()
+        :
+        nwrite(0),
+        nread(0),
+        nhit(0),
+        nstall(0),
+        stall_time(0)
+        { }
+    };
+
+//
+// The DiskCache class stores tensors in files.
+//
+// If async is true (the default), put returns immediately
+// and the file is written by a background thread; until it is
+// written the tensor stays in memory and get returns it
+// directly. prefetch starts reading a file in the background
+// so that a later call to get need not wait for the disk.
+//
+// Since the background thread does all jobs in order,
+// a file is always read after any earlier writes to it.
+//
+// If async is false, put and get write and read the file
+// in the calling thread.
+//
+// A background read or write which fails is reported by
+// throwing an ITError from the next call to get for that
+// file, and a failed write also from the next call to flush.
+//
+
+template <class Tensor>
+class DiskCache
+    {
+    public:
+
+    DiskCache(bool async = true);
+
+    ~DiskCache();
+
+    //Write T to the file fname
+    void
+    put(const std::string& fname, const Tensor& T);
+
+    //Start reading the file fname
+    void
+    prefetch(const std::string& fname);
+
+    //Set T to the tensor last put to fname,
+    //waiting for it to be read if necessary
+    void
+    get(const std::string& fname, Tensor& T);
+
+    //Wait for all pending writes to finish
+    //(throws an ITError if any of them failed)
+    void
+    flush();
+
+    bool
+    async() const { return async_; }
+
+    const DiskStats&
+    stats() const { return stats_; }
+
+    void
+    resetStats() { stats_ = DiskStats(); }
+
+    private:
+
+    enum State { Writing, Reading, Loaded, Missing, Failed };
+
+    struct Entry
+        {
+        State state;
+        Tensor T;
+        int version;
+        std::string error; //if state == Failed
+        };
+
+    struct Job
+        {
+        std::string fname;
+        bool write;
+        Tensor T;
+        int version;
+        };
+
+    /////////////////
+    //
+    // Data Members
+    //
+
+    bool async_;
+    bool started_,
+         done_;
+    int version_;
+
+    //Tensors being written, read, or read and not yet taken by get
+    std::map<std::string,Entry> entries_;
+    //Number of queued or running writes for each file
+    std::map<std::string,int> nwriting_;
+    std::deque<Job> jobs_;
+    //First background write failure not yet reported by flush
+    std::string write_error_;
+
+    pthread_t thread_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t cond_;
+
+    DiskStats stats_;
+
+    //
+    /////////////////
+
+    void
+    start();
+
+    void
+    run();
+
+    static void*
+    runThread(void* arg)
+        {
+        static_cast<DiskCache*>(arg)->run();
+        return 0;
+        }
+
+    //Waits on cond_, adding the time waited to stats_
+    void
+    stallWait();
+
+    //Does job j (in the background thread, with mutex_
+    //unlocked), returning an error message if it fails
+    std::string
+    doJob(Job& j, bool& found);
+
+    //Not copyable
+    DiskCache(const DiskCache&);
+    void operator=(const DiskCache&);
+
+    };
+
+template <class Tensor>
+inline DiskCache<Tensor>::
+DiskCache(bool async)
+    :
+    async_(async),
+    started_(false),
+    done_(false),
+    version_(0)
+    {
+    pthread_mutex_init(&mutex_,0);
+    pthread_cond_init(&cond_,0);
+    }
+
+template <class Tensor>
+inline DiskCache<Tensor>::
+~DiskCache()
+    {
+    if(started_)
+        {
+        pthread_mutex_lock(&mutex_);
+        done_ = true;
+        pthread_cond_broadcast(&cond_);
+        pthread_mutex_unlock(&mutex_);
+        pthread_join(thread_,0);
+        }
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+start()
+    {
+    if(started_) return;
+    if(pthread_create(&thread_,0,&DiskCache::runThread,this) != 0)
+        {
+        Error("DiskCache: could not start I/O thread");
+        }
+    started_ = true;
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+put(const std::string& fname, const Tensor& T)
+    {
+    ++stats_.nwrite;
+    if(!async_)
+        {
+        const Real t0 = wallTime();
+        writeToFile(fname,T);
+        stats_.stall_time += wallTime()-t0;
+        return;
+        }
+
+    start();
+
+    pthread_mutex_lock(&mutex_);
+    //Supersedes any earlier entry (e.g. a prefetch)
+    Entry& e = entries_[fname];
+    e.state = Writing;
+    e.T = T;
+    e.version = ++version_;
+
+    Job j;
+    j.fname = fname;
+    j.write = true;
+    j.T = T;
+    j.version = e.version;
+    jobs_.push_back(j);
+    ++nwriting_[fname];
+
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+prefetch(const std::string& fname)
+    {
+    if(!async_) return;
+
+    start();
+
+    pthread_mutex_lock(&mutex_);
+    if(entries_.count(fname) == 0)
+        {
+        Entry& e = entries_[fname];
+        e.state = Reading;
+        e.version = ++version_;
+
+        Job j;
+        j.fname = fname;
+        j.write = false;
+        j.version = e.version;
+        jobs_.push_back(j);
+
+        pthread_cond_broadcast(&cond_);
+        }
+    pthread_mutex_unlock(&mutex_);
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+get(const std::string& fname, Tensor& T)
+    {
+    ++stats_.nread;
+    if(!async_)
+        {
+        const Real t0 = wallTime();
+        readFromFile(fname,T);
+        stats_.stall_time += wallTime()-t0;
+        ++stats_.nstall;
+        return;
+        }
+
+    pthread_mutex_lock(&mutex_);
+
+    typename std::map<std::string,Entry>::iterator it = entries_.find(fname);
+
+    if(it == entries_.end())
+        {
+        //Not in memory: make sure no write to
+        //fname is pending then read it here
+        ++stats_.nstall;
+        while(nwriting_[fname] > 0) stallWait();
+        pthread_mutex_unlock(&mutex_);
+
+        const Real t0 = wallTime();
+        readFromFile(fname,T);
+        stats_.stall_time += wallTime()-t0;
+        return;
+        }
+
+    if(it->second.state == Reading)
+        {
+        ++stats_.nstall;
+        while(it->second.state == Reading) stallWait();
+        }
+    else
+        {
+        ++stats_.nhit;
+        }
+
+    if(it->second.state == Missing)
+        {
+        pthread_mutex_unlock(&mutex_);
+        Error("Couldn't open file \"" + fname + "\" for reading");
+        }
+
+    if(it->second.state == Failed)
+        {
+        const std::string error = it->second.error;
+        entries_.erase(it);
+        pthread_mutex_unlock(&mutex_);
+        throw ITError(error);
+        }
+
+    T = it->second.T;
+    entries_.erase(it);
+
+    pthread_mutex_unlock(&mutex_);
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+flush()
+    {
+    if(!started_) return;
+    pthread_mutex_lock(&mutex_);
+    while(!jobs_.empty()) stallWait();
+    //Wait for the last job to finish too
+    typename std::map<std::string,int>::const_iterator it = nwriting_.begin();
+    for(; it != nwriting_.end(); ++it)
+        {
+        while(it->second > 0) stallWait();
+        }
+    const std::string error = write_error_;
+    write_error_.clear();
+    pthread_mutex_unlock(&mutex_);
+    if(!error.empty()) throw ITError(error);
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+stallWait()
+    {
+    const Real t0 = wallTime();
+    pthread_cond_wait(&cond_,&mutex_);
+    stats_.stall_time += wallTime()-t0;
+    }
+
+template <class Tensor>
+std::string inline DiskCache<Tensor>::
+doJob(Job& j, bool& found)
+    {
+    //Errors must not escape the background thread, where
+    //an exception would terminate the program
+    try {
+        if(j.write)
+            {
+            if(!tryWriteToFile(j.fname,j.T))
+                return "DiskCache: couldn't write file \"" + j.fname + "\"";
+            }
+        else
+            {
+            found = fileExists(j.fname);
+            if(found) readFromFile(j.fname,j.T);
+            }
+        }
+    catch(const ITError& e)
+        {
+        return "DiskCache: error accessing file \"" + j.fname + "\": " + e.what();
+        }
+    catch(const std::exception& e)
+        {
+        return "DiskCache: error accessing file \"" + j.fname + "\": " + e.what();
+        }
+    return "";
+    }
+
+template <class Tensor>
+void inline DiskCache<Tensor>::
+run()
+    {
+    pthread_mutex_lock(&mutex_);
+    while(true)
+        {
+        while(jobs_.empty() && !done_) pthread_cond_wait(&cond_,&mutex_);
+        if(jobs_.empty()) break;
+
+        Job j = jobs_.front();
+        jobs_.pop_front();
+
+        if(j.write)
+            {
+            pthread_mutex_unlock(&mutex_);
+            bool found = true;
+            const std::string error = doJob(j,found);
+            j.T = Tensor();
+            pthread_mutex_lock(&mutex_);
+
+            --nwriting_[j.fname];
+            if(!error.empty() && write_error_.empty()) write_error_ = error;
+            //Once written, drop the in-memory copy
+            //unless it has been superseded or taken
+            typename std::map<std::string,Entry>::iterator it = entries_.find(j.fname);
+            if(it != entries_.end() && it->second.version == j.version)
+                {
+                if(error.empty())
+                    {
+                    entries_.erase(it);
+                    }
+                else
+                    {
+                    it->second.state = Failed;
+                    it->second.T = Tensor();
+                    it->second.error = error;
+                    }
+                }
+            }
+        else
+            {
+            //Skip reads superseded by a put or already taken
+            typename std::map<std::string,Entry>::iterator it = entries_.find(j.fname);
+            if(it == entries_.end() || it->second.version != j.version)
+                {
+                continue;
+                }
+            pthread_mutex_unlock(&mutex_);
+
+            bool found = false;
+            const std::string error = doJob(j,found);
+
+            pthread_mutex_lock(&mutex_);
+            it = entries_.find(j.fname);
+            if(it != entries_.end() && it->second.version == j.version)
+                {
+                it->second.T = j.T;
+                it->second.state = (!error.empty() ? Failed : (found ? Loaded : Missing));
+                it->second.error = error;
+                }
+            }
+
+        pthread_cond_broadcast(&cond_);
+        }
+    pthread_mutex_unlock(&mutex_);
+    }
+
+}; //namespace itensor
+
+#endif
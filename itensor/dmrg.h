@@ -171,6 +171,21 @@ dmrg(MPSt<Tensor>& psi,
 //
 // DMRGWorker
 //
+// Sweeps over the bonds of psi, optimizing the two-site
+// tensor at each bond. 
+//
+// If PH.numCenter() is 1 (for the dmrg functions above, if
+// the option "NumCenter" is 1) a single site is optimized at
+// each step instead, costing about a factor of d less per
+// Davidson step and per decomposition. Going right the site 
+// at the left of the bond is optimized, going left the one at
+// its right, and the orthogonality center is moved across the
+// bond with MPSt::svdSite, whose noise term expands the bond
+// basis with H acting on the site. The noise used is that of
+// sweeps if nonzero, otherwise the option "ExpandWeight" 
+// (default 1E-4); an ExpandWeight of 0 turns the expansion off, 
+// so that bond dimensions can no longer grow.
+//
 
 template <class Tensor, class LocalOpT>
 Real inline
@@ -196,6 +211,8 @@ DMRGWorker(MPSt<Tensor>& psi,
     const int debug_level = opts.getInt("DebugLevel",(quiet ? 0 : 1));
 
     const int N = psi.N();
+    const bool single_site = (PH.numCenter() == 1);
+    const Real expand_weight = opts.getReal("ExpandWeight",1E-4);
     Real energy = NAN;
 
     psi.position(1);
@@ -212,6 +229,11 @@ DMRGWorker(MPSt<Tensor>& psi,
         opts.add("Noise",sweeps.noise(sw));
         opts.add("MaxIter",sweeps.niter(sw));
 
+        if(single_site && sweeps.noise(sw) == 0)
+            {
+            opts.add("Noise",expand_weight);
+            }
+
         if(!PH.doWrite()
            && opts.defined("WriteM")
            && sweeps.maxm(sw) >= opts.getInt("WriteM"))
@@ -233,13 +255,31 @@ DMRGWorker(MPSt<Tensor>& psi,
                 printfln("Sweep=%d, HS=%d, Bond=(%d,%d)",sw,ha,b,(b+1));
                 }
 
-            PH.position(b,psi);
+            const Direction dir = (ha==1?Fromleft:Fromright);
+            Spectrum spec;
+
+            if(single_site)
+                {
+                const int j = (ha==1 ? b : b+1);
+
+                PH.position(j,psi);
+
+                Tensor phi = psi.A(j);
 
-            Tensor phi = psi.A(b)*psi.A(b+1);
+                energy = davidson(PH,phi,opts);
+
+                spec = psi.svdSite(j,phi,dir,PH,opts);
+                }
+            else
+                {
+                PH.position(b,psi);
 
-            energy = davidson(PH,phi,opts);
-            
-            Spectrum spec = psi.svdBond(b,phi,(ha==1?Fromleft:Fromright),PH,opts);
+                Tensor phi = psi.A(b)*psi.A(b+1);
+
+                energy = davidson(PH,phi,opts);
+                
+                spec = psi.svdBond(b,phi,dir,PH,opts);
+                }
 
             if(!quiet)
                 { 
@@ -262,6 +302,31 @@ DMRGWorker(MPSt<Tensor>& psi,
 
             } //for loop over b
 
+        if(PH.doWrite() && !quiet)
+            {
+            const DiskStats ds = PH.diskStats();
+            printfln("    Disk I/O: %d writes, %d reads (%d in memory), %d reads waited, stall time %.3f s",
+                     ds.nwrite,ds.nread,ds.nhit,ds.nstall,ds.stall_time);
+            PH.resetDiskStats();
+            }
+
+        if(!quiet && (opts.getString("EnvPrecision","Double") != "Double"
+                      || opts.getString("KrylovPrecision","Double") != "Double"))
+            {
+            const PackStats& ps = packStats();
+            printfln("    Packed storage: %d tensors packed, %.2f MB stored for %.2f MB, %d unpacked, max rel. error %.1E",
+                     ps.npack,ps.packed_bytes/1E6,ps.full_bytes/1E6,ps.nunpack,ps.max_err);
+            resetPackStats();
+            }
+
+        if(!quiet && opts.getString("EigenSolver","Davidson") == "BlockDavidson")
+            {
+            const DavidsonStats& ds = davidsonStats();
+            printfln("    Block Davidson: %d products in %d iterations, time product %.3f s, orthog %.3f s, subspace %.3f s",
+                     ds.nproduct,ds.niter,ds.product_time,ds.orthog_time,ds.subspace_time);
+            resetDavidsonStats();
+            }
+
         if(obs.checkDone(opts)) break;
     
         } //for loop over sw
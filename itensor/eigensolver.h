@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_EIGENSOLVER_H
 #define __ITENSOR_EIGENSOLVER_H
 #include "iqcombiner.h"
+#include "packedtensor.h"
 
 
 namespace itensor {
@@ -69,12 +70,81 @@ davidson(const BigMatrixT& A,
          std::vector<Tensor>& phi,
          const OptSet& opts = Global::opts());
 
+//
+// If the option "KrylovPrecision" is "Float" or "BFloat16",
+// all the Davidson vectors V and A*V but the latest ones are
+// kept as PackedTensors and unpacked one at a time when used.
+// The A*V's use the precision given; the V's use Float in
+// either case, since BFloat16 is not accurate enough to keep
+// them orthonormal.
+//
 template <class BigMatrixT, class Tensor> 
 std::vector<Complex>
 complexDavidson(const BigMatrixT& A, 
                 std::vector<Tensor>& phi,
                 const OptSet& opts = Global::opts());
 
+//
+// Block version of davidson for a Hermitian A: each iteration
+// adds the preconditioned residuals of the nblock lowest Ritz 
+// vectors to the subspace, where nblock is the larger of N and 
+// the option "BlockSize" (default 2). A is applied to all of 
+// them at once by blockProduct, and the inner products of the
+// Gram-Schmidt and subspace steps are computed in parallel 
+// (if compiled with OpenMP).
+// Used by davidson if the option "EigenSolver" is "BlockDavidson".
+//
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(const BigMatrixT& A, 
+              std::vector<Tensor>& phi,
+              const OptSet& opts = Global::opts());
+
+//
+// Sets phip[j] = A*phi[j]. Specialized for LocalOp and LocalMPO
+// to contract all the phi's at once; otherwise uses A.product.
+//
+template <class BigMatrixT, class Tensor> 
+void
+blockProduct(const BigMatrixT& A, 
+             const std::vector<Tensor>& phi,
+             std::vector<Tensor>& phip);
+
+//
+// Wall time (in seconds) spent by blockDavidson in each phase,
+// summed over calls (on all threads, updated atomically)
+// until reset by resetDavidsonStats()
+//
+struct DavidsonStats
+    {
+    int ncall,      //calls of blockDavidson
+        niter,      //iterations (subspace expansions)
+        nproduct;   //vectors multiplied by A
+    Real product_time,  //blockProduct
+         orthog_time,   //Gram-Schmidt
+         subspace_time; //subspace matrix, Ritz vectors and residuals
+
+    DavidsonStats()
+        :
+        ncall(0),
+        niter(0),
+        nproduct(0),
+        product_time(0),
+        orthog_time(0),
+        subspace_time(0)
+        { }
+    };
+
+DavidsonStats inline&
+davidsonStats()
+    {
+    static DavidsonStats stats_;
+    return stats_;
+    }
+
+void inline
+resetDavidsonStats() { davidsonStats() = DavidsonStats(); }
+
 //
 // Uses the Davidson algorithm to find the minimal
 // eigenvector of the generalized eigenvalue problem
@@ -482,6 +552,10 @@ davidson(const BigMatrixT& A,
          std::vector<Tensor>& phi,
          const OptSet& opts)
     {
+    if(opts.getString("EigenSolver","Davidson") == "BlockDavidson")
+        {
+        return blockDavidson(A,phi,opts);
+        }
     const int debug_level_ = opts.getInt("DebugLevel",-1);
     const Real Approx0 = 1E-12;
     std::vector<Complex> ceigs = complexDavidson(A,phi,opts);
@@ -500,6 +574,52 @@ davidson(const BigMatrixT& A,
 
 
 
+//Returns V[k], unpacking it into tmp
+//if it is stored as PV[k]
+template <class Tensor> 
+const Tensor&
+krylovVec(const std::vector<Tensor>& V, 
+          const std::vector<PackedTensor>& PV, 
+          int k, Tensor& tmp)
+    {
+    if(V.at(k) || PV.empty()) return V[k];
+    PV.at(k).unpack(tmp);
+    return tmp;
+    }
+
+//Sets res = sum_k c[k]*V[k] (k < c.size()),
+//with V[k] stored as PV[k] if V[k] is null
+template <class Tensor> 
+void
+krylovComb(const std::vector<Complex>& c,
+           const std::vector<Tensor>& V, 
+           const std::vector<PackedTensor>& PV, 
+           Tensor& res)
+    {
+    if(PV.empty())
+        {
+        linearComb(c,V,res);
+        return;
+        }
+    //Real coefficients are applied as Reals so that
+    //real V's give a real res
+    Tensor tmp;
+    for(size_t k = 0; k < c.size(); ++k)
+        {
+        const Tensor& Vk = krylovVec(V,PV,k,tmp);
+        if(k == 0)
+            {
+            if(c[k].imag() == 0) res = c[k].real()*Vk;
+            else                 res = c[k]*Vk;
+            }
+        else
+            {
+            if(c[k].imag() == 0) res += c[k].real()*Vk;
+            else                 res += c[k]*Vk;
+            }
+        }
+    }
+
 template <class BigMatrixT, class Tensor> 
 std::vector<Complex>
 complexDavidson(const BigMatrixT& A, 
@@ -511,6 +631,11 @@ complexDavidson(const BigMatrixT& A,
     const int debug_level_ = opts.getInt("DebugLevel",-1);
     const int miniter_ = opts.getInt("MinIter",1);
     const bool hermitian = opts.getBool("Hermitian",true);
+    //The basis V must stay orthonormal to good accuracy,
+    //so is kept in at least single precision; the AV's only
+    //enter the residuals and may use BFloat16
+    const Precision avprec = precisionFromString(opts.getString("KrylovPrecision","Double")),
+                    kprec = (avprec == BFloat16Prec ? FloatPrec : avprec);
 
     const Real Approx0 = 1E-12;
 
@@ -548,6 +673,21 @@ complexDavidson(const BigMatrixT& A,
     std::vector<Tensor> V(actual_maxiter+2),
                        AV(actual_maxiter+2);
 
+    //If packing, V[k] and AV[k] are stored as PV[k] and
+    //PAV[k] (and set to null) once no longer the latest.
+    //Each V[k] is rounded to the packed precision before
+    //A is applied to it, so that the subspace matrix and
+    //Ritz vectors are computed from the same vectors.
+    std::vector<PackedTensor> PV,
+                              PAV;
+    if(kprec != DoublePrec)
+        {
+        PV.resize(V.size());
+        PAV.resize(AV.size());
+        }
+    Tensor tmp,
+           tmp2;
+
     //Storage for Matrix that gets diagonalized 
     Matrix MR(actual_maxiter+2,actual_maxiter+2),
            MI(actual_maxiter+2,actual_maxiter+2);
@@ -566,6 +706,11 @@ complexDavidson(const BigMatrixT& A,
     Real qnorm = NAN;
 
     V[0] = phi.front();
+    if(!PV.empty())
+        {
+        PV[0] = PackedTensor(V[0],kprec);
+        PV[0].unpack(V[0]);
+        }
     A.product(V[0],AV[0]);
 
     Complex z = BraKet(V[0],AV[0]);
@@ -626,14 +771,13 @@ complexDavidson(const BigMatrixT& A,
                 //phi_t of A from the min evec of M
                 //(and start calculating residual q)
 
-                phi_t = (UR(1,1+w)*Complex_1+UI(1,1+w)*Complex_i)*V[0];
-                q   = (UR(1,1+w)*Complex_1+UI(1,1+w)*Complex_i)*AV[0];
-                for(int k = 1; k <= ii; ++k)
+                std::vector<Complex> cfac(ni);
+                for(int k = 0; k <= ii; ++k)
                     {
-                    const Complex cfac = (UR(k+1,1+w)*Complex_1+UI(k+1,1+w)*Complex_i);
-                    phi_t += cfac*V[k];
-                    q   += cfac*AV[k];
+                    cfac[k] = (UR(k+1,1+w)*Complex_1+UI(k+1,1+w)*Complex_i);
                     }
+                krylovComb(cfac,V,PV,phi_t);
+                krylovComb(cfac,AV,PAV,q);
                 }
             else
                 {
@@ -655,23 +799,13 @@ complexDavidson(const BigMatrixT& A,
                 //Compute corresponding eigenvector
                 //phi_t of A from the min evec of M
                 //(and start calculating residual q)
-                phi_t = UR(1,1+w)*V[0];
-                q   = UR(1,1+w)*AV[0];
-                for(int k = 1; k <= ii; ++k)
-                    {
-                    phi_t += UR(k+1,1+w)*V[k];
-                    q   += UR(k+1,1+w)*AV[k];
-                    }
-                if(complex_evec)
+                std::vector<Complex> cfac(ni);
+                for(int k = 0; k <= ii; ++k)
                     {
-                    phi_t += Complex_i*UI(1,1+w)*V[0];
-                    q   += Complex_i*UI(1,1+w)*AV[0];
-                    for(int k = 1; k <= ii; ++k)
-                        {
-                        phi_t += Complex_i*UI(k+1,1+w)*V[k];
-                        q   += Complex_i*UI(k+1,1+w)*AV[k];
-                        }
+                    cfac[k] = Complex(UR(k+1,1+w),(complex_evec ? UI(k+1,1+w) : 0.));
                     }
+                krylovComb(cfac,V,PV,phi_t);
+                krylovComb(cfac,AV,PAV,q);
                 }
 
             //lambda is the w^th eigenvalue of M
@@ -779,17 +913,26 @@ complexDavidson(const BigMatrixT& A,
         for(int pass = 1; pass <= Npass; ++pass)
             {
             ++count;
-            for(int k = 0; k < ni; ++k)
+            //Vq holds minus the overlaps of q with the V's
+            if(PV.empty())
                 {
-                Vq[k] = BraKet(V[k],q);
+                for(int k = 0; k < ni; ++k)
+                    {
+                    Vq[k] = -BraKet(V[k],q);
+                    }
+                multiAxpy(Vq,V,q);
                 }
-
-            for(int k = 0; k < ni; ++k)
+            else
                 {
-                q += (-Vq[k].real())*V[k];
-                if(Vq[k].imag() != 0)
+                //Rounding errors of the packed AV's leave q with
+                //components along the V's, so orthogonalize twice
+                for(int rep = 1; rep <= 2; ++rep)
+                for(int k = 0; k < ni; ++k)
                     {
-                    q += (-Vq[k].imag()*Complex_i)*V[k];
+                    const Tensor& Vk = krylovVec(V,PV,k,tmp);
+                    const Complex ov = -BraKet(Vk,q);
+                    if(ov.imag() == 0) q += ov.real()*Vk;
+                    else               q += ov*Vk;
                     }
                 }
 
@@ -842,6 +985,11 @@ complexDavidson(const BigMatrixT& A,
         //Step G of Davidson (1975)
         //Expand AV and M
         //for next step
+        if(!PV.empty())
+            {
+            PV.at(ni) = PackedTensor(V[ni],kprec);
+            PV[ni].unpack(V[ni]);
+            }
         A.product(V[ni],AV[ni]);
 
         //Step H of Davidson (1975)
@@ -852,7 +1000,7 @@ complexDavidson(const BigMatrixT& A,
                newColI(ni+1);
         for(int k = 0; k <= ni; ++k)
             {
-            z = BraKet(V.at(k),AV.at(ni));
+            z = BraKet(krylovVec(V,PV,k,tmp),AV.at(ni));
             newColR(k+1) = z.real();
             newColI(k+1) = z.imag();
             }
@@ -870,7 +1018,7 @@ complexDavidson(const BigMatrixT& A,
                    newRowI(ni+1);
             for(int k = 0; k < ni; ++k)
                 {
-                z = BraKet(V.at(ni),AV.at(k));
+                z = BraKet(V.at(ni),krylovVec(AV,PAV,k,tmp));
                 newRowR(k+1) = z.real();
                 newRowI(k+1) = z.imag();
                 }
@@ -885,6 +1033,14 @@ complexDavidson(const BigMatrixT& A,
             complex_diag = true;
             }
 
+        //Pack the vectors no longer the latest
+        if(!PV.empty())
+            {
+            PAV.at(ni-1) = PackedTensor(AV[ni-1],avprec);
+            V[ni-1] = Tensor();
+            AV[ni-1] = Tensor();
+            }
+
         ++iter;
 
         } //for(ii)
@@ -902,19 +1058,12 @@ complexDavidson(const BigMatrixT& A,
 
         const int Nr = UR.Nrows();
 
-        phi_j = UR(1,1+t)*V[0];
-        for(int k = 1; k < Nr; ++k)
-            {
-            phi_j += UR(1+k,1+t)*V[k];
-            }
-        if(complex_evec)
+        std::vector<Complex> cfac(Nr);
+        for(int k = 0; k < Nr; ++k)
             {
-            phi_j += Complex_i*UI(1,1+t)*V[0];
-            for(int k = 1; k < Nr; ++k)
-                {
-                phi_j += Complex_i*UI(1+k,1+t)*V[k];
-                }
+            cfac[k] = Complex(UR(1+k,1+t),(complex_evec ? UI(1+k,1+t) : 0.));
             }
+        krylovComb(cfac,V,PV,phi_j);
         }
 
     if(debug_level_ >= 3)
@@ -925,7 +1074,7 @@ complexDavidson(const BigMatrixT& A,
         for(int r = 1; r <= iter+1; ++r)
         for(int c = r; c <= iter+1; ++c)
             {
-            z = BraKet(V[r-1],V[c-1]);
+            z = BraKet(krylovVec(V,PV,r-1,tmp),krylovVec(V,PV,c-1,tmp2));
             Vo_final(r,c) = abs(z);
             Vo_final(c,r) = Vo_final(r,c);
             }
@@ -950,6 +1099,307 @@ complexDavidson(const BigMatrixT& A,
 
     } //complexDavidson
 
+template <class BigMatrixT, class Tensor> 
+void
+blockProduct(const BigMatrixT& A, 
+             const std::vector<Tensor>& phi,
+             std::vector<Tensor>& phip)
+    {
+    phip.resize(phi.size());
+    for(size_t j = 0; j < phi.size(); ++j)
+        {
+        A.product(phi[j],phip[j]);
+        }
+    }
+
+//Orthonormalizes the vectors in block against those in V 
+//and each other (classical Gram-Schmidt done twice, with the
+//overlaps against V computed in parallel), dropping any 
+//which are linearly dependent
+template <class Tensor> 
+void
+orthogBlock(const std::vector<Tensor>& V,
+            std::vector<Tensor>& block)
+    {
+    const int Npass = 2;
+    std::vector<Tensor> res;
+    for(size_t b = 0; b < block.size(); ++b)
+        {
+        Tensor& q = block[b];
+        Real qn = q.norm();
+        if(qn == 0) continue;
+        q *= 1./qn;
+        const int nv = V.size(),
+                  n = nv+res.size();
+        std::vector<Real> Vq(n);
+        for(int pass = 1; pass <= Npass; ++pass)
+            {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(int k = 0; k < n; ++k)
+                {
+                Vq[k] = BraKet((k < nv ? V[k] : res[k-nv]),q).real();
+                }
+            std::vector<Real> cV(nv),
+                              cres(n-nv);
+            for(int k = 0; k < n; ++k)
+                {
+                if(k < nv) cV[k] = -Vq[k];
+                else       cres[k-nv] = -Vq[k];
+                }
+            multiAxpy(cV,V,q);
+            multiAxpy(cres,res,q);
+            qn = q.norm();
+            if(qn < 1E-10) break;
+            q *= 1./qn;
+            }
+        if(qn < 1E-10) continue;
+        res.push_back(q);
+        }
+    block.swap(res);
+    }
+
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(const BigMatrixT& A, 
+              std::vector<Tensor>& phi,
+              const OptSet& opts)
+    {
+    const int maxiter_ = opts.getInt("MaxIter",2);
+    const Real errgoal_ = opts.getReal("ErrGoal",1E-4);
+    const int debug_level_ = opts.getInt("DebugLevel",-1);
+    const int miniter_ = opts.getInt("MinIter",1);
+
+    const Real Approx0 = 1E-12;
+
+    const int nget = phi.size();
+    if(nget == 0)
+        {
+        Error("No initial vectors passed to blockDavidson.");
+        }
+    const int nblock = max(nget,opts.getInt("BlockSize",2));
+
+    bool cplx = false;
+    for(int j = 0; j < nget; ++j)
+        {
+        if(phi[j].isComplex()) cplx = true;
+        }
+    if(cplx || !opts.getBool("Hermitian",true))
+        {
+        //Only real Hermitian problems are handled by the block method
+        OptSet nopts(opts);
+        nopts.add("EigenSolver",std::string("Davidson"));
+        return davidson(A,phi,nopts);
+        }
+
+    const int maxsize = A.size();
+    if(phi.front().indices().dim() != maxsize)
+        {
+        Print(phi.front().indices().dim());
+        Print(A.size());
+        Error("blockDavidson: size of initial vector should match linear matrix size");
+        }
+
+    DavidsonStats& stats = davidsonStats();
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    ++stats.ncall;
+
+    //Get diagonal of A to use later
+    const Tensor Adiag = A.diag();
+
+    std::vector<Tensor> V, AV,
+                        block(phi), 
+                        Ablock;
+
+    Real t0 = wallTime();
+    orthogBlock(V,block);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    stats.orthog_time += wallTime()-t0;
+    if(int(block.size()) != nget)
+        {
+        Error("blockDavidson: initial vectors are not linearly independent");
+        }
+
+    //Projection of A into the V's
+    Matrix M;
+    Vector D;
+    Matrix U;
+
+    //Ritz vectors and residuals
+    std::vector<Tensor> x, r;
+    std::vector<Real> rnorm;
+
+    std::vector<Real> eigs(nget,NAN),
+                      last_eigs(nget,1000);
+    Real qnorm = NAN;
+
+    int iter = 0;
+    while(true)
+        {
+        //Apply A to the new vectors
+        t0 = wallTime();
+        blockProduct(A,block,Ablock);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        stats.product_time += wallTime()-t0;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        stats.nproduct += block.size();
+
+        t0 = wallTime();
+
+        const int nold = V.size();
+        V.insert(V.end(),block.begin(),block.end());
+        AV.insert(AV.end(),Ablock.begin(),Ablock.end());
+        const int n = V.size();
+
+        //Add new rows and columns to M
+        Matrix Mn(n,n);
+        if(nold > 0) Mn.SubMatrix(1,nold,1,nold) = M;
+        std::vector<std::pair<int,int> > el;
+        for(int c = nold; c < n; ++c)
+        for(int k = 0; k <= c; ++k)
+            {
+            el.push_back(std::make_pair(k,c));
+            }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(int e = 0; e < int(el.size()); ++e)
+            {
+            const int k = el[e].first,
+                      c = el[e].second;
+            Mn(k+1,c+1) = BraKet(V[k],AV[c]).real();
+            Mn(c+1,k+1) = Mn(k+1,c+1);
+            }
+        M = Mn;
+
+        EigenValues(M,D,U);
+
+        //Ritz vectors and residuals of the 
+        //nr lowest eigenvalues of M
+        const int nr = min(nblock,n);
+        x.resize(nr);
+        r.resize(nr);
+        rnorm.resize(nr);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(int i = 0; i < nr; ++i)
+            {
+            std::vector<Real> cfac(n);
+            for(int k = 0; k < n; ++k)
+                {
+                cfac[k] = U(k+1,1+i);
+                }
+            linearComb(cfac,V,x[i]);
+            linearComb(cfac,AV,r[i]);
+            r[i] += (-D(1+i))*x[i];
+            //Fix sign
+            if(U(1,1+i) < 0) 
+                {
+                x[i] *= -1;
+                r[i] *= -1;
+                }
+            rnorm[i] = r[i].norm();
+            }
+
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        stats.subspace_time += wallTime()-t0;
+
+        //Check convergence of the nget lowest
+        bool converged = true;
+        qnorm = 0;
+        for(int i = 0; i < nget && i < nr; ++i)
+            {
+            eigs[i] = D(1+i);
+            qnorm = max(qnorm,rnorm[i]);
+            if(!((rnorm[i] < errgoal_ && fabs(eigs[i]-last_eigs[i]) < errgoal_)
+                 || rnorm[i] < max(Approx0,errgoal_ * 1E-3)))
+                {
+                converged = false;
+                }
+            last_eigs[i] = eigs[i];
+            }
+        if(nr < nget) converged = false;
+
+        if(debug_level_ >= 2)
+            {
+            printf("I %d q %.0E E",iter,qnorm);
+            for(int i = 0; i < nget && i < nr; ++i)
+                {
+                printf(" %.10f",eigs[i]);
+                }
+            println();
+            }
+
+        if((converged && iter >= miniter_) || iter >= maxiter_ || n >= maxsize)
+            {
+            break;
+            }
+
+        //The next block is made of the preconditioned
+        //residuals which are not yet small
+        block.clear();
+        for(int i = 0; i < nr && n+int(block.size()) < maxsize; ++i)
+            {
+            if(rnorm[i] < max(Approx0,errgoal_ * 1E-3)) continue;
+            Tensor q = r[i];
+            if(Adiag)
+                {
+                DavidsonPrecond dp(D(1+i));
+                Tensor cond(Adiag);
+                cond.mapElems(dp);
+                q /= cond;
+                }
+            block.push_back(q);
+            }
+
+        t0 = wallTime();
+        orthogBlock(V,block);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        stats.orthog_time += wallTime()-t0;
+
+        if(block.empty()) break;
+
+        ++iter;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        ++stats.niter;
+        }
+
+    for(int i = 0; i < nget; ++i)
+        {
+        if(i < int(x.size())) phi[i] = x[i];
+        }
+
+    if(debug_level_ > 0)
+        {
+        printf("I %d q %.0E E",iter,qnorm);
+        for(int i = 0; i < nget; ++i)
+            {
+            if(std::isnan(eigs[i])) break;
+            printf(" %.10f",eigs[i]);
+            }
+        println();
+        }
+
+    return eigs;
+
+    } //blockDavidson
+
 template <class BigMatrixTA, class BigMatrixTB, class Tensor> 
 Real
 genDavidson(const BigMatrixTA& A, 
@@ -1182,11 +1632,12 @@ genDavidson(const BigMatrixTA& A,
         Error("Wrong size: U.Nrows() != iter");
         }
 #endif
-    phi = U(1,1)*V[1];
-    for(int k = 2; k <= iter; ++k)
+    std::vector<Real> cfac(iter+1,0.);
+    for(int k = 1; k <= iter; ++k)
         {
-        phi += U(k,1)*V[k];
+        cfac[k] = U(k,1);
         }
+    linearComb(cfac,V,phi);
 
     return lambda;
 
@@ -15,7 +15,9 @@
 #include "option.h"
 #include "cppversion.h"
 #include "print.h"
+#include "mapfile.h"
 #include <ctime>
+#include <sys/time.h>
 #include <string.h>
 #include <cstring>
 
@@ -79,6 +81,15 @@ enum Printdat { ShowData, HideData };
 #define PrintData(X) PrintEither(X,true)
 
 
+//Wall clock time in seconds
+double inline
+wallTime()
+    {
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec + tv.tv_usec * 1.0e-6;
+    }
+
 bool inline
 fileExists(const std::string& fname)
     {
@@ -87,10 +98,22 @@ fileExists(const std::string& fname)
     }
 
 
+//Reads the file through a memory map if possible,
+//so tensor data is used in place without copying
+//(see mapfile.h)
 template<class T> 
 void inline
 readFromFile(const std::string& fname, T& t) 
     { 
+    MappedFile* mf = MappedFile::open(fname);
+    if(mf)
+        {
+        MappedBuf buf(mf);
+        std::istream s(&buf);
+        t.read(s);
+        mf->close();
+        return;
+        }
     std::ifstream s(fname.c_str()); 
     if(!s.good()) 
         Error("Couldn't open file \"" + fname + "\" for reading");
@@ -99,15 +122,32 @@ readFromFile(const std::string& fname, T& t)
     }
 
 
+//Writes to a temporary file renamed to fname when
+//done, so memory maps of a previous fname stay valid.
+//Returns false (instead of calling Error) if it fails
 template<class T> 
-void inline
-writeToFile(const std::string& fname, const T& t) 
+bool inline
+tryWriteToFile(const std::string& fname, const T& t) 
     { 
-    std::ofstream s(fname.c_str()); 
-    if(!s.good()) 
-        Error("Couldn't open file \"" + fname + "\" for writing");
+    const std::string tmpname = fname + ".tmp";
+    std::ofstream s(tmpname.c_str()); 
+    if(!s.good()) return false;
     t.write(s); 
     s.close(); 
+    if(s.fail() || rename(tmpname.c_str(),fname.c_str()) != 0)
+        {
+        remove(tmpname.c_str());
+        return false;
+        }
+    return true;
+    }
+
+template<class T> 
+void inline
+writeToFile(const std::string& fname, const T& t) 
+    { 
+    if(!tryWriteToFile(fname,t))
+        Error("Couldn't write file \"" + fname + "\"");
     }
 
 //Given a prefix (e.g. pfix == "mydir")
@@ -256,7 +296,18 @@ class Global
         static bool debug4_ = false;
         return debug4_;
         }
-    //Global option set
+    //If true, the result of an ITensor contraction only has
+    //its norm scaled out (see ITensor::scaleOutNorm) when a 
+    //sample of its elements is very large or very small,
+    //instead of after every contraction. See scaleStats().
+    static bool& 
+    lazyScale()
+        {
+        static bool lazyScale_ = false;
+        return lazyScale_;
+        }
+    //Global option set (of the calling thread
+    //if it has made a ThreadOpts, see option.h)
     static OptSet&
     opts()
         {
@@ -321,21 +372,26 @@ class Global
         static Generator rng(std::time(NULL)+getpid());
         static Distribution dist(0,1);
 
+        Real r = 0;
+#ifdef _OPENMP
+#pragma omp critical(itensor_random)
+#endif
+        {
         if(seed != 0)  //reseed rng
             {
             rng = Generator(seed);
             }
-
-        return dist(rng);
+        r = dist(rng);
+        }
+        return r;
         }
     void static
     warnDeprecated(const std::string& message)
         {
-        static int depcount = 1;
-        if(depcount <= 10)
+        static int depcount = 0;
+        if(__sync_add_and_fetch(&depcount,1) <= 10)
             {
             println("\n\n",message,"\n");
-            ++depcount;
             }
         }
     };
@@ -18,6 +18,10 @@ namespace itensor {
 // usually to be combined into a more complex
 // MPO such as a Hamiltonian.
 //
+// (To build a Hamiltonian with many terms, AutoMPO
+// in autompo.h is much faster than summing the MPOs
+// of its terms and gives a smaller bond dimension.)
+//
 
 template <class Tensor>
 class HamBuilder
@@ -83,8 +87,7 @@ class HamBuilder
     hamNumber()
         {
         static int num_ = 0;
-        ++num_;
-        return num_;
+        return __sync_add_and_fetch(&num_,1);
         }
 
     };
@@ -88,8 +88,10 @@ struct IndexDat
     {
     //////////////
 
-    typedef mt19937 IDGenerator;
-    typedef IDGenerator::result_type IDType;
+    //IDs are 32 bit values stored as the result type of
+    //the mt19937 generator formerly used to make them
+    //(which sets the size of an id in written files)
+    typedef mt19937::result_type IDType;
 
     const IDType id;
     const int m;
@@ -133,15 +135,44 @@ Null()
 //
 
 
-IndexDat::IDType 
-generateID()
+//Invertible mixing of the bits of a 32 bit value
+//(the finalizer of MurmurHash3)
+IndexDat::IDType static
+mixID(IndexDat::IDType h)
     {
-    static IndexDat::IDGenerator rng(std::time(NULL) + getpid());
-    return rng();
+    const IndexDat::IDType mask = 0xFFFFFFFFUL;
+    h &= mask;
+    h ^= h >> 16;
+    h = (h * 0x85EBCA6BUL) & mask;
+    h ^= h >> 13;
+    h = (h * 0xC2B2AE35UL) & mask;
+    h ^= h >> 16;
+    return h;
+    }
 
-    //static IDType nextid = 0;
-    //++nextid;
-    //return nextid;
+//
+// Each call takes the next value of a counter, without
+// locking since Indices are made in threaded code such
+// as gateTEvol with Parallel=true or by independent
+// calculations on different threads. Because mixID is
+// one-to-one, no id is repeated within a process until
+// 2^32 Indices have been made, while ids still look
+// random (as needed by uniqueReal). The counter starts
+// at an offset set by the time and process id so that
+// different runs make different ids.
+//
+IndexDat::IDType
+generateID()
+    {
+    static const IndexDat::IDType offset = mixID(std::time(NULL) + getpid());
+    static IndexDat::IDType count = 0;
+    IndexDat::IDType id = 0;
+    //id 0 belongs to the Null IndexDat
+    while(id == 0)
+        {
+        id = mixID(offset + __sync_fetch_and_add(&count,1));
+        }
+    return id;
     }
 
 
@@ -200,10 +231,18 @@ primeLevel(int plev)
 Real Index::
 uniqueReal() const
     {
-    static const Real rmax = IndexDat::IDGenerator::max();
+    static const Real rmax = mt19937::max();
     return (p->id/rmax)*(1.0+sin(primelevel_));
     }
 
+IndexID Index::
+uniqueID() const
+    {
+    //Index ids are 32 bit, so the id and the
+    //prime level fit into separate halves
+    return (IndexID(p->id) << 32) | IndexID((unsigned int)primelevel_);
+    }
+
 bool Index::
 operator==(const Index& other) const 
     { 
@@ -18,6 +18,10 @@ class IndexVal;
 typedef shared_ptr<IndexDat>
 IndexDatPtr;
 
+//Integer identifying an Index and its prime level
+typedef unsigned long long
+IndexID;
+
 //
 // Index
 //
@@ -64,6 +68,12 @@ class Index : public safe_bool<Index>
     Real 
     uniqueReal() const;
 
+    // Returns an integer uniquely identifying this Index
+    // and its prime level. Unlike uniqueReal, it can be 
+    // compared exactly (e.g. for hashing or sorting).
+    IndexID
+    uniqueID() const;
+
     // Returns the IndexType
     IndexType 
     type() const;
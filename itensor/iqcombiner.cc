@@ -233,6 +233,30 @@ dag()
     }
 
 
+static const IndexMap&
+findMap(const Index& big, const vector<IndexMap>& maps)
+    {
+    Foreach(const IndexMap& m, maps)
+        {
+        if(m.big == big) return m;
+        }
+    Error("IndexMap not found");
+    return maps.front();
+    }
+
+//Map of the sector of the condensed Index small
+//starting at j
+static const IndexMap&
+findMap(const Index& small, int j, const vector<IndexMap>& maps)
+    {
+    Foreach(const IndexMap& m, maps)
+        {
+        if(m.i == j && m.small == small) return m;
+        }
+    Error("small,j pair not found");
+    return maps.front();
+    }
+
 static const Combiner&
 findcomb(const Index& K, const vector<Combiner>& combs)
     {
@@ -258,28 +282,20 @@ product(IQTensor T, IQTensor& res) const
         //
         //T has right IQIndex, expand it
         //
-        IQTensor T_uncondensed;
-        if(do_condense) 
-            { 
-            cond.product(T,T_uncondensed); 
-            }
-        const IQTensor& T_ = (do_condense ? T_uncondensed : T);
-        const IQIndex& r = (do_condense ? ucright_ : right_);
-
         if(Global::checkArrows())
-            if(dir(T_.indices(),r) == r.dir())
+            if(dir(T.indices(),right_) == right_.dir())
                 {
-                cout << "IQTensor = " << T_ << endl;
+                cout << "IQTensor = " << T << endl;
                 cout << "IQCombiner = " << *this << endl;
-                cout << "(Right) IQIndex from IQCombiner = " << r << endl;
+                cout << "(Right) IQIndex from IQCombiner = " << right_ << endl;
                 Error("Incompatible arrow directions in operator*(IQTensor,IQCombiner).");
                 }
 
-        iqinds.reserve(T_.indices().r()-1+left_.size());
+        iqinds.reserve(T.indices().r()-1+left_.size());
 
-        Foreach(const IQIndex& I, T_.indices())
+        Foreach(const IQIndex& I, T.indices())
             {
-            if(I == r)
+            if(I == right_)
                 copy(left_.begin(),left_.end(),back_inserter(iqinds));
             else
                 iqinds.push_back(I);
@@ -287,14 +303,29 @@ product(IQTensor T, IQTensor& res) const
 
         res = IQTensor(iqinds);
 
-        Foreach(const ITensor& tt, T_.blocks())
+        Foreach(const ITensor& tt, T.blocks())
         Foreach(const Index& K, tt.indices())
             {
-            if(hasindex(r,K))
-                { 
+            if(!hasindex(right_,K)) continue;
+
+            if(!do_condense)
+                {
                 res += (findcomb(K,combs) * tt); 
                 break;
                 }
+
+            //Copy each sector of the condensed index K 
+            //straight out of tt and uncombine it (which
+            //only relabels its indices)
+            for(int start = 0; start < K.m(); )
+                {
+                const IndexMap& m = findMap(K,start,cond.maps());
+                ITensor piece(tt);
+                piece.sliceIndex(K,m.big,start);
+                res += (findcomb(m.big,combs) * piece);
+                start += m.big.m();
+                }
+            break;
             } //end for
 
         }
@@ -312,8 +343,7 @@ product(IQTensor T, IQTensor& res) const
             if(!hasindex(*this,I)) iqinds.push_back(I); 
             }
         //and res will have c's right IQIndex
-        if(do_condense) iqinds.push_back(ucright_);
-        else            iqinds.push_back(right_);
+        iqinds.push_back(right_);
 
         res = IQTensor(iqinds);
 
@@ -345,6 +375,10 @@ product(IQTensor T, IQTensor& res) const
                 }
             }
 
+        //Blocks of the condensed result
+        std::map<BlockKey,ITensor> nblocks;
+        array<Index,NMAX+1> group;
+
         //Loop over each block in T and apply appropriate
         //Combiner (determined by the uniqueReal of the 
         //combined Indices)
@@ -377,13 +411,37 @@ product(IQTensor T, IQTensor& res) const
                 Error("no Combiner with matching indices in IQCombiner prod");
                 }
 
-            res += (combs[cc] * t);
+            if(!do_condense)
+                {
+                res += (combs[cc] * t);
+                continue;
+                }
+
+            //Combine the indices of t and copy the result
+            //straight into its sector of the condensed index
+            const Combiner& co = combs[cc];
+            const IndexMap& m = findMap(co.right(),cond.maps());
+            IndexSet<Index> nis;
+            Foreach(const Index& K, t.indices())
+                {
+                if(!hasindex(co,K)) nis.addindex(K);
+                }
+            nis.addindex(m.small);
+
+            ITensor& nb = nblocks[BlockKey(nis)];
+            if(!nb) nb = ITensor(nis);
+
+            for(int j = 1; j <= co.numLeft(); ++j) 
+                {
+                group[j] = co.left(j);
+                }
+            nb.embed(t,group,co.numLeft(),m.small,m.i);
             }
 
-        if(do_condense) 
-            { 
-            IQTensor rcopy(res); 
-            cond.product(rcopy,res); 
+        for(std::map<BlockKey,ITensor>::const_iterator it = nblocks.begin();
+            it != nblocks.end(); ++it)
+            {
+            res += it->second;
             }
         }
     } //void product(const IQTensor& T, IQTensor& res) const
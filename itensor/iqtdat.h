@@ -6,9 +6,79 @@
 #define __ITENSOR_IQTDAT_H
 #include "indexset.h"
 #include <algorithm>
+#include <map>
 
 namespace itensor {
 
+//
+// BlockKey: exact key made from the uniqueID's of
+// a set of indices (at most NMAX), independent of
+// their order. Used to look up the blocks of an IQTensor
+// and to match blocks having the same contracted sectors.
+//
+
+class BlockKey
+    {
+    public:
+
+    BlockKey() : n_(0) { }
+
+    template <class IndexT>
+    explicit
+    BlockKey(const IndexSet<IndexT>& is) 
+        : n_(0)
+        { 
+        Foreach(const IndexT& I, is) add(I.uniqueID()); 
+        }
+
+    int
+    size() const { return n_; }
+
+    //Keeps ids sorted: there are few enough
+    //that insertion sort is fastest
+    void
+    add(IndexID id)
+        {
+#ifdef DEBUG
+        if(n_ >= NMAX) Error("BlockKey: too many indices");
+#endif
+        int j = n_++;
+        for(; j > 0 && id_[j-1] > id; --j) id_[j] = id_[j-1];
+        id_[j] = id;
+        }
+
+    bool
+    operator<(const BlockKey& other) const
+        {
+        if(n_ != other.n_) return n_ < other.n_;
+        for(int j = 0; j < n_; ++j)
+            {
+            if(id_[j] != other.id_[j]) return id_[j] < other.id_[j];
+            }
+        return false;
+        }
+
+    bool
+    operator==(const BlockKey& other) const
+        {
+        if(n_ != other.n_) return false;
+        for(int j = 0; j < n_; ++j)
+            {
+            if(id_[j] != other.id_[j]) return false;
+            }
+        return true;
+        }
+
+    bool
+    operator!=(const BlockKey& other) const { return !operator==(other); }
+
+    private:
+
+    int n_;
+    array<IndexID,NMAX> id_;
+
+    }; //class BlockKey
+
 
 //
 // IQTDat: storage for IQTensor and IQTSparse
@@ -19,9 +89,13 @@ class IQTDat
     {
     public:
 
-    IQTDat() { }
+    IQTDat() : indexed_(true) { }
 
-    IQTDat(const IQTDat& other) { blocks_ = other.blocks_; }
+    IQTDat(const IQTDat& other) 
+        : 
+        blocks_(other.blocks_),
+        indexed_(false)
+        { copyIndex(other); }
 
     typedef std::vector<Tensor>
     StorageT;
@@ -40,10 +114,12 @@ class IQTDat
     const_iterator
     end() const { return blocks_.end(); }
 
+    //Non-const access may change the indices of
+    //the blocks, so the block index must be rebuilt
     iterator
-    begin() { return blocks_.begin(); }
+    begin() { indexed_ = false; return blocks_.begin(); }
     iterator
-    end() { return blocks_.end(); }
+    end() { indexed_ = false; return blocks_.end(); }
 
     bool 
     hasBlock(const IndexSet<IndexT>& is) const 
@@ -62,7 +138,7 @@ class IQTDat
     empty() const { return blocks_.empty(); }
 
     void
-    clear() { blocks_.clear(); }
+    clear() { blocks_.clear(); index_.clear(); indexed_ = true; }
 
     void 
     insert(const Tensor& t);
@@ -74,7 +150,7 @@ class IQTDat
     clean(Real min_norm);
 
     void
-    swap(StorageT& new_blocks) { blocks_.swap(new_blocks); }
+    swap(StorageT& new_blocks) { blocks_.swap(new_blocks); indexed_ = false; }
 
     //
     // Other Methods
@@ -84,7 +160,12 @@ class IQTDat
     scaleTo(const LogNumber& newscale);
 
     void
-    makeCopyOf(const IQTDat& other) { blocks_ = other.blocks_; }
+    makeCopyOf(const IQTDat& other) 
+        { 
+        blocks_ = other.blocks_; 
+        indexed_ = false;
+        copyIndex(other);
+        }
 
     void 
     read(std::istream& s);
@@ -99,20 +180,44 @@ class IQTDat
 
     //////////////
 
+    typedef std::map<BlockKey,int>
+    BlockIndex;
+
     StorageT blocks_;
 
+    //Position of each block in blocks_, rebuilt by the
+    //next lookup after a non-const access. The same IQTDat
+    //may be read by several threads, so the rebuild is
+    //locked and indexed_ is only set once index_ is complete.
+    mutable BlockIndex index_;
+    mutable volatile bool indexed_;
+
     //////////////
 
+    int
+    blockPos(const IndexSet<IndexT>& is) const;
+
+    void
+    buildIndex() const;
+
+    void
+    copyIndex(const IQTDat& other);
+
+    void
+    pushBlock(const Tensor& t);
+
     iterator
     findBlock(const IndexSet<IndexT>& is)
         {
-        return find(blocks_.begin(),blocks_.end(),is);
+        const int n = blockPos(is);
+        return (n < 0 ? blocks_.end() : blocks_.begin()+n);
         }
 
     const_iterator
     findBlock(const IndexSet<IndexT>& is) const
         {
-        return find(blocks_.begin(),blocks_.end(),is);
+        const int n = blockPos(is);
+        return (n < 0 ? blocks_.end() : blocks_.begin()+n);
         }
 
     bool
@@ -127,7 +232,59 @@ class IQTDat
     }; //class IQTDat
 
 
+template<class Tensor>
+int IQTDat<Tensor>::
+blockPos(const IndexSet<IndexT>& is) const
+    {
+    if(indexed_) __sync_synchronize(); //read index_ only after indexed_
+    else         buildIndex();
+    typename BlockIndex::const_iterator it = index_.find(BlockKey(is));
+    return (it == index_.end() ? -1 : it->second);
+    }
 
+template<class Tensor>
+void IQTDat<Tensor>::
+buildIndex() const
+    {
+#ifdef _OPENMP
+#pragma omp critical(itensor_IQTDat_index)
+#endif
+    {
+    if(!indexed_)
+        {
+        index_.clear();
+        for(size_t n = 0; n < blocks_.size(); ++n)
+            {
+            index_.insert(std::make_pair(BlockKey(blocks_[n].indices()),int(n)));
+            }
+        __sync_synchronize(); //publish index_ before indexed_
+        indexed_ = true;
+        }
+    }
+    }
+
+//Copies the block index of other if it is built
+//(otherwise this one is built by its first lookup)
+template<class Tensor>
+void IQTDat<Tensor>::
+copyIndex(const IQTDat& other)
+    {
+    if(!other.indexed_) return;
+    __sync_synchronize();
+    index_ = other.index_;
+    indexed_ = true;
+    }
+
+template<class Tensor>
+void IQTDat<Tensor>::
+pushBlock(const Tensor& t)
+    {
+    blocks_.push_back(t);
+    if(indexed_)
+        {
+        index_.insert(std::make_pair(BlockKey(t.indices()),int(blocks_.size())-1));
+        }
+    }
 
 template<class Tensor>
 Tensor& IQTDat<Tensor>::
@@ -136,7 +293,7 @@ get(const IndexSet<IndexT>& is)
     iterator it = findBlock(is);
     if(!validBlock(it))
         {
-        blocks_.push_back(ITensor(is));
+        pushBlock(Tensor(is));
         return blocks_.back();
         }
     return *it;
@@ -158,9 +315,8 @@ template<class Tensor>
 void IQTDat<Tensor>::
 insert(const Tensor& t)
     {
-    iterator it = find(blocks_.begin(),blocks_.end(),t.indices());
-    if(it == blocks_.end())
-        blocks_.push_back(t);
+    if(!validBlock(findBlock(t.indices())))
+        pushBlock(t);
     else
         Error("Can not insert block with identical indices twice.");
     }
@@ -173,7 +329,7 @@ insert_add(const Tensor& t)
     if(validBlock(it))
         *it += t;
     else
-        blocks_.push_back(t);
+        pushBlock(t);
     }
 
 template<class Tensor>
@@ -208,6 +364,7 @@ read(std::istream& s)
         { 
         t.read(s); 
         }
+    indexed_ = false;
     }
 
 template<class Tensor>
@@ -5,6 +5,9 @@
 #include "iqtensor.h"
 #include "qcounter.h"
 #include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace itensor {
 
@@ -886,15 +889,156 @@ operator<<(std::ostream & s, const IQTensor& T)
     return s;
     }
 
-//Helper method for operator*= and operator/=
-bool static
-vectoruRContains(const vector<Real>& v, Real r)
+typedef pair<const ITensor*,const ITensor*>
+BlockPair;
+
+//Key made of the ids of the indices of block t 
+//appearing in the sorted list common_ids
+BlockKey static
+commonKey(const ITensor& t, const vector<IndexID>& common_ids)
     {
-    Foreach(const Real& x, v)
+    BlockKey key;
+    Foreach(const Index& I, t.indices())
         {
-        if(fabs(r-x) <= UniqueRealAccuracy) return true;
+        const IndexID id = I.uniqueID();
+        if(std::binary_search(common_ids.begin(),common_ids.end(),id))
+            key.add(id);
+        }
+    return key;
+    }
+
+//Helper method for operator*= and operator/=:
+//finds all pairs of blocks of L and R with matching
+//common (contracted) sectors. Blocks of R are first 
+//grouped by sector so only compatible pairs are visited.
+//Pairs are ordered by L block, then by R block.
+void static
+matchBlocks(const IQTDat<ITensor>::StorageT& L,
+            const IQTDat<ITensor>& R,
+            const vector<IndexID>& common_ids,
+            vector<BlockPair>& pairs)
+    {
+    typedef std::map<BlockKey,vector<const ITensor*> >
+    SectorMap;
+
+    SectorMap sectors;
+    Foreach(const ITensor& t, R)
+        {
+        sectors[commonKey(t,common_ids)].push_back(&t);
+        }
+
+    pairs.clear();
+    Foreach(const ITensor& t, L)
+        {
+        SectorMap::const_iterator s = sectors.find(commonKey(t,common_ids));
+        if(s == sectors.end()) continue;
+        Foreach(const ITensor* r, s->second)
+            {
+            pairs.push_back(BlockPair(&t,r));
+            }
+        }
+    }
+
+#ifdef _OPENMP
+//Key of the block resulting from the product of a pair of blocks:
+//for a contraction (contract == true) the common indices are 
+//summed over, otherwise they are kept
+BlockKey static
+productKey(const BlockPair& p, bool contract, 
+           const vector<IndexID>& common_ids)
+    {
+    BlockKey key;
+    Foreach(const Index& I, p.first->indices())
+        {
+        const IndexID id = I.uniqueID();
+        if(!contract || !std::binary_search(common_ids.begin(),common_ids.end(),id))
+            key.add(id);
+        }
+    Foreach(const Index& I, p.second->indices())
+        {
+        const IndexID id = I.uniqueID();
+        if(!std::binary_search(common_ids.begin(),common_ids.end(),id))
+            key.add(id);
+        }
+    return key;
+    }
+#endif
+
+void static
+blockProduct(const BlockPair& p, bool contract, ITensor& prod)
+    {
+    prod = *(p.first);
+    if(contract) prod *= *(p.second);
+    else         prod /= *(p.second);
+    }
+
+//Helper method for operator*= and operator/=:
+//adds the products of all pairs of blocks into dat.
+//
+//If the global option "ThreadedBlocks" is true (and the
+//library is compiled with OpenMP), the pairs are grouped by 
+//result block and the groups are shared out dynamically among
+//threads. Each result block is summed by a single thread in the 
+//same order as the serial code, so the result does not depend on 
+//the number of threads and no locking is needed.
+void static
+addBlockProducts(const vector<BlockPair>& pairs, bool contract,
+                 const vector<IndexID>& common_ids,
+                 IQTDat<ITensor>& dat)
+    {
+#ifdef _OPENMP
+    if(pairs.size() > 1 && omp_get_max_threads() > 1
+       && Global::opts().getBool("ThreadedBlocks",false))
+        {
+        typedef std::map<BlockKey,int>
+        GroupMap;
+
+        GroupMap group_num;
+        vector<vector<int> > groups;
+        for(size_t n = 0; n < pairs.size(); ++n)
+            {
+            const pair<GroupMap::iterator,bool> ins = 
+                group_num.insert(make_pair(productKey(pairs[n],contract,common_ids),
+                                           int(groups.size())));
+            if(ins.second) groups.push_back(vector<int>());
+            groups[ins.first->second].push_back(n);
+            }
+
+        const int ngroup = groups.size();
+        vector<ITensor> res(ngroup);
+
+        //Worker threads have their own ProdTag, so pass
+        //on the caller's tag to the block products
+        const char* tag = ProdTag::current();
+#pragma omp parallel for schedule(dynamic)
+        for(int g = 0; g < ngroup; ++g)
+            {
+            ProdTag ptag(tag);
+            ITensor prod;
+            Foreach(int n, groups[g])
+                {
+                blockProduct(pairs[n],contract,prod);
+                if(prod.scale().sign() == 0) continue;
+                if(res[g].valid()) res[g] += prod;
+                else               res[g] = prod;
+                }
+            }
+
+        Foreach(const ITensor& t, res)
+            {
+            if(t.valid()) dat.insert_add(t);
+            }
+        return;
+        }
+#endif
+
+    ITensor prod;
+    Foreach(const BlockPair& p, pairs)
+        {
+        blockProduct(p,contract,prod);
+        if(prod.scale().sign() != 0)
+            dat.insert_add(prod);
         }
-    return false;
     }
 
 IQTensor& IQTensor::
@@ -915,7 +1059,7 @@ operator*=(const IQTensor& other)
 
     solo();
 
-    vector<Real> common_inds;
+    vector<IndexID> common_ids;
     
     //Load iqindex_ with those IQIndex's *not* common to *this and other
     array<IQIndex,NMAX> riqind_holder;
@@ -946,10 +1090,8 @@ operator*=(const IQTensor& other)
 
             Foreach(const Index& i, I.indices())
                 { 
-                common_inds.push_back(i.uniqueReal()); 
+                common_ids.push_back(i.uniqueID()); 
                 }
-
-            common_inds.push_back(I.uniqueReal());
             }
         else 
             { 
@@ -961,7 +1103,7 @@ operator*=(const IQTensor& other)
     for(int i = 1; i <= other.is_->r(); ++i)
         {
         const IQIndex& I = other.is_->index(i);
-        if(!vectoruRContains(common_inds,I.uniqueReal()))
+        if(find(is_->begin(),is_->end(),I) == is_->end())
             { 
             if(rholder >= NMAX)
                 {
@@ -984,44 +1126,11 @@ operator*=(const IQTensor& other)
     IQTDat<ITensor>::StorageT old_itensor; 
     dat.nc().swap(old_itensor);
 
-    typedef IQTDat<ITensor>::const_iterator
-    cbit;
-    typedef pair<Real,cbit>
-    blockpair;
+    std::sort(common_ids.begin(),common_ids.end());
+    vector<BlockPair> pairs;
+    matchBlocks(old_itensor,other.dat(),common_ids,pairs);
 
-    vector<blockpair> other_block;
-    other_block.reserve(other.dat().size());
-
-    for(cbit ot = other.dat().begin(); ot != other.dat().end(); ++ot)
-        {
-        Real r = 0.0;
-        Foreach(const Index& I, ot->indices())
-            {
-            if(vectoruRContains(common_inds,I.uniqueReal()))
-                r += I.uniqueReal(); 
-            }
-        other_block.push_back(make_pair(r,ot));
-        }
-
-    ITensor prod;
-
-    Foreach(const ITensor& t, old_itensor)
-        {
-        Real r = 0;
-        Foreach(const Index& I, t.indices())
-            {
-            if(vectoruRContains(common_inds,I.uniqueReal()))
-                r += I.uniqueReal();
-            }
-        Foreach(const blockpair& p, other_block)
-            {
-            if(fabs(r - p.first) > UniqueRealAccuracy) continue;
-            prod = t;
-            prod *= *(p.second);
-            if(prod.scale().sign() != 0)
-                dat.nc().insert_add(prod);
-            }
-        }
+    addBlockProducts(pairs,true,common_ids,dat.nc());
 
     return *this;
 
@@ -1043,7 +1152,7 @@ operator/=(const IQTensor& other)
     if(!other)
         Error("Multiplying by null IQTensor");
 
-    vector<Real> common_inds;
+    vector<IndexID> common_ids;
     
     array<IQIndex,NMAX> riqind_holder;
     int rholder = 0;
@@ -1071,10 +1180,8 @@ operator/=(const IQTensor& other)
 
             Foreach(const Index& i, I.indices())
                 { 
-                common_inds.push_back(i.uniqueReal()); 
+                common_ids.push_back(i.uniqueID()); 
                 }
-
-            common_inds.push_back(I.uniqueReal());
             }
         riqind_holder[rholder] = I;
         ++rholder;
@@ -1084,7 +1191,7 @@ operator/=(const IQTensor& other)
     for(int i = 1; i <= other.is_->r(); ++i)
         {
         const IQIndex& I = other.is_->index(i);
-        if(!vectoruRContains(common_inds,I.uniqueReal()))
+        if(find(is_->begin(),is_->end(),I) == is_->end())
             { 
             if(rholder >= NMAX)
                 {
@@ -1115,45 +1222,11 @@ operator/=(const IQTensor& other)
     IQTDat<ITensor>::StorageT old_itensor; 
     dat.nc().swap(old_itensor);
 
-    typedef IQTDat<ITensor>::const_iterator
-    cbit;
+    std::sort(common_ids.begin(),common_ids.end());
+    vector<BlockPair> pairs;
+    matchBlocks(old_itensor,other.dat(),common_ids,pairs);
 
-    typedef pair<Real,cbit>
-    blockpair;
-
-    vector<blockpair> other_block;
-    other_block.reserve(other.dat().size());
-
-    for(cbit ot = other.dat().begin(); ot != other.dat().end(); ++ot)
-        {
-        Real r = 0.0;
-        Foreach(const Index& I, ot->indices())
-            {
-            if(vectoruRContains(common_inds,I.uniqueReal()))
-                r += I.uniqueReal(); 
-            }
-        other_block.push_back(make_pair(r,ot));
-        }
-
-    ITensor prod;
-
-    Foreach(const ITensor& t, old_itensor)
-        {
-        Real r = 0;
-        Foreach(const Index& I, t.indices())
-            {
-            if(vectoruRContains(common_inds,I.uniqueReal()))
-                r += I.uniqueReal();
-            }
-        Foreach(const blockpair& p, other_block)
-            {
-            if(fabs(r - p.first) > UniqueRealAccuracy) continue;
-            prod = t;
-            prod /= *(p.second);
-            if(prod.scale().sign() != 0)
-                dat.nc().insert_add(prod);
-            }
-        }
+    addBlockProducts(pairs,false,common_ids,dat.nc());
 
     return *this;
 
@@ -1234,6 +1307,129 @@ operator+=(const IQTensor& other)
     return *this;
     }
 
+void
+linearComb(const vector<Complex>& c,
+           const vector<const IQTensor*>& T,
+           IQTensor& res, bool add)
+    {
+    if(c.size() > T.size()) Error("linearComb: more coefficients than tensors");
+
+    //Non-zero terms
+    vector<int> terms;
+    bool alias = false;
+    for(size_t k = 0; k < c.size(); ++k)
+        {
+        const IQTensor& t = *T[k];
+        if(!t.valid() || t.empty()) continue;
+        if(c[k].real() == 0 && c[k].imag() == 0) continue;
+        if(&t == &res) alias = true;
+        terms.push_back(k);
+        }
+
+    if(alias)
+        {
+        //res is one of the T[k]: add the terms one at a time
+        IQTensor sum;
+        if(add) sum = res;
+        Foreach(int k, terms)
+            {
+            if(c[k].imag() == 0) sum += c[k].real()*(*T[k]);
+            else                 sum += c[k]*(*T[k]);
+            }
+        res = sum;
+        return;
+        }
+
+    if(terms.empty())
+        {
+        if(add) return;
+        res = (c.empty() || !T[0]->valid()) ? IQTensor() : 0*(*T[0]);
+        return;
+        }
+
+    //Indices are matched exactly by their ids
+    //(as blocks are), not by uniqueReal
+    const IQTensor& first = *T[terms.front()];
+    const BlockKey key(*first.is_);
+    Foreach(int k, terms)
+        {
+        if(BlockKey(*T[k]->is_) != key)
+            {
+            Print(first.indices());
+            Print(T[k]->indices());
+            Error("Mismatched indices in linearComb");
+            }
+        }
+
+    const bool same_inds = res.valid() && BlockKey(*res.is_) == key;
+    const bool overwrite = !(add && res.valid());
+    if(!overwrite && !same_inds)
+        {
+        Print(res.indices());
+        Print(first.indices());
+        Error("Mismatched indices in multiAxpy");
+        }
+    if(!same_inds)
+        {
+        res.is_ = first.is_;
+        res.dat = IQTensor::Data();
+        }
+    res.dat.solo();
+    IQTDat<ITensor>& D = res.dat.nc();
+
+    //Find the terms going into each block of res,
+    //adding blocks to res where needed
+    vector<ITensor*> rblock;
+    vector<vector<Complex> > bc;
+    vector<vector<const ITensor*> > bt;
+    std::map<BlockKey,int> bnum;
+    Foreach(int k, terms)
+        {
+        Foreach(const ITensor& t, T[k]->blocks())
+            {
+            const pair<std::map<BlockKey,int>::iterator,bool> ins = 
+                bnum.insert(make_pair(BlockKey(t.indices()),int(rblock.size())));
+            if(ins.second)
+                {
+                rblock.push_back(0);
+                bc.push_back(vector<Complex>());
+                bt.push_back(vector<const ITensor*>());
+                }
+            bc[ins.first->second].push_back(c[k]);
+            bt[ins.first->second].push_back(&t);
+            }
+        }
+    //Blocks are added to D before taking pointers 
+    //to them since adding may move the others
+    for(size_t b = 0; b < rblock.size(); ++b)
+        {
+        D.get(bt[b].front()->indices());
+        }
+    for(size_t b = 0; b < rblock.size(); ++b)
+        {
+        rblock[b] = &D.get(bt[b].front()->indices());
+        }
+
+    const int nb = rblock.size();
+#ifdef _OPENMP
+    const bool threaded = (nb > 1 && Global::opts().getBool("ThreadedBlocks",false));
+#pragma omp parallel for schedule(dynamic) if(threaded)
+#endif
+    for(int b = 0; b < nb; ++b)
+        {
+        linearComb(bc[b],bt[b],*rblock[b],!overwrite);
+        }
+
+    //Drop any old blocks of res which none of the T[k] have
+    if(overwrite && nb < D.size())
+        {
+        IQTDat<ITensor>::StorageT kept;
+        kept.reserve(nb);
+        Foreach(ITensor* r, rblock) kept.push_back(*r);
+        D.swap(kept);
+        }
+    }
+
 //
 //Automatically convert this IQTensor
 //to an ITensor
@@ -311,6 +311,8 @@ class IQTensor : public safe_bool<IQTensor>
 
     void 
     scaleTo(const LogNumber& newscale);
+    void 
+    scaleTo(Real newscale) { scaleTo(LogNumber(newscale)); }
 
     void 
     clean(Real min_norm = MIN_CUT);
@@ -403,6 +405,11 @@ class IQTensor : public safe_bool<IQTensor>
     //
     /////////////////
 
+    friend void
+    linearComb(const std::vector<Complex>& c,
+               const std::vector<const IQTensor*>& T,
+               IQTensor& res, bool add);
+
     void 
     soloIndex();
 
@@ -509,6 +516,19 @@ Dot(IQTensor x, const IQTensor& y);
 Complex 
 BraKet(IQTensor x, const IQTensor& y);
 
+//
+// Version of linearComb (if add is false) and multiAxpy
+// (if add is true) for IQTensors (see itensor.h),
+// combining the matching blocks of the T[k].
+//
+// If the global option "ThreadedBlocks" is true, the
+// blocks of res are computed in parallel using OpenMP.
+//
+void
+linearComb(const std::vector<Complex>& c,
+           const std::vector<const IQTensor*>& T,
+           IQTensor& res, bool add);
+
 //Compute divergence of IQTensor T
 //
 //If DEBUG defined and all blocks do not have
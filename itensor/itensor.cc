@@ -3,6 +3,7 @@
 //    (See accompanying LICENSE file.)
 //
 #include "itensor.h"
+#include "permute.h"
 
 namespace itensor {
 
@@ -83,167 +84,34 @@ reshape(const Permutation& P, const IndexSet<Index>& is, const Vector& dat, Vect
         }
 
     res.ReDimension(dat.Length());
-    res = 0;
 
     const Permutation::int9& ind = P.ind();
 
-    //Make a counter for dat
-    Counter c(is);
-    array<int,NMAX+1> n;
-    for(int j = 1; j <= c.rn; ++j) n[ind[j]] = c.n[j];
-
-    //Special case loops
-#define Loop6(q,z,w,k,y,s) {for(int i1 = 0; i1 < n[1]; ++i1) for(int i2 = 0; i2 < n[2]; ++i2)\
-	for(int i3 = 0; i3 < n[3]; ++i3) for(int i4 = 0; i4 < n[4]; ++i4) for(int i5 = 0; i5 < n[5]; ++i5)\
-    for(int i6 = 0; i6 < n[6]; ++i6)\
-    res[ (((((i6)*n[5]+i5)*n[4]+i4)*n[3]+i3)*n[2]+i2)*n[1]+i1 ] =\
-    dat[ (((((s)*c.n[5]+y)*c.n[4]+k)*c.n[3]+w)*c.n[2]+z)*c.n[1]+q ]; return; }
-
-#define Loop5(q,z,w,k,y) {for(int i1 = 0; i1 < n[1]; ++i1) for(int i2 = 0; i2 < n[2]; ++i2)\
-	for(int i3 = 0; i3 < n[3]; ++i3) for(int i4 = 0; i4 < n[4]; ++i4) for(int i5 = 0; i5 < n[5]; ++i5)\
-    res[ ((((i5)*n[4]+i4)*n[3]+i3)*n[2]+i2)*n[1]+i1 ] = dat[ ((((y)*c.n[4]+k)*c.n[3]+w)*c.n[2]+z)*c.n[1]+q ]; return; }
-
-#define Loop4(q,z,w,k) {for(int i1 = 0; i1 < n[1]; ++i1)  for(int i2 = 0; i2 < n[2]; ++i2)\
-	for(int i3 = 0; i3 < n[3]; ++i3) for(int i4 = 0; i4 < n[4]; ++i4)\
-	res[ (((i4)*n[3]+i3)*n[2]+i2)*n[1]+i1 ] = dat[ (((k)*c.n[3]+w)*c.n[2]+z)*c.n[1]+q ]; return; }
-
-#define Loop3(q,z,w) {for(int i1 = 0; i1 < n[1]; ++i1)  for(int i2 = 0; i2 < n[2]; ++i2)\
-	for(int i3 = 0; i3 < n[3]; ++i3) res[ ((i3)*n[2]+i2)*n[1]+i1 ] = dat[ ((w)*c.n[2]+z)*c.n[1]+q ]; return; }
-
-#define Bif3(a,b,c) if(ind[1] == a && ind[2] == b && ind[3] == c)
-
-#define Bif4(a,b,c,d) if(ind[1] == a && ind[2] == b && ind[3] == c && ind[4] == d)
-
-#define Bif5(a,b,c,d,e) if(ind[1] == a && ind[2] == b && ind[3] == c && ind[4]==d && ind[5] == e)
-
-#define Bif6(a,b,c,d,e,g) if(ind[1] == a && ind[2] == b && ind[3] == c && ind[4]==d && ind[5] == e && ind[6] == g)
-
-    if(is.rn() == 2 && ind[1] == 2 && ind[2] == 1)
-        {
-        MatrixRef xref; 
-        dat.TreatAsMatrix(xref,c.n[2],c.n[1]);
-        res = Matrix(xref.t()).TreatAsVector();
-        return; 
-        }
-    else if(is.rn() == 3)
-        {
-        //DO_IF_PS(int idx = ((ind[1])*3+ind[2])*3+ind[3]; Prodstats::stats().perms_of_3[idx] += 1; )
-        //Arranged loosely in order of frequency of occurrence
-        Bif3(2,1,3) Loop3(i2,i1,i3)
-        Bif3(2,3,1) Loop3(i2,i3,i1) //cyclic
-        Bif3(3,1,2) Loop3(i3,i1,i2)
-        //Bif3(1,3,2) Loop3(i1,i3,i2)
-        //Bif3(3,2,1) Loop3(i3,i2,i1)
-        }
-    else if(is.rn() == 4)
-        {
-        //DO_IF_PS(int idx = (((ind[1])*4+ind[2])*4+ind[3])*4+ind[4]; Prodstats::stats().perms_of_4[idx] += 1; )
-        //Arranged loosely in order of frequency of occurrence
-        Bif4(1,2,4,3) Loop4(i1,i2,i4,i3)
-        Bif4(1,3,2,4) Loop4(i1,i3,i2,i4)
-        Bif4(2,3,1,4) Loop4(i2,i3,i1,i4)
-        Bif4(2,3,4,1) Loop4(i2,i3,i4,i1) //cyclic
-        Bif4(1,4,2,3) Loop4(i1,i4,i2,i3)
-        Bif4(2,1,3,4) Loop4(i2,i1,i3,i4)
-        Bif4(2,1,4,3) Loop4(i2,i1,i4,i3)
-        Bif4(3,4,1,2) Loop4(i3,i4,i1,i2)
-        }
-    else if(is.rn() == 5)
-        {
-        //DO_IF_PS(int idx = ((((ind[1])*5+ind[2])*5+ind[3])*5+ind[4])*5+ind[5]; Prodstats::stats().perms_of_5[idx] += 1; )
-        //Arranged loosely in order of frequency of occurrence
-        Bif5(3,1,4,5,2) Loop5(i3,i1,i4,i5,i2)
-        Bif5(1,4,2,5,3) Loop5(i1,i4,i2,i5,i3)
-        Bif5(1,4,2,3,5) Loop5(i1,i4,i2,i3,i5)
-        Bif5(3,1,4,2,5) Loop5(i3,i1,i4,i2,i5)
-        Bif5(2,4,1,3,5) Loop5(i2,i4,i1,i3,i5)
-        Bif5(2,4,3,5,1) Loop5(i2,i4,i3,i5,i1)
-        Bif5(3,1,4,5,2) Loop5(i3,i1,i4,i5,i2)
-        Bif5(3,4,1,2,5) Loop5(i3,i4,i1,i2,i5)
-        Bif5(2,1,3,4,5) Loop5(i2,i1,i3,i4,i5)
-        Bif5(2,3,4,5,1) Loop5(i2,i3,i4,i5,i1)
-        Bif5(2,3,4,1,5) Loop5(i2,i3,i4,i1,i5)
-        Bif5(2,3,1,4,5) Loop5(i2,i3,i1,i4,i5)
-        Bif5(2,3,4,1,5) Loop5(i2,i3,i4,i1,i5)
-        Bif5(3,4,1,5,2) Loop5(i3,i4,i1,i5,i2)
-        Bif5(5,1,4,2,3) Loop5(i5,i1,i4,i2,i3)
-        }
-    else if(is.rn() == 6)
-        {
-        //DO_IF_PS(int idx = (((((ind[1])*6+ind[2])*6+ind[3])*6+ind[4])*6+ind[5])*6+ind[6]; Prodstats::stats().perms_of_6[idx] += 1; )
-        //Arranged loosely in order of frequency of occurrence
-        Bif6(2,4,1,3,5,6) Loop6(i2,i4,i1,i3,i5,i6)
-        Bif6(1,4,2,3,5,6) Loop6(i1,i4,i2,i3,i5,i6)
-        Bif6(2,4,1,5,3,6) Loop6(i2,i4,i1,i5,i3,i6)
-        Bif6(1,2,4,5,3,6) Loop6(i1,i2,i4,i5,i3,i6)
-        Bif6(3,4,1,5,6,2) Loop6(i3,i4,i1,i5,i6,i2)
-        }
-    //DO_IF_PS(Prodstats::stats().c4 += 1;)
-
-    //The j's are pointers to the i's of xdat's Counter,
-    //but reordered in a way appropriate for res
-    array<int*,NMAX+1> j;
-    for(int k = 1; k <= NMAX; ++k) 
-        { 
-        j[ind[k]] = &(c.i[k]); 
+    array<int,NMAX> dims,
+                    dest;
+    for(int j = 0; j < is.rn(); ++j)
+        {
+        dims[j] = is[j].m();
+        dest[j] = ind[j+1]-1;
         }
 
-    //Catch-all loops that work for any tensor
-    switch(c.rn)
-    {
-    case 2:
-        for(; c.notDone(); ++c)
-            {
-            res[(*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    case 3:
-        for(; c.notDone(); ++c)
-            {
-            res[((*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    case 4:
-        for(; c.notDone(); ++c)
-            {
-            res[(((*j[4])*n[3]+*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    case 5:
-        for(; c.notDone(); ++c)
-            {
-            res[((((*j[5])*n[4]+*j[4])*n[3]+*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    case 6:
-        for(; c.notDone(); ++c)
-            {
-            res[(((((*j[6])*n[5]+*j[5])*n[4]+*j[4])*n[3]+*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    case 7:
-        for(; c.notDone(); ++c)
-            {
-            res[((((((*j[7])*n[6]+*j[6])*n[5]+*j[5])*n[4]+*j[4])*n[3]+*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    default:
-        for(; c.notDone(); ++c)
-            {
-            res[(((((((*j[8])*n[7]+*j[7])*n[6]+*j[6])*n[5]+*j[5])*n[4]+*j[4])*n[3]+*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-                = dat[c.ind];
-            }
-        return;
-    } //switch(c.rn)
+    permuteData(is.rn(),dims.data(),dest.data(),dat.Store(),res.Store());
 
     } // reshape
 
+//Strides of the indices of is in ITensor data
+//(the first index varying fastest)
+void static
+dataStrides(const IndexSet<Index>& is, array<long,NMAX>& str)
+    {
+    long s = 1;
+    for(int j = 0; j < is.r(); ++j)
+        {
+        str[j] = s;
+        s *= is[j].m();
+        }
+    }
+
 //
 // ITensor
 //
@@ -1291,50 +1159,174 @@ expandIndex(const Index& small, const Index& big, int start)
 
 
     const int w = findindex(newinds,big);
-    int inc = start;
-    for(int n = 0; n < w; ++n)
+    array<long,NMAX> nstr;
+    dataStrides(newinds,nstr);
+
+    array<int,NMAX> dims;
+    array<long,NMAX> ostr,
+                     dstr;
+    dataStrides(is_,ostr);
+    for(int j = 0; j < r(); ++j)
         {
-        inc *= newinds[n].m();
+        const Index& J = is_[j];
+        dims[j] = J.m();
+        dstr[j] = (J == small ? nstr[w] : nstr[findindex(newinds,J)]);
         }
 
-    //Comparing nmax and omax determines whether
-    //old dat fits into new dat sequentially, in which
-    //case we can use std::copy
-    const
-	int nmax = 1+_ind(newinds,is_[0].m()-1,is_[1].m()-1, 
-                              is_[2].m()-1,is_[3].m()-1, 
-                              is_[4].m()-1,is_[5].m()-1, 
-                              is_[6].m()-1,is_[7].m()-1);
-
     shared_ptr<ITDat> oldr(r_);
     allocate(newinds.dim());
 
-    const
-    int omax = oldr->v.Length();
+    stridedCopy(r(),dims.data(),ostr.data(),dstr.data(),
+                oldr->v.Store(),r_->v.Store()+start*nstr[w]);
 
-    const Real* const olddat = oldr->v.Store();
-    Real* const newdat = r_->v.Store();
+    is_.swap(newinds);
+    }
 
-	if(nmax == omax)
-	    {
-        std::copy(olddat,olddat+omax,newdat+inc);
-	    }
-    else
+void ITensor::
+sliceIndex(const Index& big, const Index& small, int start)
+    {
+    if(type_ == Diag)
         {
-        Counter c(is_);
-        for(; c.notDone(); ++c)
+        Error("sliceIndex not yet defined for type() == Diag");
+        }
+
+#ifdef DEBUG
+    if(start+small.m() > big.m())
+        {
+        Print(start);
+        Print(small);
+        Print(big);
+        Error("slice must lie within big Index");
+        }
+#endif
+
+    IndexSet<Index> newinds; 
+    bool found = false;
+    for(int j = 1; j <= r(); ++j)
+        {
+        if(is_.index(j) == big)
+            {
+            newinds.addindex(small);
+            found = true;
+            }
+        else 
             {
-            newdat[inc+_ind(newinds,c.i[1],c.i[2],
-                                    c.i[3],c.i[4],
-                                    c.i[5],c.i[6],
-                                    c.i[7],c.i[8])]
-            = olddat[c.ind];
+            newinds.addindex(is_.index(j));
             }
         }
 
+    if(!found)
+        {
+        Print(*this);
+        Print(big);
+        Error("couldn't find index");
+        }
+
+    array<long,NMAX> ostr,
+                     nstr;
+    dataStrides(is_,ostr);
+    dataStrides(newinds,nstr);
+
+    array<int,NMAX> dims;
+    array<long,NMAX> dstr;
+    for(int j = 0; j < r(); ++j)
+        {
+        const Index& J = is_[j];
+        dims[j] = (J == big ? small.m() : J.m());
+        dstr[j] = nstr[findindex(newinds,(J == big ? small : J))];
+        }
+    const long offset = start*ostr[findindex(is_,big)];
+
+    shared_ptr<ITDat> oldr(r_);
+    allocate(newinds.dim());
+    stridedCopy(r(),dims.data(),ostr.data(),dstr.data(),
+                oldr->v.Store()+offset,r_->v.Store());
+
+    if(i_)
+        {
+        shared_ptr<ITDat> oldi(i_);
+        allocateImag(newinds.dim());
+        stridedCopy(r(),dims.data(),ostr.data(),dstr.data(),
+                    oldi->v.Store()+offset,i_->v.Store());
+        }
+
     is_.swap(newinds);
     }
 
+void ITensor::
+embed(const ITensor& t, 
+      const array<Index,NMAX+1>& group, int ngroup,
+      const Index& big, int start)
+    {
+    if(type_ == Diag || t.type_ == Diag)
+        {
+        Error("embed not yet defined for type() == Diag");
+        }
+    if(this == &t)
+        {
+        Error("Cannot embed ITensor into itself");
+        }
+
+    array<long,NMAX> str;
+    dataStrides(is_,str);
+    const long bstr = str[findindex(is_,big)];
+
+    //Strides of the grouped indices within big
+    array<long,NMAX+1> gstr;
+    long gm = 1;
+    for(int g = 1; g <= ngroup; ++g)
+        {
+        gstr[g] = gm*bstr;
+        gm *= group[g].m();
+        }
+    if(start+gm > big.m())
+        {
+        Print(start);
+        Print(gm);
+        Print(big);
+        Error("embed: grouped indices don't fit within big Index");
+        }
+
+    array<int,NMAX> dims;
+    array<long,NMAX> sstr,
+                     dstr;
+    dataStrides(t.is_,sstr);
+    for(int j = 0; j < t.r(); ++j)
+        {
+        const Index& J = t.is_[j];
+        dims[j] = J.m();
+        int g = 1;
+        for(; g <= ngroup; ++g) 
+            {
+            if(group[g] == J) break;
+            }
+        dstr[j] = (g <= ngroup ? gstr[g] : str[findindex(is_,J)]);
+        }
+
+    Real fac = 1;
+    if(scale_.magnitudeLessThan(t.scale_)) 
+        {
+        this->scaleTo(t.scale_); 
+        }
+    else
+        {
+        fac = (t.scale_/scale_).real();
+        }
+
+    solo();
+
+    const long offset = start*bstr;
+    stridedAdd(t.r(),dims.data(),sstr.data(),dstr.data(),fac,
+               t.r_->v.Store(),r_->v.Store()+offset);
+
+    if(t.i_)
+        {
+        if(!i_) allocateImag(is_.dim());
+        stridedAdd(t.r(),dims.data(),sstr.data(),dstr.data(),fac,
+                   t.i_->v.Store(),i_->v.Store()+offset);
+        }
+    }
+
 
 VectorRef ITensor::
 assignToVec() const
@@ -1511,6 +1503,44 @@ scaleOutNorm()
         }
     }
 
+//Bounds on the largest element checked by scaleOutNormIfNeeded:
+//the product of two tensors whose elements are within
+//these bounds cannot overflow or underflow
+static const Real LazyScaleMax = 1E50,
+                  LazyScaleMin = 1E-50;
+
+//Largest magnitude of the elements of v; a single
+//read-only pass over data just written by the product
+Real static
+maxAbs(const Vector& v)
+    {
+    const Real* p = v.Store();
+    const int n = v.Length();
+    Real res = 0;
+    for(int j = 0; j < n; ++j)
+        {
+        res = std::max(res,fabs(p[j]));
+        }
+    return res;
+    }
+
+void ITensor::
+scaleOutNormIfNeeded()
+    {
+    if(Global::lazyScale())
+        {
+        Real smax = maxAbs(r_->v);
+        if(i_) smax = std::max(smax,maxAbs(i_->v));
+        if(smax > LazyScaleMin && smax < LazyScaleMax)
+            {
+            __sync_add_and_fetch(&scaleStats().nskipped,1);
+            return;
+            }
+        }
+    __sync_add_and_fetch(&scaleStats().nscaled,1);
+    scaleOutNorm();
+    }
+
 void ITensor::
 scaleTo(const LogNumber& newscale)
     {
@@ -1924,23 +1954,26 @@ toMatrixProd(const ITensor& L, const ITensor& R, ProductProps& props,
         Vector rv; reshape(props.pr,R.is_,R.r_->v,rv);
         rv.TreatAsMatrix(rref,props.odimR,props.cdim);
         }
+    }
 
 #ifdef COLLECT_PRODSTATS
-    /*
-    if(L.is_.rn() > R.is_.rn()) 
-        {
-        ++(Prodstats::stats().global[std::make_pair(L.is_.rn(),R.is_.rn())]);
-        }
-    else 
-        {
-        ++(Prodstats::stats().global[std::make_pair(R.is_.rn(),L.is_.rn())]);
-        }
-    ++Prodstats::stats().total;
-    if(L_is_matrix) ++Prodstats::stats().did_matrix;
-    if(R_is_matrix) ++Prodstats::stats().did_matrix;
-    */
-#endif
+//Key under which the contraction of L and R,
+//with nc m!=1 indices in common, is recorded
+ProdKey static
+prodKey(const char* kind, const ITensor& L, const ITensor& R, 
+        int nc, bool L_is_matrix, bool R_is_matrix)
+    {
+    ProdKey key;
+    key.tag = ProdTag::current();
+    key.kind = kind;
+    key.rL = L.indices().rn();
+    key.rR = R.indices().rn();
+    key.nc = nc;
+    key.permL = !L_is_matrix;
+    key.permR = !R_is_matrix;
+    return key;
     }
+#endif
 
 
 //Non-contracting product: Cikj = Aij Bkj (no sum over j)
@@ -2100,7 +2133,7 @@ operator/=(const ITensor& other)
     
     scale_ *= other.scale_;
 
-    scaleOutNorm();
+    scaleOutNormIfNeeded();
 
     return *this;
     }
@@ -2517,27 +2550,39 @@ operator*=(const ITensor& other)
         return *this;
         }
 
+#ifdef COLLECT_PRODSTATS
+    const bool collect_ps = Prodstats::enabled();
+#endif
+
     //Handle Diag/Dense cases requiring conversion
-    if(type_==Diag && other.type_==Dense)
-        {
-        ITensor res;
-        contractDiagDense(*this,other,res);
-        this->swap(res);
-        return *this;
-        }
-    else
-    if(type_==Dense && other.type_==Diag)
-        {
-        ITensor res;
-        contractDiagDense(other,*this,res);
-        this->swap(res);
-        return *this;
-        }
-    else
-    if(type_==Diag && other.type_==Diag)
+    if(type_==Diag || other.type_==Diag)
         {
+#ifdef COLLECT_PRODSTATS
+        ProdKey ps_key;
+        Real ps_t0 = 0;
+        if(collect_ps)
+            {
+            int nc = 0;
+            for(int j = 0; j < is_.rn(); ++j)
+                if(hasindex(other,is_[j])) ++nc;
+            ps_key = prodKey("diag",*this,other,nc,true,true);
+            ps_t0 = wallTime();
+            }
+#endif
         ITensor res;
-        contractDiagDiag(*this,other,res);
+        if(type_==Diag && other.type_==Diag)
+            contractDiagDiag(*this,other,res);
+        else
+        if(type_==Diag)
+            contractDiagDense(*this,other,res);
+        else
+            contractDiagDense(other,*this,res);
+#ifdef COLLECT_PRODSTATS
+        if(collect_ps)
+            {
+            Prodstats::stats().record(ps_key,0,sizeof(Real)*res.r_->v.Length(),0,wallTime()-ps_t0);
+            }
+#endif
         this->swap(res);
         return *this;
         }
@@ -2608,6 +2653,10 @@ operator*=(const ITensor& other)
         return *this;
         }
 
+#ifdef COLLECT_PRODSTATS
+    const Real ps_t0 = (collect_ps ? wallTime() : 0);
+#endif
+
     ProductProps props(*this,other);
 
 #ifdef DEBUG
@@ -2635,10 +2684,24 @@ operator*=(const ITensor& other)
     toMatrixProd(*this,other,props,lref,rref,
                  L_is_matrix,R_is_matrix,do_matrix_multiply);
 
+#ifdef COLLECT_PRODSTATS
+    ProdKey ps_key;
+    Real ps_flops = 0,
+         ps_bytes = 0,
+         ps_t1 = 0;
+    if(collect_ps)
+        {
+        const char* kind = ((do_matrix_multiply || (L_is_matrix && R_is_matrix)) ? "gemm" : "direct");
+        ps_key = prodKey(kind,*this,other,props.nsamen,L_is_matrix,R_is_matrix);
+        ps_flops = 2.*props.odimL*props.cdim*props.odimR;
+        ps_bytes = sizeof(Real)
+                   *(Real(r_->v.Length())+other.r_->v.Length()+Real(props.odimL)*props.odimR);
+        ps_t1 = wallTime();
+        }
+#endif
+
     if(do_matrix_multiply || (L_is_matrix && R_is_matrix))
         {
-        //DO_IF_PS(++Prodstats::stats().c2;)
-
         //Do the matrix multiplication
         if(!r_.unique()) allocate();
 
@@ -2663,6 +2726,13 @@ operator*=(const ITensor& other)
         r_->v = newdat;
         }
 
+#ifdef COLLECT_PRODSTATS
+    if(collect_ps)
+        {
+        Prodstats::stats().record(ps_key,ps_flops,ps_bytes,ps_t1-ps_t0,wallTime()-ps_t1);
+        }
+#endif
+
     //Put in m==1 indices
     for(int j = 1; j <= nr1_; ++j) 
         new_index.addindex( *(new_index1_.at(j)) );
@@ -2671,7 +2741,7 @@ operator*=(const ITensor& other)
 
     scale_ *= other.scale_;
 
-    scaleOutNorm();
+    scaleOutNormIfNeeded();
 
     return *this;
     } //ITensor::operator*=(ITensor)
@@ -2817,40 +2887,17 @@ operator+=(const ITensor& other)
 
     Permutation P; 
     getperm(is_,other.is_,P);
-    Counter c(other.is_);
 
-    const int* j[NMAX+1];
-    for(int k = 1; k <= NMAX; ++k) 
+    array<int,NMAX> dims,
+                    dest;
+    for(int k = 0; k < other.is_.rn(); ++k)
         {
-        j[P.dest(k)] = &(c.i[k]);
+        dims[k] = other.is_[k].m();
+        dest[k] = P.dest(k+1)-1;
         }
 
-    int n[NMAX+1];
-    for(int k = 1; k <= NMAX; ++k) 
-        {
-        n[P.dest(k)] = c.n[k];
-        }
-
-    if(scalefac == 1)
-        {
-        for(; c.notDone(); ++c)
-            {
-            thisdat[(((((((*j[8])*n[7]+*j[7])*n[6]
-            +*j[6])*n[5]+*j[5])*n[4]+*j[4])*n[3]
-            +*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-            += othrdat[c.ind];
-            }
-        }
-    else
-        {
-        for(; c.notDone(); ++c)
-            {
-            thisdat[(((((((*j[8])*n[7]+*j[7])*n[6]
-            +*j[6])*n[5]+*j[5])*n[4]+*j[4])*n[3]
-            +*j[3])*n[2]+*j[2])*n[1]+*j[1]]
-            += scalefac * othrdat[c.ind];
-            }
-        }
+    permuteAdd(other.is_.rn(),dims.data(),dest.data(),
+               scalefac,othrdat.Store(),thisdat.Store());
 
     return *this;
     } 
@@ -2869,6 +2916,201 @@ operator-=(const ITensor& other)
     return *this; 
     }
 
+//
+// Adds sum_k a[k]*x[k][i] to y[i] for i = 0,...,n-1
+// (or sets y[i] to this sum if overwrite is true),
+// going through y in chunks small enough to stay
+// in cache while all the terms are added to them
+//
+void static
+fusedAxpy(int n,
+          const std::vector<Real>& a,
+          const std::vector<const Real*>& x,
+          Real* y, bool overwrite)
+    {
+    const int nterm = a.size();
+    const int chunk = 1024;
+    for(int i0 = 0; i0 < n; i0 += chunk)
+        {
+        const int i1 = std::min(n,i0+chunk);
+        int k = 0;
+        if(overwrite)
+            {
+            const Real a0 = a[0];
+            const Real* x0 = x[0];
+            for(int i = i0; i < i1; ++i) y[i] = a0*x0[i];
+            k = 1;
+            }
+        //Add the terms in pairs to halve
+        //the loads and stores of y
+        for(; k+1 < nterm; k += 2)
+            {
+            const Real a0 = a[k],
+                       a1 = a[k+1];
+            const Real* x0 = x[k];
+            const Real* x1 = x[k+1];
+            for(int i = i0; i < i1; ++i) y[i] += a0*x0[i] + a1*x1[i];
+            }
+        if(k < nterm)
+            {
+            const Real a0 = a[k];
+            const Real* x0 = x[k];
+            for(int i = i0; i < i1; ++i) y[i] += a0*x0[i];
+            }
+        }
+    }
+
+void
+linearComb(const std::vector<Complex>& c,
+           const std::vector<const ITensor*>& T,
+           ITensor& res, bool add)
+    {
+    if(c.size() > T.size()) Error("linearComb: more coefficients than tensors");
+
+    //Non-zero terms
+    std::vector<int> terms;
+    bool generic = (add && res.type_ == ITensor::Diag);
+    for(size_t k = 0; k < c.size(); ++k)
+        {
+        const ITensor& t = *T[k];
+        if(!t.valid() || t.scale_.isZero()) continue;
+        if(c[k].real() == 0 && c[k].imag() == 0) continue;
+        if(t.type_ == ITensor::Diag || &t == &res) generic = true;
+        terms.push_back(k);
+        }
+
+    if(generic)
+        {
+        //Diag tensors, or res is one of the T[k]:
+        //add the terms one at a time
+        ITensor sum;
+        if(add) sum = res;
+        Foreach(int k, terms)
+            {
+            if(c[k].imag() == 0) sum += c[k].real()*(*T[k]);
+            else                 sum += c[k]*(*T[k]);
+            }
+        if(!sum.valid() && !add && !c.empty()) sum = 0*(*T[0]);
+        res.swap(sum);
+        return;
+        }
+
+    if(terms.empty())
+        {
+        if(add) return;
+        res = (c.empty() || !T[0]->valid()) ? ITensor() : 0*(*T[0]);
+        return;
+        }
+
+    const ITensor& first = *T[terms.front()];
+    const bool overwrite = !(add && res.valid() && !res.scale_.isZero());
+
+    //Give res the scale of the largest term
+    LogNumber big(0);
+    Foreach(int k, terms)
+        {
+        LogNumber s = T[k]->scale_;
+        s *= std::abs(c[k]);
+        if(big.magnitudeLessThan(s)) big = s;
+        }
+    big = LogNumber(big.logNum(),1);
+
+    bool cplx = (!overwrite && res.isComplex());
+    Foreach(int k, terms)
+        {
+        if(T[k]->isComplex() || c[k].imag() != 0) cplx = true;
+        }
+
+    const int dim = first.is_.dim();
+    if(overwrite)
+        {
+        res.type_ = ITensor::Dense;
+        res.is_ = first.is_;
+        res.scale_ = big;
+        if(!(res.r_ && res.r_.unique() && res.r_->size() == dim)) res.allocate(dim);
+        if(!cplx) 
+            res.i_.reset();
+        else 
+        if(!(res.i_ && res.i_.unique() && res.i_->size() == dim)) 
+            res.allocateImag(dim);
+        }
+    else
+        {
+        if(res.scale_.magnitudeLessThan(big)) res.scaleTo(big);
+        res.solo();
+        if(cplx && !res.i_) res.allocateImag(dim);
+        }
+
+    //Coefficients and data of the terms going into the 
+    //real (n=0) and imaginary (n=1) parts of res: a,x for 
+    //those with the same index order as res, pa,px,pis 
+    //for those needing to be permuted
+    std::vector<Real> a[2],
+                      pa[2];
+    std::vector<const Real*> x[2],
+                             px[2];
+    std::vector<const IndexSet<Index>*> pis[2];
+
+    Foreach(int k, terms)
+        {
+        const ITensor& t = *T[k];
+        if(t.is_ != res.is_)
+            {
+            Print(res.is_);
+            Print(t.is_);
+            Error("linearComb: different Index structure");
+            }
+        const Real fac = (t.scale_/res.scale_).real0();
+        const Real cr = c[k].real()*fac,
+                   ci = c[k].imag()*fac;
+        const bool same_ind_order = checkSameIndOrder(res.is_,t.is_);
+
+        //(cr+i*ci)*(tr+i*ti) = (cr*tr-ci*ti) + i*(cr*ti+ci*tr)
+        const Real ca[4] = { cr, -ci, cr, ci };
+        const ITDat* src[4] = { t.r_.get(), t.i_.get(), t.i_.get(), t.r_.get() };
+        for(int j = 0; j < 4; ++j)
+            {
+            if(ca[j] == 0 || !src[j]) continue;
+            const int n = j/2;
+            if(same_ind_order)
+                {
+                a[n].push_back(ca[j]);
+                x[n].push_back(src[j]->v.Store());
+                }
+            else
+                {
+                pa[n].push_back(ca[j]);
+                px[n].push_back(src[j]->v.Store());
+                pis[n].push_back(&t.is_);
+                }
+            }
+        }
+
+    for(int n = 0; n < 2; ++n)
+        {
+        if(n == 1 && !res.i_) break;
+        Real* y = (n == 0 ? res.r_->v.Store() : res.i_->v.Store());
+
+        if(overwrite && a[n].empty()) std::fill(y,y+dim,0.);
+        fusedAxpy(dim,a[n],x[n],y,overwrite && !a[n].empty());
+
+        for(size_t j = 0; j < pa[n].size(); ++j)
+            {
+            const IndexSet<Index>& tis = *pis[n][j];
+            Permutation P; 
+            getperm(res.is_,tis,P);
+            array<int,NMAX> dims,
+                            dest;
+            for(int q = 0; q < tis.rn(); ++q)
+                {
+                dims[q] = tis[q].m();
+                dest[q] = P.dest(q+1)-1;
+                }
+            permuteAdd(tis.rn(),dims.data(),dest.data(),pa[n][j],px[n][j],y);
+            }
+        }
+    }
+
 void ITensor::
 fromMatrix11(const Index& i1, const Index& i2, const Matrix& M)
     {
@@ -3279,21 +3521,100 @@ ITDat(const ITDat& other)
     v(other.v)
     { }
 
+//
+// Storage format: 
+//
+// Version 0 (no longer written): int size, size Reals.
+//
+// Version 1: int -1, int version, int size, int pad, 
+// pad bytes, size Reals. The pad (at least 
+// StoreLink::HeaderBytes() bytes) aligns the data
+// for use in place when read through a MappedBuf.
+//
+// Both versions are read, but files written in version 1
+// (including MPS directories and LocalMPO edge files) can
+// not be read by builds from before it was introduced.
+//
+
+static const int ITDatVersion = 1;
+
 void ITDat:: 
 read(std::istream& s) 
     { 
     int size = 0;
     s.read((char*) &size,sizeof(size));
+    if(size >= 0) //version 0
+        {
+        v.ReDimension(size);
+        s.read((char*) v.Store(), sizeof(Real)*size);
+        if(!s.good()) Error("ITDat::read: ITensor data truncated");
+        return;
+        }
+
+    int version = 0,
+        pad = 0;
+    s.read((char*) &version,sizeof(version));
+    if(version != ITDatVersion)
+        {
+        Error(format("Unsupported ITensor storage version %d",version));
+        }
+    s.read((char*) &size,sizeof(size));
+    s.read((char*) &pad,sizeof(pad));
+    if(!s.good() || size < 0 || pad < 0)
+        {
+        Error("ITDat::read: corrupt ITensor storage header");
+        }
+
+    MappedBuf* mb = dynamic_cast<MappedBuf*>(s.rdbuf());
+    if(mb != 0 && pad >= StoreLink::HeaderBytes())
+        {
+        const size_t avail = mb->remaining();
+        if((size_t)pad > avail || sizeof(Real)*size > avail-pad)
+            {
+            Error("ITDat::read: ITensor data extends past the end of the mapped file");
+            }
+        mb->skip(pad);
+        char* p = mb->current();
+        if(size > 0 && (size_t)p % sizeof(Real) == 0)
+            {
+            //Use the mapped data in place
+            v.UseStorage(mb->file()->storeLink(p,size),size);
+            mb->skip(sizeof(Real)*size);
+            return;
+            }
+        }
+    else
+        {
+        s.ignore(pad);
+        }
     v.ReDimension(size);
     s.read((char*) v.Store(), sizeof(Real)*size);
+    if(!s.good()) Error("ITDat::read: ITensor data truncated");
     }
 
 
 void ITDat::
 write(std::ostream& s) const 
     { 
-    const int size = v.Length();
+    const int marker = -1,
+              size = v.Length();
+    s.write((char*) &marker, sizeof(marker));
+    s.write((char*) &ITDatVersion, sizeof(ITDatVersion));
     s.write((char*) &size, sizeof(size));
+
+    //Data starts at a multiple of align
+    const long align = (sizeof(Real)*size >= (size_t)MappedAlign ? MappedAlign : 16);
+    int pad = StoreLink::HeaderBytes();
+    const long pos = s.tellp();
+    if(pos >= 0)
+        {
+        const long start = pos + sizeof(pad) + pad;
+        pad += (align - start%align)%align;
+        }
+    s.write((char*) &pad, sizeof(pad));
+    const std::vector<char> zeros(pad,0);
+    s.write(&zeros.front(), pad);
+
     s.write((char*) v.Store(), sizeof(Real)*size); 
     }
 
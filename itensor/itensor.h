@@ -6,6 +6,7 @@
 #define __ITENSOR_ITENSOR_H
 #include "real.h"
 #include "counter.h"
+#include "prodstats.h"
 
 namespace itensor {
 
@@ -348,6 +349,30 @@ class ITensor : public safe_bool<ITensor>
     void 
     expandIndex(const Index& small, const Index& big, int start);
 
+    //
+    // sliceIndex is the reverse of expandIndex: it replaces a
+    // bigger index with a smaller one, keeping the elements with
+    // big = start+1,...,start+small.m() (start is zero-based).
+    //
+    void 
+    sliceIndex(const Index& big, const Index& small, int start);
+
+    //
+    // embed adds the elements of t to a slice of this ITensor:
+    // the indices group[1],...,group[ngroup] of t are combined as 
+    // by groupIndices (the first varying fastest) and the combined 
+    // index is placed at big = start+1,...,start+m (m being the 
+    // product of their sizes). The other indices of t must also 
+    // be indices of this ITensor, in any order.
+    //
+    // This combines, permutes and expands in one pass over the
+    // data; IQCombiner and Condenser use it to build blocks.
+    //
+    void 
+    embed(const ITensor& t, 
+          const array<Index,NMAX+1>& group, int ngroup,
+          const Index& big, int start);
+
     //Set components of rank 2 ITensor using Matrix M as input
     void 
     fromMatrix11(const Index& i1, const Index& i2, const Matrix& M);
@@ -521,6 +546,12 @@ class ITensor : public safe_bool<ITensor>
     void
     equalizeScales(ITensor& other);
 
+    //Called on the result of a contraction:
+    //calls scaleOutNorm unless Global::lazyScale()
+    //is true and the elements are of moderate size
+    void
+    scaleOutNormIfNeeded();
+
     void
     reshapeDat(const Permutation& P);
     
@@ -551,6 +582,13 @@ class ITensor : public safe_bool<ITensor>
 
     friend class commaInit;
 
+    friend class PackedTensor;
+
+    friend void
+    linearComb(const std::vector<Complex>& c,
+               const std::vector<const ITensor*>& T,
+               ITensor& res, bool add);
+
     friend void 
     contractDiagDense(const ITensor& S, const ITensor& T, ITensor& res);
 
@@ -712,6 +750,33 @@ conj(ITensor res) { res.conj(); return res; }
 ITensor inline
 dag(ITensor res) { res.dag(); return res; }
 
+//
+// Counts of the norms scaled out (nscaled) and not scaled
+// out (nskipped) after ITensor contractions, the latter 
+// only being nonzero if Global::lazyScale() is true.
+//
+struct ScaleStats
+    {
+    long nscaled,
+         nskipped;
+
+    ScaleStats()
+        :
+        nscaled(0),
+        nskipped(0)
+        { }
+    };
+
+ScaleStats inline&
+scaleStats()
+    {
+    static ScaleStats stats_;
+    return stats_;
+    }
+
+void inline
+resetScaleStats() { scaleStats() = ScaleStats(); }
+
 //
 // Computes the scalar/inner/dot product of two
 // real-valued ITensors.
@@ -735,6 +800,46 @@ Dot(const ITensor& x, const ITensor& y);
 Complex 
 BraKet(const ITensor& x, const ITensor& y);
 
+//
+// Linear combinations of tensors.
+//
+// linearComb(c,T,res) sets res to c[0]*T[0] + c[1]*T[1] + ...
+// and multiAxpy(c,T,res) adds this sum to res, using the first
+// c.size() tensors in T (which may hold more). The T[k] must all 
+// have the same indices, in any order.
+//
+// Unlike summing c[k]*T[k] one term at a time, no scaled copies
+// of the T[k] are made and the elements of res are read and written
+// once for all the terms instead of once per term. The storage of 
+// res is reused by linearComb if it has the right size and is not 
+// shared with another tensor.
+//
+template <class Tensor>
+void
+linearComb(const std::vector<Real>& c, const std::vector<Tensor>& T, Tensor& res);
+
+template <class Tensor>
+void
+linearComb(const std::vector<Complex>& c, const std::vector<Tensor>& T, Tensor& res);
+
+template <class Tensor>
+void
+multiAxpy(const std::vector<Real>& c, const std::vector<Tensor>& T, Tensor& res);
+
+template <class Tensor>
+void
+multiAxpy(const std::vector<Complex>& c, const std::vector<Tensor>& T, Tensor& res);
+
+//
+// Version of linearComb (if add is false) and 
+// multiAxpy (if add is true) taking pointers to 
+// the tensors, called by the versions above
+//
+void
+linearComb(const std::vector<Complex>& c,
+           const std::vector<const ITensor*>& T,
+           ITensor& res, bool add);
+
 //
 // Define product of IndexVal iv1 = (I1,n1), iv2 = (I2,n2)
 // (I1, I2 are Index objects; n1,n2 are type int)
@@ -1009,6 +1114,38 @@ trace(Tensor T,
 std::ostream& 
 operator<<(std::ostream & s, const ITensor& T);
 
+template <class Tensor>
+void
+linearComb(const std::vector<Complex>& c, const std::vector<Tensor>& T, Tensor& res)
+    {
+    std::vector<const Tensor*> pT(c.size());
+    for(size_t k = 0; k < c.size(); ++k) pT[k] = &T.at(k);
+    linearComb(c,pT,res,false);
+    }
+
+template <class Tensor>
+void
+linearComb(const std::vector<Real>& c, const std::vector<Tensor>& T, Tensor& res)
+    {
+    linearComb(std::vector<Complex>(c.begin(),c.end()),T,res);
+    }
+
+template <class Tensor>
+void
+multiAxpy(const std::vector<Complex>& c, const std::vector<Tensor>& T, Tensor& res)
+    {
+    std::vector<const Tensor*> pT(c.size());
+    for(size_t k = 0; k < c.size(); ++k) pT[k] = &T.at(k);
+    linearComb(c,pT,res,true);
+    }
+
+template <class Tensor>
+void
+multiAxpy(const std::vector<Real>& c, const std::vector<Tensor>& T, Tensor& res)
+    {
+    multiAxpy(std::vector<Complex>(c.begin(),c.end()),T,res);
+    }
+
 
 //
 // Deprecated older functions.
@@ -6,6 +6,8 @@
 #define __ITENSOR_LOCALMPO
 #include "mpo.h"
 #include "localop.h"
+#include "diskcache.h"
+#include "packedtensor.h"
 
 namespace itensor {
 
@@ -29,6 +31,24 @@ namespace itensor {
 //
 //  This results in an unprojected region of
 //  num_center sites starting at site j.
+//  num_center can be 2 (the default) or 1, 
+//  set by numCenter(n) or the option "NumCenter".
+//
+//  If doWrite(true) is called, edge tensors not
+//  currently in use are stored on disk. Unless the 
+//  global option "WriteAsync" is false, they are written 
+//  by a background thread, and the next edge tensor
+//  needed in the current sweep direction is read ahead.
+//
+//  Otherwise, if the option "EnvPrecision" is "Float"
+//  or "BFloat16", edge tensors not currently in use are
+//  kept in memory as PackedTensors of that precision.
+//
+//  If the option "SparseMPO" is true, the site tensors 
+//  of the MPO are also stored in sparse form (see 
+//  sparsempo.h) and product applies them element by 
+//  element, which is faster for MPOs with a large bond 
+//  dimension whose tensors are mostly zero or identity.
 //
 
 template <class Tensor>
@@ -85,6 +105,10 @@ class LocalMPO
     void
     product(const Tensor& phi, Tensor& phip) const;
 
+    void
+    product(const std::vector<Tensor>& phi, 
+            std::vector<Tensor>& phip) const;
+
     Real
     expect(const Tensor& phi) const { return lop_.expect(phi); }
 
@@ -101,6 +125,7 @@ class LocalMPO
     // to adjust the edge tensors such
     // that the MPO tensors at positions
     // b and b+1 are exposed
+    // (only b if numCenter() == 1)
     //
     template <class MPSType>
     void
@@ -166,7 +191,7 @@ class LocalMPO
     void
     numCenter(int val) 
         { 
-        if(val < 1) Error("numCenter must be set >= 1");
+        if(val < 1 || val > 2) Error("numCenter must be set to 1 or 2");
         nc_ = val; 
         }
 
@@ -191,6 +216,13 @@ class LocalMPO
     const std::string&
     writeDir() const { return writedir_; }
 
+    //Disk traffic (and time spent waiting for it)
+    //since doWrite(true) or the last resetDiskStats()
+    DiskStats
+    diskStats() const { return (cache_ ? cache_->stats() : DiskStats()); }
+    void
+    resetDiskStats() { if(cache_) cache_->resetStats(); }
+
     private:
 
     /////////////////
@@ -207,6 +239,12 @@ class LocalMPO
 
     bool do_write_;
     std::string writedir_;
+    shared_ptr<DiskCache<Tensor> > cache_;
+
+    Precision env_prec_;
+    std::vector<PackedTensor> packed_;
+
+    std::vector<SparseMPOTensor<Tensor> > sparse_;
 
     const MPSt<Tensor>* Psi_;
 
@@ -227,9 +265,25 @@ class LocalMPO
     void
     setRHlim(int val);
 
+    //Points lop_ at the MPO tensor(s) 
+    //of the center site(s) starting at b
+    void
+    updateLop(int b);
+
     void
     initWrite();
 
+    void
+    initPack(const OptSet& opts);
+
+    void
+    initSparse(const OptSet& opts);
+
+    //Packs the edge tensor PH_[from] and
+    //unpacks PH_[to] if it is null
+    void
+    swapPacked(int from, int to);
+
     std::string
     PHFName(int j) const
         {
@@ -247,6 +301,7 @@ LocalMPO()
       nc_(2),
       do_write_(false),
       writedir_("."),
+      env_prec_(DoublePrec),
       Psi_(0)
     { }
 
@@ -262,8 +317,11 @@ LocalMPO(const MPOt<Tensor>& H,
       lop_(opts),
       do_write_(false),
       writedir_("."),
+      env_prec_(DoublePrec),
       Psi_(0)
     { 
+    initPack(opts);
+    initSparse(opts);
     if(opts.defined("NumCenter"))
         numCenter(opts.getInt("NumCenter"));
     }
@@ -280,8 +338,10 @@ LocalMPO(const MPSt<Tensor>& Psi,
       lop_(opts),
       do_write_(false),
       writedir_("."),
+      env_prec_(DoublePrec),
       Psi_(&Psi)
     { 
+    initPack(opts);
     if(opts.defined("NumCenter"))
         numCenter(opts.getInt("NumCenter"));
     }
@@ -299,14 +359,17 @@ LocalMPO(const MPOt<Tensor>& H,
       lop_(opts),
       do_write_(false),
       writedir_("."),
+      env_prec_(DoublePrec),
       Psi_(0)
     { 
+    initPack(opts);
+    initSparse(opts);
     PH_[0] = LH;
     PH_[H.N()+1] = RH;
-    if(H.N()==2)
-        lop_.update(Op_->A(1),Op_->A(2),L(),R());
     if(opts.defined("NumCenter"))
         numCenter(opts.getInt("NumCenter"));
+    if(H.N()==2)
+        updateLop(1);
     }
 
 template <class Tensor>
@@ -323,8 +386,10 @@ LocalMPO(const MPSt<Tensor>& Psi,
       lop_(opts),
       do_write_(false),
       writedir_("."),
+      env_prec_(DoublePrec),
       Psi_(&Psi)
     { 
+    initPack(opts);
     PH_[0] = LP;
     PH_[Psi.N()+1] = RP;
     if(opts.defined("NumCenter"))
@@ -344,8 +409,16 @@ product(const Tensor& phi, Tensor& phip) const
         {
         int b = position();
         Tensor othr = (!L() ? dag(prime(Psi_->A(b),Link)) : L()*dag(prime(Psi_->A(b),Link)));
-        Tensor othrR = (!R() ? dag(prime(Psi_->A(b+1),Link)) : R()*dag(prime(Psi_->A(b+1),Link)));
-        othr *= othrR;
+        if(nc_ == 2)
+            {
+            Tensor othrR = (!R() ? dag(prime(Psi_->A(b+1),Link)) : R()*dag(prime(Psi_->A(b+1),Link)));
+            othr *= othrR;
+            }
+        else
+        if(R())
+            {
+            othr *= R();
+            }
 
         Complex z = (othr*phi).toComplex();
 
@@ -358,11 +431,28 @@ product(const Tensor& phi, Tensor& phip) const
         }
     }
 
+template <class Tensor> inline
+void LocalMPO<Tensor>::
+product(const std::vector<Tensor>& phi, 
+        std::vector<Tensor>& phip) const
+    {
+    if(Op_ != 0)
+        {
+        lop_.product(phi,phip);
+        return;
+        }
+    phip.resize(phi.size());
+    for(size_t j = 0; j < phi.size(); ++j)
+        {
+        product(phi[j],phip[j]);
+        }
+    }
+
 template <class Tensor>
 void inline LocalMPO<Tensor>::
 L(int j, const Tensor& nL)
     {
-    if(LHlim_ > j-1) setLHlim(j-1);
+    setLHlim(j-1);
     PH_[LHlim_] = nL;
     }
 
@@ -370,7 +460,7 @@ template <class Tensor>
 void inline LocalMPO<Tensor>::
 R(int j, const Tensor& nR)
     {
-    if(RHlim_ < j+1) setRHlim(j+1);
+    setRHlim(j+1);
     PH_[RHlim_] = nR;
     }
 
@@ -387,16 +477,9 @@ position(int b, const MPSType& psi)
     setLHlim(b-1); //not redundant since LHlim_ could be > b-1
     setRHlim(b+nc_); //not redundant since RHlim_ could be < b+nc_
 
-#ifdef DEBUG
-    if(nc_ != 2)
-        {
-        Error("LocalOp only supports 2 center sites currently");
-        }
-#endif
-
     if(Op_ != 0) //normal MPO case
         {
-        lop_.update(Op_->A(b),Op_->A(b+1),L(),R());
+        updateLop(b);
         }
     }
 
@@ -417,13 +500,6 @@ shift(int j, Direction dir, const Tensor& A)
     {
     if(this->isNull()) Error("LocalMPO is null");
 
-#ifdef DEBUG
-    if(nc_ != 2)
-        {
-        Error("LocalOp only supports 2 center sites currently");
-        }
-#endif
-
     if(dir == Fromleft)
         {
         if((j-1) != LHlim_)
@@ -439,7 +515,7 @@ shift(int j, Direction dir, const Tensor& A)
         setLHlim(j);
         setRHlim(j+nc_+1);
 
-        lop_.update(Op_->A(j+1),Op_->A(j+2),L(),R());
+        updateLop(j+1);
         }
     else //dir == Fromright
         {
@@ -456,7 +532,7 @@ shift(int j, Direction dir, const Tensor& A)
         setLHlim(j-nc_-1);
         setRHlim(j);
 
-        lop_.update(Op_->A(j-1),Op_->A(j),L(),R());
+        updateLop(j-nc_);
         }
     }
 
@@ -465,6 +541,7 @@ template <class MPSType>
 inline void LocalMPO<Tensor>::
 makeL(const MPSType& psi, int k)
     {
+    ProdTag tag("LocalMPO::makeL");
     if(!PH_.empty())
         {
         if(Op_ == 0) //Op is actually an MPS
@@ -494,6 +571,7 @@ template <class MPSType>
 inline void LocalMPO<Tensor>::
 makeR(const MPSType& psi, int k)
     {
+    ProdTag tag("LocalMPO::makeR");
     if(!PH_.empty())
         {
         if(Op_ == 0) //Op is actually an MPS
@@ -524,15 +602,17 @@ setLHlim(int val)
     {
     if(!do_write_)
         {
+        if(env_prec_ != DoublePrec) swapPacked(LHlim_,val);
         LHlim_ = val;
         return;
         }
 
     if(LHlim_ != val && PH_.at(LHlim_))
         {
-        writeToFile(PHFName(LHlim_),PH_.at(LHlim_));
+        cache_->put(PHFName(LHlim_),PH_.at(LHlim_));
         PH_.at(LHlim_) = Tensor();
         }
+    const bool forward = (val < LHlim_);
     LHlim_ = val;
     if(LHlim_ < 1) 
         {
@@ -542,18 +622,12 @@ setLHlim(int val)
         }
     if(!PH_.at(LHlim_))
         {
-        std::string fname = PHFName(LHlim_);
-        std::ifstream s(fname.c_str());
-        if(s.good())
-            {
-            PH_.at(LHlim_).read(s);
-            s.close();
-            }
-        else
-            {
-            println("Tried to read file ",fname);
-            Error("Missing file");
-            }
+        cache_->get(PHFName(LHlim_),PH_.at(LHlim_));
+        }
+    //Start reading the edge tensor needed at the next step
+    if(forward && LHlim_ > 1 && !PH_.at(LHlim_-1))
+        {
+        cache_->prefetch(PHFName(LHlim_-1));
         }
     }
 
@@ -563,15 +637,17 @@ setRHlim(int val)
     {
     if(!do_write_)
         {
+        if(env_prec_ != DoublePrec) swapPacked(RHlim_,val);
         RHlim_ = val;
         return;
         }
 
     if(RHlim_ != val && PH_.at(RHlim_))
         {
-        writeToFile(PHFName(RHlim_),PH_.at(RHlim_));
+        cache_->put(PHFName(RHlim_),PH_.at(RHlim_));
         PH_.at(RHlim_) = Tensor();
         }
+    const bool forward = (val > RHlim_);
     RHlim_ = val;
     if(RHlim_ > Op_->N()) 
         {
@@ -581,18 +657,32 @@ setRHlim(int val)
         }
     if(!PH_.at(RHlim_))
         {
-        std::string fname = PHFName(RHlim_);
-        std::ifstream s(fname.c_str());
-        if(s.good())
-            {
-            PH_.at(RHlim_).read(s);
-            s.close();
-            }
-        else
-            {
-            println("Tried to read file ",fname);
-            Error("Missing file");
-            }
+        cache_->get(PHFName(RHlim_),PH_.at(RHlim_));
+        }
+    //Start reading the edge tensor needed at the next step
+    if(forward && RHlim_ < Op_->N() && !PH_.at(RHlim_+1))
+        {
+        cache_->prefetch(PHFName(RHlim_+1));
+        }
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+updateLop(int b)
+    {
+    if(nc_ == 2)
+        {
+        lop_.update(Op_->A(b),Op_->A(b+1),L(),R());
+        }
+    else
+        {
+        //A null Op2 makes lop_ act on the single site b
+        static const Tensor null_op;
+        lop_.update(Op_->A(b),null_op,L(),R());
+        }
+    if(!sparse_.empty())
+        {
+        lop_.sparse(&sparse_.at(b),(nc_ == 2 ? &sparse_.at(b+1) : 0));
         }
     }
 
@@ -602,6 +692,49 @@ initWrite()
     {
     std::string global_write_dir = Global::opts().getString("WriteDir","./");
     writedir_ = mkTempDir("PH",global_write_dir);
+    cache_ = make_shared<DiskCache<Tensor> >(Global::opts().getBool("WriteAsync",true));
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+initPack(const OptSet& opts)
+    {
+    env_prec_ = precisionFromString(opts.getString("EnvPrecision","Double"));
+    if(env_prec_ != DoublePrec) packed_.resize(PH_.size());
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+initSparse(const OptSet& opts)
+    {
+    if(opts.getBool("SparseMPO",false)) sparseMPO(*Op_,sparse_);
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+swapPacked(int from, int to)
+    {
+    if(from == to) return;
+    if(PH_.at(from))
+        {
+        packed_.at(from) = PackedTensor(PH_[from],env_prec_);
+        PH_[from] = Tensor();
+        }
+    if(!PH_.at(to) && packed_.at(to).valid())
+        {
+        packed_[to].unpack(PH_[to]);
+        packed_[to] = PackedTensor();
+        }
+    }
+
+//Used by blockDavidson (see eigensolver.h)
+template <class Tensor>
+void inline
+blockProduct(const LocalMPO<Tensor>& A,
+             const std::vector<Tensor>& phi,
+             std::vector<Tensor>& phip)
+    {
+    A.product(phi,phip);
     }
 
 }; //namespace itensor
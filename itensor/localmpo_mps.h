@@ -70,6 +70,9 @@ class LocalMPO_MPS
     int
     size() const { return lmpo_.size(); }
 
+    int
+    numCenter() const { return lmpo_.numCenter(); }
+
     bool
     isNull() const { return Op_ == 0; }
 
@@ -83,6 +86,11 @@ class LocalMPO_MPS
     void
     doWrite(bool val) { lmpo_.doWrite(val); }
 
+    DiskStats
+    diskStats() const { return lmpo_.diskStats(); }
+    void
+    resetDiskStats() { lmpo_.resetDiskStats(); }
+
     private:
 
     /////////////////
@@ -126,10 +134,10 @@ LocalMPO_MPS(const MPOt<Tensor>& Op,
     lmps_(psis.size()),
     weight_(1)
     { 
-    lmpo_ = LocalMPOType(Op);
+    lmpo_ = LocalMPOType(Op,opts);
 
     for(size_t j = 0; j < lmps_.size(); ++j)
-        lmps_[j] = LocalMPOType(psis[j]);
+        lmps_[j] = LocalMPOType(psis[j],opts);
 
     if(opts.defined("Weight"))
         weight(opts.getReal("Weight"));
@@ -150,14 +158,14 @@ LocalMPO_MPS(const MPOt<Tensor>& Op,
     lmps_(psis.size()),
     weight_(1)
     { 
-    lmpo_ = LocalMPOType(Op,LOp,ROp);
+    lmpo_ = LocalMPOType(Op,LOp,ROp,opts);
 #ifdef DEBUG
     if(Lpsi.size() != psis.size()) Error("Lpsi must have same number of elements as psis");
     if(Rpsi.size() != psis.size()) Error("Lpsi must have same number of elements as psis");
 #endif
 
     for(size_t j = 0; j < lmps_.size(); ++j)
-        lmps_[j] = LocalMPOType(psis[j],Lpsi[j],Rpsi[j]);
+        lmps_[j] = LocalMPOType(psis[j],Lpsi[j],Rpsi[j],opts);
 
     if(opts.defined("Weight"))
         weight(opts.getReal("Weight"));
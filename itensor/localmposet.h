@@ -68,6 +68,11 @@ class LocalMPOSet
         if(val) Error("Write to disk not yet supported LocalMPOSet");
         }
 
+    DiskStats
+    diskStats() const { return DiskStats(); }
+    void
+    resetDiskStats() { }
+
     private:
 
     /////////////////
@@ -100,7 +105,7 @@ LocalMPOSet(const std::vector<MPOt<Tensor> >& Op,
     { 
     for(size_t n = 0; n < lmpo_.size(); ++n)
         {
-        lmpo_[n] = LocalMPOT(Op.at(n));
+        lmpo_[n] = LocalMPOT(Op.at(n),opts);
         }
     }
 
@@ -4,13 +4,28 @@
 //
 #ifndef __ITENSOR_LOCAL_OP
 #define __ITENSOR_LOCAL_OP
-#include "iqtensor.h"
+#include "contract.h"
+#include "sparsempo.h"
 
 #define Cout std::cout
 #define Endl std::endl
 
 namespace itensor {
 
+//Index of size n along which LocalOp::product
+//stacks a block of n tensors
+Index inline
+stackIndex(int n, const ITensor&)
+    {
+    return Index("stack",n,Link);
+    }
+
+IQIndex inline
+stackIndex(int n, const IQTensor&)
+    {
+    return IQIndex("stack",Index("stack",n,Link),QN());
+    }
+
 //
 // The LocalOp class represents
 // an MPO or other operator that
@@ -30,6 +45,15 @@ namespace itensor {
 //  can even be null in which case
 //  they will not be used.)
 //
+// If Op2 is a null (default constructed)
+// tensor, the LocalOp acts on the single
+// site of Op1 (as used for single-site DMRG).
+//
+// If sparse forms of Op1 and Op2 are provided
+// (see sparsempo.h), product applies them
+// element by element instead of contracting
+// Op1 and Op2 as dense tensors.
+//
 
 
 template <class Tensor>
@@ -63,6 +87,13 @@ class LocalOp
     void
     product(const Tensor& phi, Tensor& phip) const;
 
+    //Applies the operator to each of the tensors in phi 
+    //(all having the same indices) at once, so that 
+    //each contraction involves larger matrices
+    void
+    product(const std::vector<Tensor>& phi, 
+            std::vector<Tensor>& phip) const;
+
     Real
     expect(const Tensor& phi) const;
 
@@ -87,6 +118,12 @@ class LocalOp
     update(const Tensor& Op1, const Tensor& Op2, 
            const Tensor& L, const Tensor& R);
 
+    //Sparse forms of Op1 and Op2 used by product
+    //(S2 null if Op2 is). Reset by update.
+    void
+    sparse(const SparseMPOTensor<Tensor>* S1,
+           const SparseMPOTensor<Tensor>* S2);
+
     const Tensor&
     Op1() const 
         { 
@@ -118,12 +155,17 @@ class LocalOp
     const Tensor&
     bondTensor() const 
         { 
+        if(Op2IsNull()) return *Op1_;
         return (*Op1_) * (*Op2_);
         }
 
     bool
     isNull() const { return Op1_ == 0; }
 
+    //True if this LocalOp acts on a single site
+    bool
+    Op2IsNull() const { return Op2_ == 0 || !Op2_->valid(); }
+
     bool
     LIsNull() const;
 
@@ -143,7 +185,11 @@ class LocalOp
         Op2_ = other.Op2_;
         L_ = other.L_;
         R_ = other.R_;
+        S1_ = other.S1_;
+        S2_ = other.S2_;
         bond_ = other.bond_;
+        Lslices_ = other.Lslices_;
+        Rslices_ = other.Rslices_;
         }
 
     private:
@@ -155,8 +201,11 @@ class LocalOp
 
     const Tensor *Op1_, *Op2_; 
     const Tensor *L_, *R_; 
+    const SparseMPOTensor<Tensor> *S1_, *S2_;
     mutable int size_;
     mutable Tensor bond_;
+    mutable std::vector<Tensor> Lslices_,
+                                Rslices_;
 
     //
     /////////////////
@@ -164,6 +213,12 @@ class LocalOp
     void
     makeBond() const;
 
+    bool
+    useSparse() const;
+
+    void
+    sparseProduct(const Tensor& phi, Tensor& phip) const;
+
     };
 
 template <class Tensor>
@@ -174,6 +229,8 @@ LocalOp(const OptSet& opts)
     Op2_(0),
     L_(0),
     R_(0),
+    S1_(0),
+    S2_(0),
     size_(-1)
     { 
     }
@@ -187,6 +244,8 @@ LocalOp(const Tensor& Op1, const Tensor& Op2,
     Op2_(0),
     L_(0),
     R_(0),
+    S1_(0),
+    S2_(0),
     size_(-1)
     {
     update(Op1,Op2);
@@ -202,6 +261,8 @@ LocalOp(const Tensor& Op1, const Tensor& Op2,
     Op2_(0),
     L_(0),
     R_(0),
+    S1_(0),
+    S2_(0),
     size_(-1)
     {
     update(Op1,Op2,L,R);
@@ -215,8 +276,12 @@ update(const Tensor& Op1, const Tensor& Op2)
     Op2_ = &Op2;
     L_ = 0;
     R_ = 0;
+    S1_ = 0;
+    S2_ = 0;
     size_ = -1;
     bond_ = Tensor();
+    Lslices_.clear();
+    Rslices_.clear();
     }
 
 template <class Tensor>
@@ -229,6 +294,17 @@ update(const Tensor& Op1, const Tensor& Op2,
     R_ = &R;
     }
 
+template <class Tensor>
+void inline LocalOp<Tensor>::
+sparse(const SparseMPOTensor<Tensor>* S1,
+       const SparseMPOTensor<Tensor>* S2)
+    {
+    S1_ = S1;
+    S2_ = S2;
+    Lslices_.clear();
+    Rslices_.clear();
+    }
+
 template <class Tensor>
 bool inline LocalOp<Tensor>::
 LIsNull() const
@@ -251,33 +327,152 @@ product(const Tensor& phi, Tensor& phip) const
     {
     if(this->isNull()) Error("LocalOp is null");
 
-    const Tensor& Op1 = *Op1_;
-    const Tensor& Op2 = *Op2_;
+    ProdTag tag("LocalOp::product");
 
-    if(LIsNull())
+    if(useSparse())
         {
-        phip = phi;
+        sparseProduct(phi,phip);
+        return;
+        }
 
-        if(!RIsNull()) 
-            phip *= R(); //m^3 k d
+    //Usually contracted as ((((L*phi)*Op1)*Op2)*R),
+    //costing m^3 k d for L and R and m^2 k^2 for Op1, Op2
+    //(Op2 is skipped by contract if null)
+    phip = contract(phi,
+                    (LIsNull() ? Tensor() : L()),
+                    *Op1_,
+                    *Op2_,
+                    (RIsNull() ? Tensor() : R()));
+
+    phip.mapprime(1,0);
+    }
+
+template <class Tensor>
+bool inline LocalOp<Tensor>::
+useSparse() const
+    {
+    if(S1_ == 0) return false;
+    if(!Op2IsNull() && S2_ == 0) return false;
+    //Each link index of the sparse ops must either
+    //connect to an edge tensor or be absent
+    const SparseMPOTensor<Tensor>& Slast = (Op2IsNull() ? *S1_ : *S2_);
+    return bool(S1_->left()) != LIsNull()
+        && bool(Slast.right()) != RIsNull();
+    }
+
+//
+// The slices L_a of L at each value a of the left link
+// of Op1, and R_c of R at each value c of the right link
+// of Op2, are made once for each position. The product is
+//
+//   phip = sum_c R_c sum_b Op2_bc sum_a Op1_ab L_a phi
+//
+// where the sums only run over the nonzero elements of
+// Op1 and Op2, and applying an identity element only
+// primes the site index.
+//
+template <class Tensor>
+void inline LocalOp<Tensor>::
+sparseProduct(const Tensor& phi, Tensor& phip) const
+    {
+    typedef typename SparseMPOTensor<Tensor>::Elem
+    Elem;
+
+    const SparseMPOTensor<Tensor>& S1 = *S1_;
+    const SparseMPOTensor<Tensor>& Slast = (Op2IsNull() ? S1 : *S2_);
+
+    if(S1.left() && Lslices_.empty())
+        {
+        Lslices_.resize(S1.left().m()+1);
+        Foreach(const Elem& e, S1.elems())
+            {
+            Tensor& La = Lslices_.at(e.row);
+            if(!La) La = L()*Tensor(S1.left()(e.row));
+            }
+        }
+    if(Slast.right() && Rslices_.empty())
+        {
+        Rslices_.resize(Slast.right().m()+1);
+        Foreach(const Elem& e, Slast.elems())
+            {
+            Tensor& Rc = Rslices_.at(e.col);
+            if(!Rc) Rc = R()*Tensor(Slast.right()(e.col));
+            }
+        }
 
-        phip *= Op2; //m^2 k^2
-        phip *= Op1; //m^2 k^2
+    std::vector<Tensor> X((S1.left() ? S1.left().m() : 0)+1);
+    if(S1.left())
+        {
+        for(size_t a = 1; a < X.size(); ++a)
+            {
+            if(Lslices_[a]) X[a] = Lslices_[a]*phi;
+            }
         }
     else
         {
-        phip = phi * L(); //m^3 k d
+        X.front() = phi;
+        }
 
-        phip *= Op1; //m^2 k^2
-        phip *= Op2; //m^2 k^2
+    std::vector<Tensor> Y;
+    applySparse(S1,X,Y);
 
-        if(!RIsNull()) 
-            phip *= R();
+    if(!Op2IsNull())
+        {
+        X.swap(Y);
+        applySparse(*S2_,X,Y);
         }
 
+    if(Slast.right())
+        {
+        phip = Tensor();
+        for(size_t c = 1; c < Y.size(); ++c)
+            {
+            if(!Y[c]) continue;
+            if(!phip) phip = Y[c]*Rslices_.at(c);
+            else      phip += Y[c]*Rslices_.at(c);
+            }
+        }
+    else
+        {
+        phip = Y.front();
+        }
+    if(!phip) Error("LocalOp: sparse MPO has no nonzero elements");
+
     phip.mapprime(1,0);
     }
 
+template <class Tensor>
+void inline LocalOp<Tensor>::
+product(const std::vector<Tensor>& phi, 
+        std::vector<Tensor>& phip) const
+    {
+    const int n = phi.size();
+    phip.resize(n);
+    if(n == 0) return;
+    if(n == 1)
+        {
+        product(phi.front(),phip.front());
+        return;
+        }
+
+    //Stack the tensors along an extra index s
+    //which is left alone by product
+    const IndexT s = stackIndex(n,phi.front());
+    Tensor stack = phi.front() * Tensor(s(1));
+    for(int j = 2; j <= n; ++j)
+        {
+        stack += phi.at(j-1) * Tensor(s(j));
+        }
+
+    Tensor stackp;
+    product(stack,stackp);
+
+    for(int j = 1; j <= n; ++j)
+        {
+        phip.at(j-1) = stackp * dag(Tensor(s(j)));
+        }
+    }
+
 template <class Tensor>
 Real inline LocalOp<Tensor>::
 expect(const Tensor& phi) const
@@ -300,7 +495,7 @@ deltaRho(const Tensor& AA, const CombinerT& comb, Direction dir) const
     else //dir == Fromright
         {
         if(!RIsNull()) delta *= R();
-        delta *= (*Op2_);
+        delta *= (Op2IsNull() ? *Op1_ : *Op2_);
         }
 
     delta.noprime();
@@ -341,18 +536,21 @@ diag() const
 
     Tensor Diag = tieIndices(Op1,toTie,prime(toTie),toTie);
 
-    found = false;
-    Foreach(const IndexT& s, Op2.indices())
+    if(!Op2IsNull())
         {
-        if(s.primeLevel() == 0 && s.type() == Site) 
+        found = false;
+        Foreach(const IndexT& s, Op2.indices())
             {
-            toTie = s;
-            found = true;
-            break;
+            if(s.primeLevel() == 0 && s.type() == Site) 
+                {
+                toTie = s;
+                found = true;
+                break;
+                }
             }
+        if(!found) Error("Couldn't find Index");
+        Diag *= tieIndices(Op2,toTie,prime(toTie),toTie);
         }
-    if(!found) Error("Couldn't find Index");
-    Diag *= tieIndices(Op2,toTie,prime(toTie),toTie);
 
     if(!LIsNull())
         {
@@ -429,11 +627,21 @@ size() const
             }
 
         size_ *= findtype(*Op1_,Site).m();
-        size_ *= findtype(*Op2_,Site).m();
+        if(!Op2IsNull()) size_ *= findtype(*Op2_,Site).m();
         }
     return size_;
     }
 
+//Used by blockDavidson (see eigensolver.h)
+template <class Tensor>
+void inline
+blockProduct(const LocalOp<Tensor>& A,
+             const std::vector<Tensor>& phi,
+             std::vector<Tensor>& phip)
+    {
+    A.product(phi,phip);
+    }
+
 }; //namespace itensor
 
 #undef Cout
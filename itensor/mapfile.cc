@@ -0,0 +1,96 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "mapfile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace itensor {
+
+MappedFile* MappedFile::
+open(const std::string& fname)
+    {
+    int fd = ::open(fname.c_str(),O_RDONLY);
+    if(fd < 0) return 0;
+
+    struct stat st;
+    if(fstat(fd,&st) != 0 || st.st_size == 0)
+        {
+        ::close(fd);
+        return 0;
+        }
+
+    //MAP_PRIVATE with write access: pages written to
+    //(e.g. the storerep headers) are copied on write
+    void* p = mmap(0,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+    ::close(fd);
+    if(p == MAP_FAILED) return 0;
+
+    return new MappedFile((char*)p,st.st_size);
+    }
+
+MappedFile::
+MappedFile(char* data, size_t size)
+    :
+    data_(data),
+    size_(size),
+    nref_(1)
+    { }
+
+MappedFile::
+~MappedFile()
+    {
+    munmap(data_,size_);
+    }
+
+StoreLink MappedFile::
+storeLink(char* p, int n)
+    {
+    //Storage may be released from any thread
+    __sync_add_and_fetch(&nref_,1);
+    return StoreLink((Real*)p,n,this);
+    }
+
+void MappedFile::
+decref()
+    {
+    if(__sync_sub_and_fetch(&nref_,1) == 0) delete this;
+    }
+
+MappedBuf::
+MappedBuf(MappedFile* f)
+    :
+    f_(f)
+    {
+    setg(f->data(),f->data(),f->data()+f->size());
+    }
+
+void MappedBuf::
+skip(size_t n)
+    {
+    setg(eback(),gptr()+n,egptr());
+    }
+
+MappedBuf::pos_type MappedBuf::
+seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which)
+    {
+    char* p = 0;
+    if(dir == std::ios_base::beg)      p = eback()+off;
+    else if(dir == std::ios_base::cur) p = gptr()+off;
+    else                               p = egptr()+off;
+    if(p < eback() || p > egptr()) return pos_type(off_type(-1));
+    setg(eback(),p,egptr());
+    return pos_type(p-eback());
+    }
+
+MappedBuf::pos_type MappedBuf::
+seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+    return seekoff(off_type(pos),std::ios_base::beg,which);
+    }
+
+}; //namespace itensor
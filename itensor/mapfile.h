@@ -0,0 +1,118 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_MAPFILE_H
+#define __ITENSOR_MAPFILE_H
+
+#include <string>
+#include <streambuf>
+#include "storelink.h"
+
+namespace itensor {
+
+//
+// Tensor data written to a file by ITensor::write starts at
+// an offset which is a multiple of MappedAlign (for large
+// data) or 16 bytes (for small data), preceded by at least
+// StoreLink::HeaderBytes() bytes of padding. When the file is
+// read through a MappedBuf the data is used in place (no copy).
+//
+static const int MappedAlign = 4096;
+
+//
+// A file mapped into memory (copy-on-write: modifying
+// the memory never changes the file).
+//
+// Reference counted: it is unmapped once the reader and
+// all storage created by storeLink have released it.
+//
+class MappedFile : public ExternalStore
+    {
+    public:
+
+    //Returns 0 if fname could not be mapped
+    //(e.g. it is missing or empty)
+    static MappedFile*
+    open(const std::string& fname);
+
+    char*
+    data() const { return data_; }
+
+    size_t
+    size() const { return size_; }
+
+    //Storage of n Reals starting at p, which must lie in
+    //the mapped region after StoreLink::HeaderBytes()
+    //bytes which may be overwritten
+    StoreLink
+    storeLink(char* p, int n);
+
+    //Release the reference of the caller of open
+    void
+    close() { decref(); }
+
+    void
+    release(storerep*) { decref(); }
+
+    private:
+
+    char* data_;
+    size_t size_;
+    int nref_;
+
+    MappedFile(char* data, size_t size);
+
+    ~MappedFile();
+
+    void
+    decref();
+
+    //Not copyable
+    MappedFile(const MappedFile&);
+    void operator=(const MappedFile&);
+    };
+
+//
+// Stream buffer reading from a MappedFile,
+// for use with a std::istream
+//
+class MappedBuf : public std::streambuf
+    {
+    public:
+
+    MappedBuf(MappedFile* f);
+
+    MappedFile*
+    file() const { return f_; }
+
+    //Current read position
+    char*
+    current() const { return gptr(); }
+
+    //Number of bytes after the read position
+    size_t
+    remaining() const { return egptr()-gptr(); }
+
+    //Advance the read position by n bytes
+    void
+    skip(size_t n);
+
+    protected:
+
+    pos_type
+    seekoff(off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which = std::ios_base::in);
+
+    pos_type
+    seekpos(pos_type pos,
+            std::ios_base::openmode which = std::ios_base::in);
+
+    private:
+
+    MappedFile* f_;
+    };
+
+}; //namespace itensor
+
+#endif
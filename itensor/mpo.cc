@@ -339,6 +339,128 @@ void nmultMPO(const MPO& Aorig, const MPO& Borig, MPO& res, const OptSet&);
 template
 void nmultMPO(const IQMPO& Aorig, const IQMPO& Borig, IQMPO& res,const OptSet& );
 
+//
+// Noise term for fitMultMPO: the density matrix of the 
+// product of A and B on sites 1,...,b (or b,...,N) projected 
+// only onto the current res on the other sites of that side, 
+// scaled to the trace of the density matrix of AA
+//
+template <class Tensor>
+class MultMPONoise
+    {
+    public:
+
+    typedef typename Tensor::CombinerT
+    CombinerT;
+
+    MultMPONoise(const Tensor& lwf, const Tensor& rwf)
+        : lwf_(lwf), rwf_(rwf)
+        { }
+
+    bool
+    isNull() const { return false; }
+
+    Tensor
+    deltaRho(const Tensor& AA, const CombinerT& comb, Direction dir) const
+        {
+        Tensor delta = comb * (dir == Fromleft ? lwf_ : rwf_);
+        delta *= dag(prime(delta,comb.right()));
+        const Real tr = trace(realPart(delta));
+        if(tr > 0) delta *= sqr(AA.norm())/tr;
+        return delta;
+        }
+
+    private:
+
+    const Tensor &lwf_,
+                 &rwf_;
+    };
+
+template <class MPOType>
+void 
+fitMultMPO(const MPOType& Aorig, const MPOType& Borig, MPOType& res,
+           const OptSet& opts)
+    {
+    typedef typename MPOType::TensorT Tensor;
+    if(Aorig.N() != Borig.N()) Error("fitMultMPO: Mismatched N");
+    const int N = Aorig.N();
+    const int nsweep = opts.getInt("Nsweep",1);
+    const Real noise = opts.getReal("Noise",1E-6);
+    const bool verbose = opts.getBool("Verbose",false);
+
+    const MPOType A(Aorig);
+    MPOType B(Borig);
+    B.primeall();
+
+    //Fit C = res with its primed site indices and 
+    //links moved out of the way of those of A and B
+    MPOType C = ((&res != &Aorig && res.N() == N) ? res : A);
+    C.position(1);
+    C.primelinks(0,4);
+    C.mapprime(1,2,Site);
+
+    //L[b] is the product of A, B and dag(C) on sites 1,...,b;
+    //R[b] on sites b,...,N
+    vector<Tensor> L(N+2),
+                   R(N+2);
+    for(int n = N; n > 2; --n)
+        {
+        R.at(n) = (R.at(n+1) ? R.at(n+1)*A.A(n) : A.A(n));
+        R.at(n) *= B.A(n);
+        R.at(n) *= dag(C.A(n));
+        }
+
+    //Truncate relative to the norm of the product rather
+    //than to the fixed reference norm used for MPOs
+    const OptSet sopts = opts & Opt("DoRelCutoff",true);
+
+    for(int sw = 1; sw <= nsweep; ++sw)
+        {
+        for(int b = 1, ha = 1; ha <= 2; sweepnext(b,ha,N))
+            {
+            Tensor lwf = (L.at(b-1) ? L.at(b-1)*A.A(b) : A.A(b));
+            lwf *= B.A(b);
+            Tensor rwf = (R.at(b+2) ? R.at(b+2)*A.A(b+1) : A.A(b+1));
+            rwf *= B.A(b+1);
+
+            Spectrum spec;
+            if(ha == 1 && noise > 0)
+                {
+                //Going right, add the noise term so that the
+                //bases of res can grow beyond what the current 
+                //res on the right side can resolve; sweeping
+                //back uses the exact projection only
+                spec = denmatDecomp(lwf*rwf,C.Anc(b),C.Anc(b+1),Fromleft,
+                                    MultMPONoise<Tensor>(lwf,rwf),
+                                    sopts & Opt("Noise",noise));
+                }
+            else
+                {
+                spec = C.svdBond(b,lwf*rwf,(ha==1?Fromleft:Fromright),sopts);
+                }
+
+            if(verbose)
+                {
+                printfln("Sweep=%d, HS=%d, Bond=(%d,%d): Trunc. err=%.1E, States kept=%s",
+                         sw,ha,b,b+1,spec.truncerr(),showm(linkInd(C,b)));
+                }
+
+            if(ha == 1)
+                L.at(b) = lwf * dag(C.A(b));
+            else
+                R.at(b+1) = rwf * dag(C.A(b+1));
+            }
+        }
+
+    C.noprimelink();
+    C.mapprime(2,1,Site);
+    res = C;
+    }
+template
+void fitMultMPO(const MPO& Aorig, const MPO& Borig, MPO& res, const OptSet&);
+template
+void fitMultMPO(const IQMPO& Aorig, const IQMPO& Borig, IQMPO& res,const OptSet& );
+
 
 template <class Tensor>
 void 
@@ -496,23 +618,198 @@ fitApplyMPO(Real fac,
             MPSt<Tensor>& res,
             const OptSet& opts)
     {
+    ApplyMPOContext<Tensor> ctx(K);
+    ctx.apply(fac,psi,res,opts);
+    }
+template
+void
+fitApplyMPO(Real fac,const MPSt<ITensor>& psi,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
+template
+void
+fitApplyMPO(Real fac,const MPSt<IQTensor>& psi,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
+
+template<class Tensor>
+Real
+fitApplyMPO(const MPSt<Tensor>& psiA, 
+            Real mpofac,
+            const MPSt<Tensor>& psiB,
+            const MPOt<Tensor>& K,
+            MPSt<Tensor>& res,
+            const OptSet& opts)
+    {
+    return fitApplyMPO(1.,psiA,mpofac,psiB,K,res,opts);
+    }
+template
+Real
+fitApplyMPO(const MPSt<ITensor>& psiA, Real mpofac,const MPSt<ITensor>& psiB,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
+template
+Real
+fitApplyMPO(const MPSt<IQTensor>& psiA, Real mpofac,const MPSt<IQTensor>& psiB,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
+
+template<class Tensor>
+Real
+fitApplyMPO(Real mpsfac,
+            const MPSt<Tensor>& psiA, 
+            Real mpofac,
+            const MPSt<Tensor>& psiB,
+            const MPOt<Tensor>& K,
+            MPSt<Tensor>& res,
+            const OptSet& opts)
+    {
+    ApplyMPOContext<Tensor> ctx(K);
+    return ctx.apply(mpsfac,psiA,mpofac,psiB,res,opts);
+    }
+template
+Real
+fitApplyMPO(Real mpsfac,const MPSt<ITensor>& psiA, Real mpofac,const MPSt<ITensor>& psiB,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
+template
+Real
+fitApplyMPO(Real mpsfac,const MPSt<IQTensor>& psiA, Real mpofac,const MPSt<IQTensor>& psiB,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
+
+//
+// ApplyMPOContext
+//
+
+//True if T is the same tensor as the stored copy S
+//(cheap compared to recomputing an environment: 
+//m^2 d operations instead of m^3 k d)
+template<class Tensor>
+bool static
+sameTensor(const Tensor& T, const Tensor& S)
+    {
+    if(!T || !S) return false;
+    if(T.r() != S.r()) return false;
+    Foreach(const typename Tensor::IndexT& I, T.indices())
+        {
+        if(!hasindex(S,I)) return false;
+        }
+    Tensor diff(T);
+    diff -= S;
+    return diff.norm() == 0;
+    }
+
+template<class Tensor>
+ApplyMPOContext<Tensor>::
+ApplyMPOContext(const MPOt<Tensor>& K)
+    :
+    K_(K),
+    nreused_(0),
+    nrebuilt_(0)
+    { }
+template ApplyMPOContext<ITensor>::ApplyMPOContext(const MPOt<ITensor>& K);
+template ApplyMPOContext<IQTensor>::ApplyMPOContext(const MPOt<IQTensor>& K);
+
+template<class Tensor>
+void ApplyMPOContext<Tensor>::
+reset()
+    {
+    envK_ = Env();
+    env_ = Env();
+    }
+template void ApplyMPOContext<ITensor>::reset();
+template void ApplyMPOContext<IQTensor>::reset();
+
+template<class Tensor>
+Tensor ApplyMPOContext<Tensor>::
+rightStep(const Tensor& R,
+          const Tensor& ket,
+          const Tensor& bra,
+          int n,
+          bool withK) const
+    {
+    Tensor res = (R ? R*ket : ket);
+    if(withK)
+        {
+        res *= K_.A(n);
+        res *= dag(prime(bra));
+        }
+    else
+        {
+        res *= dag(prime(bra,Link));
+        }
+    return res;
+    }
+
+template<class Tensor>
+void ApplyMPOContext<Tensor>::
+setR(Env& E,
+     int n,
+     const Tensor& R,
+     const MPSt<Tensor>& ket,
+     const MPSt<Tensor>& res)
+    {
+    E.R.at(n) = R;
+    E.ket.at(n) = ket.A(n);
+    E.bra.at(n) = res.A(n);
+    }
+
+template<class Tensor>
+void ApplyMPOContext<Tensor>::
+clearR(Env& E, int n)
+    {
+    E.R.at(n) = Tensor();
+    E.ket.at(n) = Tensor();
+    E.bra.at(n) = Tensor();
+    }
+
+template<class Tensor>
+void ApplyMPOContext<Tensor>::
+initEnv(Env& E,
+        const MPSt<Tensor>& ket,
+        const MPSt<Tensor>& res,
+        bool withK)
+    {
+    const int N = res.N();
+    if(int(E.R.size()) != N+2)
+        {
+        E.R.assign(N+2,Tensor());
+        E.ket.assign(N+2,Tensor());
+        E.bra.assign(N+2,Tensor());
+        }
+
+    //Environments of sites 3,...,N are needed to start
+    //sweeping at bond 1; keep those for which every site
+    //tensor used is unchanged
+    int first = N+1;
+    while(first > 3 
+          && E.R.at(first-1)
+          && sameTensor(ket.A(first-1),E.ket.at(first-1))
+          && sameTensor(res.A(first-1),E.bra.at(first-1)))
+        {
+        --first;
+        }
+    nreused_ += N+1-first;
+
+    for(int n = first-1; n >= 3; --n)
+        {
+        setR(E,n,rightStep(E.R.at(n+1),ket.A(n),res.A(n),n,withK),ket,res);
+        ++nrebuilt_;
+        }
+    }
+
+template<class Tensor>
+void ApplyMPOContext<Tensor>::
+apply(Real fac,
+      const MPSt<Tensor>& psi,
+      MPSt<Tensor>& res,
+      const OptSet& opts)
+    {
     const int N = psi.N();
+    if(K_.N() != N || res.N() != N) 
+        Error("ApplyMPOContext::apply: mismatched N");
     const int nsweep = opts.getInt("Nsweep",1);
     const bool verbose = opts.getBool("Verbose",false);
     const bool normalize = opts.getBool("Normalize",true);
 
+    //Copy in case psi and res are the same MPS
     const MPSt<Tensor> origPsi(psi);
 
-    vector<Tensor> BK(N+2);
-
-    BK.at(N) = origPsi.A(N)*K.A(N)*dag(prime(res.A(N)));
-    for(int n = N-1; n > 2; --n)
-        {
-        BK.at(n) = BK.at(n+1)*origPsi.A(n)*K.A(n)*dag(prime(res.A(n)));
-        }
-
     res.position(1);
 
+    initEnv(envK_,origPsi,res,true);
+    std::vector<Tensor>& RK = envK_.R;
+    vector<Tensor> LK(N+2);
+
     for(int sw = 1; sw <= nsweep; ++sw)
         {
         for(int b = 1, ha = 1; ha <= 2; sweepnext(b,ha,N))
@@ -522,10 +819,10 @@ fitApplyMPO(Real fac,
                 println("Sweep=",sw,", HS=",ha,", Bond=(",b,",",b+1,")");
                 }
 
-            Tensor lwfK = (BK.at(b-1) ? BK.at(b-1)*origPsi.A(b) : origPsi.A(b));
-            lwfK *= K.A(b);
-            Tensor rwfK = (BK.at(b+2) ? BK.at(b+2)*origPsi.A(b+1) : origPsi.A(b+1));
-            rwfK *= K.A(b+1);
+            Tensor lwfK = (LK.at(b-1) ? LK.at(b-1)*origPsi.A(b) : origPsi.A(b));
+            lwfK *= K_.A(b);
+            Tensor rwfK = (RK.at(b+2) ? RK.at(b+2)*origPsi.A(b+1) : origPsi.A(b+1));
+            rwfK *= K_.A(b+1);
 
             Tensor wfK = lwfK*rwfK;
             wfK.noprime();
@@ -542,78 +839,62 @@ fitApplyMPO(Real fac,
                 }
 
             if(ha == 1)
-                BK.at(b) = lwfK * dag(prime(res.A(b)));
+                {
+                LK.at(b) = lwfK * dag(prime(res.A(b)));
+                //Recomputed on the way back
+                if(b+2 <= N) clearR(envK_,b+2);
+                }
             else
-                BK.at(b+1) = rwfK * dag(prime(res.A(b+1)));
+            if(b+1 >= 3)
+                {
+                setR(envK_,b+1,rwfK * dag(prime(res.A(b+1))),origPsi,res);
+                }
             }
         }
     }
-template
-void
-fitApplyMPO(Real fac,const MPSt<ITensor>& psi,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
-template
-void
-fitApplyMPO(Real fac,const MPSt<IQTensor>& psi,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
+template void ApplyMPOContext<ITensor>::
+apply(Real fac,const MPSt<ITensor>& psi,MPSt<ITensor>& res,const OptSet& opts);
+template void ApplyMPOContext<IQTensor>::
+apply(Real fac,const MPSt<IQTensor>& psi,MPSt<IQTensor>& res,const OptSet& opts);
 
 template<class Tensor>
-Real
-fitApplyMPO(const MPSt<Tensor>& psiA, 
-            Real mpofac,
-            const MPSt<Tensor>& psiB,
-            const MPOt<Tensor>& K,
-            MPSt<Tensor>& res,
-            const OptSet& opts)
-    {
-    return fitApplyMPO(1.,psiA,mpofac,psiB,K,res,opts);
-    }
-template
-Real
-fitApplyMPO(const MPSt<ITensor>& psiA, Real mpofac,const MPSt<ITensor>& psiB,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
-template
-Real
-fitApplyMPO(const MPSt<IQTensor>& psiA, Real mpofac,const MPSt<IQTensor>& psiB,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
-
-template<class Tensor>
-Real
-fitApplyMPO(Real mpsfac,
-            const MPSt<Tensor>& psiA, 
-            Real mpofac,
-            const MPSt<Tensor>& psiB,
-            const MPOt<Tensor>& K,
-            MPSt<Tensor>& res,
-            const OptSet& opts)
+Real ApplyMPOContext<Tensor>::
+apply(Real mpsfac,
+      const MPSt<Tensor>& psiA, 
+      Real mpofac,
+      const MPSt<Tensor>& psiB,
+      MPSt<Tensor>& res,
+      const OptSet& opts)
     {
     if(&psiA == &res || &psiB == &res)
         {
         Error("fitApplyMPO: Result MPS cannot be same as an input MPS");
         }
     const int N = psiA.N();
+    if(K_.N() != N || psiB.N() != N || res.N() != N) 
+        Error("ApplyMPOContext::apply: mismatched N");
     const int nsweep = opts.getInt("Nsweep",1);
 
-    vector<Tensor> B(N+2),
-                   BK(N+2);
-
-    B.at(N) = psiA.A(N)*dag(prime(res.A(N),Link));
-    BK.at(N) = psiB.A(N)*K.A(N)*dag(prime(res.A(N)));
-    for(int n = N-1; n > 2; --n)
-        {
-        B.at(n) = B.at(n+1)*psiA.A(n)*dag(prime(res.A(n),Link));
-        BK.at(n) = BK.at(n+1)*psiB.A(n)*K.A(n)*dag(prime(res.A(n)));
-        }
-
     res.position(1);
 
+    initEnv(env_,psiA,res,false);
+    initEnv(envK_,psiB,res,true);
+    std::vector<Tensor>& R = env_.R;
+    std::vector<Tensor>& RK = envK_.R;
+    vector<Tensor> L(N+2),
+                   LK(N+2);
+
     for(int sw = 1; sw <= nsweep; ++sw)
         {
         for(int b = 1, ha = 1; ha <= 2; sweepnext(b,ha,N))
             {
-            Tensor lwf = (B.at(b-1) ? B.at(b-1)*psiA.A(b) : psiA.A(b));
-            Tensor rwf = (B.at(b+2) ? psiA.A(b+1)*B.at(b+2) : psiA.A(b+1));
+            Tensor lwf = (L.at(b-1) ? L.at(b-1)*psiA.A(b) : psiA.A(b));
+            Tensor rwf = (R.at(b+2) ? psiA.A(b+1)*R.at(b+2) : psiA.A(b+1));
 
-            Tensor lwfK = (BK.at(b-1) ? BK.at(b-1)*psiB.A(b) : psiB.A(b));
-            lwfK *= K.A(b);
-            Tensor rwfK = (BK.at(b+2) ? BK.at(b+2)*psiB.A(b+1) : psiB.A(b+1));
-            rwfK *= K.A(b+1);
+            Tensor lwfK = (LK.at(b-1) ? LK.at(b-1)*psiB.A(b) : psiB.A(b));
+            lwfK *= K_.A(b);
+            Tensor rwfK = (RK.at(b+2) ? RK.at(b+2)*psiB.A(b+1) : psiB.A(b+1));
+            rwfK *= K_.A(b+1);
 
             Tensor wf = mpsfac*noprime(lwf*rwf) + mpofac*noprime(lwfK*rwfK);
             wf.noprime();
@@ -622,31 +903,34 @@ fitApplyMPO(Real mpsfac,
 
             if(ha == 1)
                 {
-                B.at(b) = lwf * dag(prime(res.A(b),Link));
-                BK.at(b) = lwfK * dag(prime(res.A(b)));
+                L.at(b) = lwf * dag(prime(res.A(b),Link));
+                LK.at(b) = lwfK * dag(prime(res.A(b)));
+                if(b+2 <= N)
+                    {
+                    clearR(env_,b+2);
+                    clearR(envK_,b+2);
+                    }
                 }
             else
+            if(b+1 >= 3)
                 {
-                B.at(b+1) = rwf * dag(prime(res.A(b+1),Link));
-                BK.at(b+1) = rwfK * dag(prime(res.A(b+1)));
+                setR(env_,b+1,rwf * dag(prime(res.A(b+1),Link)),psiA,res);
+                setR(envK_,b+1,rwfK * dag(prime(res.A(b+1))),psiB,res);
                 }
             }
         }
 
-    Tensor olp = B.at(3);
-    olp *= psiA.A(2);
+    Tensor olp = (R.at(3) ? R.at(3)*psiA.A(2) : psiA.A(2));
     olp *= dag(prime(res.A(2),Link));
     olp *= psiA.A(1);
     olp *= dag(prime(res.A(1),Link));
 
     return olp.toComplex().real();
     }
-template
-Real
-fitApplyMPO(Real mpsfac,const MPSt<ITensor>& psiA, Real mpofac,const MPSt<ITensor>& psiB,const MPOt<ITensor>& K,MPSt<ITensor>& res,const OptSet& opts);
-template
-Real
-fitApplyMPO(Real mpsfac,const MPSt<IQTensor>& psiA, Real mpofac,const MPSt<IQTensor>& psiB,const MPOt<IQTensor>& K,MPSt<IQTensor>& res,const OptSet& opts);
+template Real ApplyMPOContext<ITensor>::
+apply(Real mpsfac,const MPSt<ITensor>& psiA,Real mpofac,const MPSt<ITensor>& psiB,MPSt<ITensor>& res,const OptSet& opts);
+template Real ApplyMPOContext<IQTensor>::
+apply(Real mpsfac,const MPSt<IQTensor>& psiA,Real mpofac,const MPSt<IQTensor>& psiB,MPSt<IQTensor>& res,const OptSet& opts);
 
 template<class Tensor>
 void 
@@ -773,11 +1057,11 @@ applyExpH(const MPSt<Tensor>& psi,
                    BH(N+2);
 
     B.at(N) = psi.A(N)*dag(prime(psi.A(N),Link));
-    BH.at(N) = psi.A(N)*H.A(N)*dag(prime(psi.A(N)));
+    BH.at(N) = contract(psi.A(N),H.A(N),dag(prime(psi.A(N))));
     for(int n = N-1; n > 2; --n)
         {
         B.at(n) = B.at(n+1)*psi.A(n)*dag(prime(psi.A(n),Link));
-        BH.at(n) = BH.at(n+1)*psi.A(n)*H.A(n)*dag(prime(psi.A(n)));
+        BH.at(n) = contract(BH.at(n+1),psi.A(n),H.A(n),dag(prime(psi.A(n))));
         }
 
     lastB = B;
@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_MPO_H
 #define __ITENSOR_MPO_H
 #include "mps.h"
+#include "contract.h"
 
 
 namespace itensor {
@@ -105,10 +106,10 @@ class MPOt : private MPSt<Tensor>, public safe_bool<MPOt<Tensor> >
             }
         }
 
-    void 
+    Spectrum 
     svdBond(int b, const Tensor& AA, Direction dir, const OptSet& opts = Global::opts())
         { 
-        Parent::svdBond(b,AA,dir,opts & Opt("UseSVD") & Opt("LogRefNorm",logrefNorm_)); 
+        return Parent::svdBond(b,AA,dir,opts & Opt("UseSVD") & Opt("LogRefNorm",logrefNorm_)); 
         }
 
     //Move the orthogonality center to site i 
@@ -227,19 +228,14 @@ psiHphi(const MPSt<Tensor>& psi, const MPOt<Tensor>& H, const MPSt<Tensor>& phi,
     const int N = H.N();
     if(phi.N() != N || psi.N() != N) Error("psiHphi: mismatched N");
 
-    Tensor L = phi.A(1); 
     //Some Hamiltonians may store edge tensors in H.A(0) and H.A(N+1)
-    L *= (H.A(0) ? H.A(0)*H.A(1) : H.A(1));
-    L *= dag(prime(psi.A(1)));
+    //(contract skips them if null)
+    Tensor L = contract(H.A(0),phi.A(1),H.A(1),dag(prime(psi.A(1))));
     for(int i = 2; i < N; ++i) 
         { 
-        L *= phi.A(i); 
-        L *= H.A(i); 
-        L *= dag(prime(psi.A(i))); 
+        L = contract(L,phi.A(i),H.A(i),dag(prime(psi.A(i))));
         }
-    L *= phi.A(N); 
-    L *= H.A(N);
-    if(H.A(N+1)) L *= H.A(N+1);
+    L = contract(L,phi.A(N),H.A(N),H.A(N+1));
 
     Complex z = BraKet(prime(psi.A(N)),L);
     re = z.real();
@@ -277,14 +273,10 @@ psiHphi(const MPSt<Tensor>& psi,
     int N = psi.N();
     if(N != phi.N() || H.N() < N) Error("mismatched N in psiHphi");
 
-    Tensor L = (LB ? LB*phi.A(1) : phi.A(1));
-    L *= H.A(1); 
-    L *= dag(prime(psi.A(1)));
+    Tensor L = contract(LB,phi.A(1),H.A(1),dag(prime(psi.A(1))));
     for(int i = 2; i <= N; ++i)
         { 
-        L *= phi.A(i); 
-        L *= H.A(i); 
-        L *= dag(prime(psi.A(i))); 
+        L = contract(L,phi.A(i),H.A(i),dag(prime(psi.A(i))));
         }
 
     if(RB) L *= RB;
@@ -355,11 +347,46 @@ psiHKphiC(const MPSt<Tensor>& psi, const MPOt<Tensor>& H, const MPOt<Tensor>& K,
     return Complex(re,im);
     }
 
+//
+// Computes the product res = A*B of two MPOs, where the 
+// primed site indices of A are contracted with the unprimed 
+// ones of B, by a zip-up method: sweeping once from left to 
+// right with a density matrix decomposition at each site.
+// Recognizes the options Maxm, Minm and Cutoff.
+//
 template <class MPOType>
 void 
 nmultMPO(const MPOType& Aorig, const MPOType& Borig, MPOType& res,
          const OptSet& opts = Global::opts());
 
+//
+// Computes the same product res = A*B as nmultMPO
+// variationally, like fitApplyMPO: sweeping two-site 
+// updates of res, each the exact product projected onto
+// the current res on the other sites, while keeping the 
+// environment tensors of the product.
+//
+// Sweeping right, the density matrix of each update gets 
+// a noise term made of the product on the left side, so that
+// the bond dimension of res can grow up to Maxm even where
+// the initial res is too small to resolve the product. 
+// Sweeping back the updates are exact projections, truncated
+// relative to the norm of the product. If res is an MPO with 
+// the same number of sites as A it is used as the initial 
+// guess; otherwise A is (then for IQMPOs B must not change 
+// the quantum numbers).
+//
+// List of options recognized:
+//   Nsweep (default: 1) - number of sweeps to use
+//   Noise (default: 1E-6) - weight of the noise term
+//   Maxm, Minm, Cutoff - truncation of each update
+//   Verbose (default: false)
+//
+template <class MPOType>
+void 
+fitMultMPO(const MPOType& A, const MPOType& B, MPOType& res,
+           const OptSet& opts = Global::opts());
+
 //
 // Applies an MPO to an MPS using the zip-up method described
 // more fully in Stoudenmire and White, New. J. Phys. 12, 055026 (2010).
@@ -453,6 +480,105 @@ fitApplyMPO(Real mpsfac,
             MPSt<Tensor>& res,
             const OptSet& opts = Global::opts());
 
+//
+// ApplyMPOContext
+//
+// Applies a fixed MPO K by fitting, as fitApplyMPO does,
+// but keeps the environment tensors between calls.
+//
+// Each sweep starts at bond 1 using the environments of
+// sites 3,...,N, which the previous call leaves computed
+// for the final res. A call only recomputes those made
+// from site tensors of psi (psiA, psiB) or res that have
+// changed since, so that calling apply repeatedly with the
+// same psi (for example one sweep at a time until res
+// converges, or for the Taylor terms of exp(-tau*H)|psi>
+// with a fixed |psi>) does not rebuild them from scratch.
+//
+// Recognizes the same options as fitApplyMPO.
+//
+template<class Tensor>
+class ApplyMPOContext
+    {
+    public:
+
+    ApplyMPOContext(const MPOt<Tensor>& K);
+
+    const MPOt<Tensor>&
+    K() const { return K_; }
+
+    //|res> = fac*K|psi>, same as fitApplyMPO(fac,psi,K,res,opts)
+    void
+    apply(Real fac,
+          const MPSt<Tensor>& psi,
+          MPSt<Tensor>& res,
+          const OptSet& opts = Global::opts());
+
+    //|res> = mpsfac*|psiA> + mpofac*K|psiB>,
+    //same as fitApplyMPO(mpsfac,psiA,mpofac,psiB,K,res,opts)
+    Real
+    apply(Real mpsfac,
+          const MPSt<Tensor>& psiA,
+          Real mpofac,
+          const MPSt<Tensor>& psiB,
+          MPSt<Tensor>& res,
+          const OptSet& opts = Global::opts());
+
+    //Number of environment tensors reused from
+    //previous calls, and computed at the start of
+    //a call, so far
+    int
+    nreused() const { return nreused_; }
+    int
+    nrebuilt() const { return nrebuilt_; }
+
+    //Discard all stored environments
+    void
+    reset();
+
+    private:
+
+    //Right environment tensors R[n] of sites n,...,N,
+    //and the site tensors of the ket and bra they were
+    //computed from
+    struct Env
+        {
+        std::vector<Tensor> R,
+                            ket,
+                            bra;
+        };
+
+    MPOt<Tensor> K_;
+    Env envK_,
+        env_;
+    int nreused_,
+        nrebuilt_;
+
+    void
+    initEnv(Env& E,
+            const MPSt<Tensor>& ket,
+            const MPSt<Tensor>& res,
+            bool withK);
+
+    Tensor
+    rightStep(const Tensor& R,
+              const Tensor& ket,
+              const Tensor& bra,
+              int n,
+              bool withK) const;
+
+    void
+    setR(Env& E,
+         int n,
+         const Tensor& R,
+         const MPSt<Tensor>& ket,
+         const MPSt<Tensor>& res);
+
+    void
+    clearR(Env& E, int n);
+
+    };
+
 //Computes the exponential of the MPO H: K=exp(-tau*(H-Etot))
 template<class Tensor>
 void 
@@ -148,6 +148,18 @@ class MPSt : safe_bool<MPSt<Tensor> >
     svdBond(int b, const Tensor& AA, Direction dir, 
                 const LocalOpT& PH, const OptSet& opts = Global::opts());
 
+    //Single-site version of svdBond: sets site j to phi 
+    //and moves the orthogonality center to site j+1
+    //(dir == Fromleft) or j-1 (dir == Fromright).
+    //If the option "Noise" is > 0 and PH is a single-site
+    //LocalOp (or LocalMPO etc.), the basis kept for the bond
+    //is expanded with the states reached by H from phi
+    //(see the svdSite implementation below)
+    template <class LocalOpT>
+    Spectrum 
+    svdSite(int j, const Tensor& phi, Direction dir, 
+            const LocalOpT& PH, const OptSet& opts = Global::opts());
+
     //Move the orthogonality center to site i 
     //(leftLim() == i-1, rightLim() == i+1, orthoCenter() == i)
     void 
@@ -340,6 +352,8 @@ Spectrum MPSt<Tensor>::
 svdBond(int b, const Tensor& AA, Direction dir, 
         const BigMatrixT& PH, const OptSet& opts)
     {
+    ProdTag tag("MPS::svdBond");
+
     setBond(b);
 
     Spectrum res;
@@ -413,6 +427,82 @@ svdBond(int b, const Tensor& AA, Direction dir,
     return res;
     }
 
+//
+// The bond between site j and its neighbor k in direction dir
+// is truncated using the density matrix of phi reduced to the
+// site j side, with the noise term of denmatDecomp
+//
+//   rho = phi phi^dag + Noise * P P^dag,  P = E*W_j*phi
+//
+// where E is the edge tensor of PH on the far side of site j 
+// and W_j the MPO tensor at site j (summed over the MPO bond
+// and the old link to k). The eigenvectors of rho become site j,
+// and phi projected onto them is multiplied into site k.
+//
+// Since P spans the part of H*phi on the far side of the bond,
+// this is the subspace expansion of single-site DMRG,
+// which lets the bond dimension grow without a two-site tensor.
+//
+template <class Tensor>
+template <class LocalOpT>
+Spectrum MPSt<Tensor>::
+svdSite(int j, const Tensor& phi, Direction dir, 
+        const LocalOpT& PH, const OptSet& opts)
+    {
+    ProdTag tag("MPS::svdSite");
+
+    const int k = (dir == Fromleft ? j+1 : j-1);
+    if(dir == None || k < 1 || k > N_)
+        {
+        printfln("j=%d, N=%d",j,N_);
+        Error("svdSite: no neighboring site in direction dir");
+        }
+
+    setBond(std::min(j,k));
+
+    if(dir == Fromleft && j-1 > l_orth_lim_)
+        {
+        printfln("j=%d, l_orth_lim_=%d",j,l_orth_lim_);
+        Error("j-1 > l_orth_lim_");
+        }
+    if(dir == Fromright && j+1 < r_orth_lim_)
+        {
+        printfln("j=%d, r_orth_lim_=%d",j,r_orth_lim_);
+        Error("j+1 < r_orth_lim_");
+        }
+
+    //denmatDecomp overwrites site k with the 
+    //projection of phi onto the new basis;
+    //always use its density matrix path
+    const Tensor Ak = A_[k];
+    const OptSet dopts = opts & Opt("SVDMethod","Iterative");
+    Spectrum res;
+    if(dir == Fromleft)
+        res = denmatDecomp(phi,A_[j],A_[k],dir,PH,dopts);
+    else
+        res = denmatDecomp(phi,A_[k],A_[j],dir,PH,dopts);
+    A_[k] *= Ak;
+
+    //Normalize the ortho center if requested
+    if(opts.getBool("DoNormalize",false))
+        {
+        A_[k] *= 1./A_[k].norm();
+        }
+
+    if(dir == Fromleft)
+        {
+        l_orth_lim_ = j;
+        if(r_orth_lim_ < j+2) r_orth_lim_ = j+2;
+        }
+    else //dir == Fromright
+        {
+        if(l_orth_lim_ > j-2) l_orth_lim_ = j-2;
+        r_orth_lim_ = j;
+        }
+
+    return res;
+    }
+
 //
 // Other Methods Related to MPSt
 //
@@ -0,0 +1,241 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "packedtensor.h"
+#include <cstring>
+
+namespace itensor {
+
+using std::vector;
+
+Precision
+precisionFromString(const std::string& name)
+    {
+    if(name == "Double") return DoublePrec;
+    if(name == "Float") return FloatPrec;
+    if(name == "BFloat16") return BFloat16Prec;
+    Error("Precision name must be Double, Float or BFloat16");
+    return DoublePrec;
+    }
+
+//Rounds x to the nearest bfloat16 (upper 16 bits of a float)
+unsigned short static
+toBFloat16(float x)
+    {
+    unsigned int u = 0;
+    std::memcpy(&u,&x,sizeof(u));
+    u += 0x7FFF + ((u >> 16) & 1);
+    return (unsigned short)(u >> 16);
+    }
+
+float static
+fromBFloat16(unsigned short h)
+    {
+    const unsigned int u = ((unsigned int)h) << 16;
+    float x = 0;
+    std::memcpy(&x,&u,sizeof(x));
+    return x;
+    }
+
+//Stores the elements of v, divided by the largest of them
+//in magnitude (returned), in f or h depending on p
+Real static
+packVec(const Vector& v, Precision p,
+        vector<float>& f, vector<unsigned short>& h,
+        Real& err2, Real& norm2)
+    {
+    const int n = v.Length();
+    Real vmax = 0;
+    for(int j = 1; j <= n; ++j) vmax = std::max(vmax,std::fabs(v(j)));
+    const Real s = (vmax == 0 ? 1. : 1./vmax);
+    if(p == BFloat16Prec) h.resize(n);
+    else                  f.resize(n);
+    for(int j = 1; j <= n; ++j)
+        {
+        const float x = float(v(j)*s);
+        Real back = 0;
+        if(p == BFloat16Prec)
+            {
+            h[j-1] = toBFloat16(x);
+            back = fromBFloat16(h[j-1]);
+            }
+        else
+            {
+            f[j-1] = x;
+            back = x;
+            }
+        const Real d = v(j)*s-back;
+        err2 += d*d;
+        norm2 += sqr(v(j)*s);
+        }
+    return vmax;
+    }
+
+void static
+unpackVec(const vector<float>& f, const vector<unsigned short>& h,
+          Real vmax, Vector& v)
+    {
+    if(!h.empty())
+        {
+        for(size_t j = 0; j < h.size(); ++j) v(j+1) = vmax*fromBFloat16(h[j]);
+        }
+    else
+        {
+        for(size_t j = 0; j < f.size(); ++j) v(j+1) = vmax*f[j];
+        }
+    }
+
+PackedTensor::
+PackedTensor()
+    :
+    valid_(false),
+    prec_(DoublePrec),
+    is_iq_(false)
+    { }
+
+PackedTensor::
+PackedTensor(const ITensor& T, Precision p)
+    :
+    valid_(T.valid()),
+    prec_(p),
+    is_iq_(false)
+    {
+    if(!valid_) return;
+    if(p == DoublePrec) Error("PackedTensor: precision must be Float or BFloat16");
+    blocks_.resize(1);
+    Real err = 0;
+    packBlock(T,blocks_.front(),err);
+    recordPack(err);
+    }
+
+PackedTensor::
+PackedTensor(const IQTensor& T, Precision p)
+    :
+    valid_(T.valid()),
+    prec_(p),
+    is_iq_(true)
+    {
+    if(!valid_) return;
+    if(p == DoublePrec) Error("PackedTensor: precision must be Float or BFloat16");
+    iqinds_.assign(T.indices().begin(),T.indices().end());
+    blocks_.resize(T.blocks().size());
+    Real err = 0;
+    int n = 0;
+    Foreach(const ITensor& t, T.blocks())
+        {
+        Real berr = 0;
+        packBlock(t,blocks_[n++],berr);
+        err = std::max(err,berr);
+        }
+    recordPack(err);
+    }
+
+void PackedTensor::
+unpack(ITensor& T) const
+    {
+    if(is_iq_) Error("PackedTensor: stored tensor is an IQTensor");
+    if(!valid_)
+        {
+        T = ITensor();
+        return;
+        }
+    unpackBlock(blocks_.front(),T);
+#ifdef _OPENMP
+#pragma omp critical(itensor_packStats)
+#endif
+    ++packStats().nunpack;
+    }
+
+void PackedTensor::
+unpack(IQTensor& T) const
+    {
+    if(!is_iq_) Error("PackedTensor: stored tensor is an ITensor");
+    if(!valid_)
+        {
+        T = IQTensor();
+        return;
+        }
+    std::vector<IQIndex> inds(iqinds_);
+    T = IQTensor(inds);
+    ITensor t;
+    Foreach(const Block& b, blocks_)
+        {
+        unpackBlock(b,t);
+        T += t;
+        }
+#ifdef _OPENMP
+#pragma omp critical(itensor_packStats)
+#endif
+    ++packStats().nunpack;
+    }
+
+long PackedTensor::
+nbytes() const
+    {
+    long nb = 0;
+    Foreach(const Block& b, blocks_)
+        {
+        nb += sizeof(float)*(b.rf.size()+b.imf.size());
+        nb += sizeof(unsigned short)*(b.rh.size()+b.imh.size());
+        }
+    return nb;
+    }
+
+void PackedTensor::
+packBlock(const ITensor& t, Block& b, Real& err) const
+    {
+    b.type = int(t.type_);
+    b.is = t.is_;
+    b.scale = t.scale_;
+    Real err2 = 0,
+         norm2 = 0;
+    b.rmax = packVec(t.r_->v,prec_,b.rf,b.rh,err2,norm2);
+    b.imax = 0;
+    if(t.i_) b.imax = packVec(t.i_->v,prec_,b.imf,b.imh,err2,norm2);
+    if(norm2 > 0) err = std::sqrt(err2/norm2);
+    }
+
+void PackedTensor::
+unpackBlock(const Block& b, ITensor& t) const
+    {
+    t = ITensor();
+    t.type_ = ITensor::Type(b.type);
+    t.is_ = b.is;
+    t.scale_ = b.scale;
+    t.r_ = make_shared<ITDat>(int(b.rf.size()+b.rh.size()));
+    unpackVec(b.rf,b.rh,b.rmax,t.r_->v);
+    if(!b.imf.empty() || !b.imh.empty())
+        {
+        t.i_ = make_shared<ITDat>(int(b.imf.size()+b.imh.size()));
+        unpackVec(b.imf,b.imh,b.imax,t.i_->v);
+        }
+    }
+
+void PackedTensor::
+recordPack(Real err) const
+    {
+    const long nb = nbytes();
+#ifdef _OPENMP
+#pragma omp critical(itensor_packStats)
+#endif
+    {
+    PackStats& ps = packStats();
+    ++ps.npack;
+    ps.packed_bytes += nb;
+    ps.full_bytes += nb*(prec_ == BFloat16Prec ? 4 : 2);
+    ps.max_err = std::max(ps.max_err,err);
+    }
+    }
+
+PackStats&
+packStats()
+    {
+    static PackStats stats_;
+    return stats_;
+    }
+
+void
+resetPackStats() { packStats() = PackStats(); }
+
+}; //namespace itensor
@@ -0,0 +1,139 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PACKEDTENSOR_H
+#define __ITENSOR_PACKEDTENSOR_H
+#include "iqtensor.h"
+
+namespace itensor {
+
+//
+// Precision in which a PackedTensor stores its elements.
+//
+// Float stores each element as a single precision float,
+// BFloat16 keeps only the upper 16 bits of the float
+// (8 bits of mantissa). In both cases the elements of each
+// ITensor (or IQTensor block) are first divided by the
+// largest of them in magnitude.
+//
+enum Precision { DoublePrec, FloatPrec, BFloat16Prec };
+
+//Converts "Double", "Float" or "BFloat16" to a Precision
+Precision
+precisionFromString(const std::string& name);
+
+//
+// The PackedTensor class holds a copy of an ITensor or
+// IQTensor in reduced precision, for tensors which must
+// be kept but are not currently in use, such as the edge
+// tensors of a LocalMPO away from the current bond or
+// old Davidson vectors.
+//
+// The relative error of each tensor packed is measured
+// and collected in packStats().
+//
+class PackedTensor
+    {
+    public:
+
+    PackedTensor();
+
+    PackedTensor(const ITensor& T, Precision p);
+
+    PackedTensor(const IQTensor& T, Precision p);
+
+    //false if default constructed
+    bool
+    valid() const { return valid_; }
+
+    Precision
+    precision() const { return prec_; }
+
+    //Set T to the (reduced precision) tensor stored
+    void
+    unpack(ITensor& T) const;
+
+    void
+    unpack(IQTensor& T) const;
+
+    //Bytes used by the stored elements
+    long
+    nbytes() const;
+
+    private:
+
+    struct Block
+        {
+        int type;
+        IndexSet<Index> is;
+        LogNumber scale;
+        Real rmax,
+             imax;
+        std::vector<float> rf,
+                           imf;
+        std::vector<unsigned short> rh,
+                                    imh;
+        };
+
+    /////////////////
+    //
+    // Data Members
+    //
+
+    bool valid_;
+    Precision prec_;
+    bool is_iq_;
+    std::vector<IQIndex> iqinds_;
+    std::vector<Block> blocks_;
+
+    //
+    /////////////////
+
+    //Stores t in b, setting err to the
+    //relative error of the stored elements
+    void
+    packBlock(const ITensor& t, Block& b, Real& err) const;
+
+    void
+    unpackBlock(const Block& b, ITensor& t) const;
+
+    void
+    recordPack(Real err) const;
+
+    };
+
+//
+// Counters for PackedTensors: number of tensors packed and
+// unpacked, bytes of the tensors packed in double precision
+// and as stored, and the largest relative error ||T-P||/||T||
+// of an ITensor (or IQTensor block) T packed as P, for all
+// PackedTensors until reset by resetPackStats()
+//
+struct PackStats
+    {
+    int npack,
+        nunpack;
+    Real full_bytes,
+         packed_bytes,
+         max_err;
+
+    PackStats()
+        :
+        npack(0),
+        nunpack(0),
+        full_bytes(0),
+        packed_bytes(0),
+        max_err(0)
+        { }
+    };
+
+PackStats&
+packStats();
+
+void
+resetPackStats();
+
+}; //namespace itensor
+
+#endif
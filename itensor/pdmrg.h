@@ -0,0 +1,304 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PDMRG_H
+#define __ITENSOR_PDMRG_H
+
+#include "dmrg.h"
+#include "partition.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace itensor {
+
+//
+// Real-space parallel DMRG
+// (E.M. Stoudenmire and S.R. White, PRB 87, 155137 (2013)).
+//
+// The sites of psi are divided into the blocks of the
+// Partition P and each block is swept by its own OpenMP
+// thread using its own LocalMPO. Neighboring blocks are
+// joined through the inverse V_j = 1/Lambda_j of the singular
+// values at the bond between them:
+//
+//   psi = [block 1] V_1 [block 2] V_2 ... V_{Nb-1} [block Nb]
+//
+// Odd and even numbered blocks sweep in opposite directions,
+// so after each half sweep neighboring blocks meet at every
+// other boundary. There the two-site wavefunction A(n) V_j A(n+1)
+// is optimized and split, giving a new V_j and new edge tensors
+// for the two blocks.
+//
+// Each sweep of sweeps is a half sweep of every block in each
+// direction, with each boundary updated once. The blocks are
+// joined back into psi at the end, and the energy returned is
+// <psi|H|psi> of the normalized result.
+//
+// Each block must have at least 2 sites. In the version without a
+// Partition the N sites are divided into the number of blocks given
+// by the option "NumBlocks" (default: the number of OpenMP threads).
+//
+// The options recognized are those of dmrg; the DebugLevel
+// of the threads defaults to 0.
+//
+
+template <class Tensor>
+Real
+parallelDMRG(MPSt<Tensor>& psi,
+             const MPOt<Tensor>& H,
+             const Partition& P,
+             const Sweeps& sweeps,
+             OptSet opts = Global::opts());
+
+template <class Tensor>
+Real
+parallelDMRG(MPSt<Tensor>& psi,
+             const MPOt<Tensor>& H,
+             const Sweeps& sweeps,
+             const OptSet& opts = Global::opts())
+    {
+#ifdef _OPENMP
+    const int nthread = omp_get_max_threads();
+#else
+    const int nthread = 1;
+#endif
+    const int Nb = opts.getInt("NumBlocks",std::max(1,std::min(nthread,psi.N()/2)));
+    const Partition P(psi.N(),Nb);
+    return parallelDMRG(psi,H,P,sweeps,opts);
+    }
+
+//
+// Implementations
+//
+
+//Edge tensor E extended by the MPS tensor A
+//and MPO tensor W at the same site
+template <class Tensor>
+Tensor
+extendEdge(const Tensor& E, const Tensor& A, const Tensor& W)
+    {
+    Tensor nE = (E ? E*A : A);
+    nE *= W;
+    nE *= dag(prime(A));
+    return nE;
+    }
+
+//Optimizes the bonds of sites first,...,last of psi in
+//direction dir, returning the last energy found
+template <class Tensor>
+Real
+sweepBlock(MPSt<Tensor>& psi,
+           LocalMPO<Tensor>& PH,
+           int first,
+           int last,
+           Direction dir,
+           const OptSet& opts)
+    {
+    Real energy = NAN;
+    for(int j = 0; j < last-first; ++j)
+        {
+        const int b = (dir == Fromleft ? first+j : last-1-j);
+        PH.position(b,psi);
+        Tensor phi = psi.A(b)*psi.A(b+1);
+        energy = davidson(PH,phi,opts);
+        psi.svdBond(b,phi,dir,PH,opts);
+        }
+    return energy;
+    }
+
+template <class Tensor>
+Real
+parallelDMRG(MPSt<Tensor>& psi,
+             const MPOt<Tensor>& H,
+             const Partition& P,
+             const Sweeps& sweeps,
+             OptSet opts)
+    {
+    const bool quiet = opts.getBool("Quiet",false);
+    const int N = psi.N();
+    const int Nb = P.Nb();
+
+    if(P.end(Nb) != N) Error("parallelDMRG: Partition does not match size of psi");
+    for(int j = 1; j <= Nb; ++j)
+        {
+        if(P.size(j) < 2) Error("parallelDMRG: each block must have at least 2 sites");
+        }
+
+    opts.add("DebugLevel",opts.getInt("DebugLevel",0));
+    opts.add("DoNormalize",true);
+
+    const OptSet opts1 = opts & Opt("Cutoff",sweeps.cutoff(1))
+                              & Opt("Maxm",sweeps.maxm(1));
+
+    //
+    // Split psi into blocks:
+    // going left to right from a right-orthogonal psi, at the
+    // last bond n of each block j write A(n) A(n+1) = U D B and
+    // set A(n) = U*D, A(n+1) = D*B, V_j = 1/D. The edge tensors
+    // of the blocks are those of U and of B.
+    //
+    psi.position(1);
+
+    std::vector<Tensor> Renv(N+2);
+    for(int n = N; n > 1; --n)
+        {
+        Renv.at(n) = extendEdge(Renv.at(n+1),psi.A(n),H.A(n));
+        }
+
+    std::vector<Tensor> V(Nb+1),
+                        LE(Nb+1),
+                        RE(Nb+1);
+    Tensor L;
+    for(int n = 1, j = 1; n < N; ++n)
+        {
+        Tensor D;
+        svd(psi.A(n)*psi.A(n+1),psi.Anc(n),D,psi.Anc(n+1),opts1);
+        D /= D.norm();
+        L = extendEdge(L,psi.A(n),H.A(n));
+        if(n == P.end(j))
+            {
+            LE.at(j+1) = L;
+            RE.at(j) = extendEdge(Renv.at(n+2),psi.A(n+1),H.A(n+1));
+            V.at(j) = dag(D);
+            V.at(j).pseudoInvert(0);
+            psi.Anc(n) *= D;
+            ++j;
+            }
+        psi.Anc(n+1) *= D;
+        }
+
+    //Even numbered blocks start with their
+    //orthogonality center at their left edge
+    for(int j = 2; j <= Nb; j += 2)
+        {
+        for(int n = P.end(j)-1; n >= P.begin(j); --n)
+            {
+            Tensor D;
+            svd(psi.A(n)*psi.A(n+1),psi.Anc(n),D,psi.Anc(n+1),opts1);
+            psi.Anc(n) *= D;
+            }
+        }
+
+    std::vector<MPSt<Tensor> > bpsi(Nb+1,psi);
+    std::vector<LocalMPO<Tensor> > PH(Nb+1,LocalMPO<Tensor>(H,opts));
+    for(int j = 1; j <= Nb; ++j)
+        {
+        const int oc = (j%2 == 1 ? P.end(j) : P.begin(j));
+        bpsi[j].leftLim(oc-1);
+        bpsi[j].rightLim(oc+1);
+        PH[j].L(P.begin(j),LE[j]);
+        PH[j].R(P.end(j),RE[j]);
+        }
+
+    //Last energies found in each block (benergy[j]) and at
+    //the boundary between blocks j and j+1 (bdenergy[j]),
+    //kept apart since they are found in different bases.
+    //Each sweep reports the lowest boundary energy (the
+    //block energy if there is only one block)
+    std::vector<Real> benergy(Nb+1,NAN),
+                      bdenergy(Nb,NAN);
+    Real energy = NAN;
+
+    for(int sw = 1; sw <= sweeps.nsweep(); ++sw)
+        {
+        opts.add("Sweep",sw);
+        opts.add("Cutoff",sweeps.cutoff(sw));
+        opts.add("Minm",sweeps.minm(sw));
+        opts.add("Maxm",sweeps.maxm(sw));
+        opts.add("Noise",sweeps.noise(sw));
+        opts.add("MaxIter",sweeps.niter(sw));
+
+        for(int ha = 1; ha <= 2; ++ha)
+            {
+            //On the first half sweep odd numbered blocks
+            //sweep right to left and even ones left to right,
+            //then the reverse
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(int j = 1; j <= Nb; ++j)
+                {
+                const Direction dir = ((j%2 == 1) == (ha == 1) ? Fromright : Fromleft);
+                benergy[j] = sweepBlock(bpsi[j],PH[j],P.begin(j),P.end(j),dir,opts);
+                }
+
+            //Update the boundaries where the blocks now meet:
+            //block j at its last site n, block j+1 at site n+1
+            const int nbound = (ha == 1 ? (Nb-1)/2 : Nb/2);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(int k = 0; k < nbound; ++k)
+                {
+                const int j = (ha == 1 ? 2 : 1) + 2*k,
+                          n = P.end(j);
+                MPSt<Tensor> &lpsi = bpsi[j],
+                             &rpsi = bpsi[j+1];
+
+                const Tensor LH = extendEdge(PH[j].L(),lpsi.A(n-1),H.A(n-1)),
+                             RH = extendEdge(PH[j+1].R(),rpsi.A(n+2),H.A(n+2));
+                LocalOp<Tensor> lop(H.A(n),H.A(n+1),LH,RH,opts);
+
+                Tensor phi = lpsi.A(n)*V[j]*rpsi.A(n+1);
+                bdenergy[j] = davidson(lop,phi,opts);
+
+                Tensor U = lpsi.A(n),
+                       B = rpsi.A(n+1),
+                       D;
+                svd(phi,U,D,B,opts);
+                D /= D.norm();
+
+                PH[j].R(n,extendEdge(RH,B,H.A(n+1)));
+                PH[j+1].L(n+1,extendEdge(LH,U,H.A(n)));
+
+                lpsi.Anc(n) = U*D;
+                rpsi.Anc(n+1) = D*B;
+                V[j] = dag(D);
+                V[j].pseudoInvert(0);
+                }
+            }
+
+        energy = (Nb == 1 ? benergy[1] : bdenergy[1]);
+        for(int j = 2; j < Nb; ++j) energy = std::min(energy,bdenergy[j]);
+
+        if(!quiet)
+            {
+            int maxm = 1;
+            for(int j = 1; j <= Nb; ++j)
+                {
+                for(int b = P.begin(j); b < P.end(j); ++b)
+                    {
+                    maxm = std::max(maxm,linkInd(bpsi[j],b).m());
+                    }
+                }
+            printfln("    Parallel DMRG sweep %d: energy %.12f, largest m %d (%d blocks)",
+                     sw,energy,maxm,Nb);
+            }
+        }
+
+    //Join the blocks back into psi
+    for(int j = 1; j <= Nb; ++j)
+        {
+        for(int n = P.begin(j); n <= P.end(j); ++n)
+            {
+            psi.Anc(n) = bpsi[j].A(n);
+            }
+        if(j < Nb) psi.Anc(P.end(j)) *= V[j];
+        }
+    psi.position(1);
+    psi.normalize();
+
+    energy = psiHphi(psi,H,psi);
+    if(!quiet)
+        {
+        printfln("    Parallel DMRG energy after joining blocks %.12f",energy);
+        }
+    return energy;
+    }
+
+}; //namespace itensor
+
+
+#endif
@@ -0,0 +1,378 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "permute.h"
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace itensor {
+
+//Edge length of the square tiles used when the
+//fastest index moves; two 32x32 tiles of doubles
+//(16KB) stay resident in a typical L1 cache
+static const int PermuteTile = 32;
+
+//Don't start threads for tensors smaller than this
+static const long PermuteParallelSize = 1L << 16;
+
+//Max number of loop dimensions: NMAX indices
+//plus the two tile-block counters
+static const int PermuteMaxLoops = NMAX+2;
+
+//
+// Element operations, applied as op(dst_elem,src_elem)
+//
+
+struct PermAssign
+    {
+    void
+    operator()(Real& d, Real s) const { d = s; }
+
+    void
+    run(Real* d, const Real* s, long n) const
+        { std::copy(s,s+n,d); }
+
+#ifdef __SSE2__
+    void
+    store2(Real* d, __m128d v) const { _mm_storeu_pd(d,v); }
+#endif
+    };
+
+struct PermAddScaled
+    {
+    Real fac;
+
+    explicit
+    PermAddScaled(Real f) : fac(f) { }
+
+    void
+    operator()(Real& d, Real s) const { d += fac*s; }
+
+    void
+    run(Real* d, const Real* s, long n) const
+        { for(long k = 0; k < n; ++k) d[k] += fac*s[k]; }
+
+#ifdef __SSE2__
+    void
+    store2(Real* d, __m128d v) const
+        {
+        _mm_storeu_pd(d,_mm_add_pd(_mm_loadu_pd(d),_mm_mul_pd(_mm_set1_pd(fac),v)));
+        }
+#endif
+    };
+
+//
+// A PermPlan describes the copy as a set of
+// nested loops (an "odometer") over work items.
+//
+// If some dimension has stride 1 in both src and dst,
+// each work item is a contiguous run of length "run".
+//
+// Otherwise, if the dimension "a" with stride 1 in src and 
+// "b" with stride 1 in dst both exist, loops 0 and 1 count 
+// tiles of these dimensions (a has stride dsa in dst and b 
+// stride ssb in src) and each work item is a tile.
+//
+// Failing both (only possible for general strides), each work
+// item is a strided run along the dimension with the smallest
+// dst stride.
+//
+struct PermPlan
+    {
+    int nloop;
+    array<long,PermuteMaxLoops> n,  //extent of each loop
+                                ss, //src offset per step
+                                ds; //dst offset per step
+    long nitem;
+
+    bool tiled;
+    long run, 
+         srun, drun; //src and dst strides of a run
+    long na, nb, ssb, dsa;
+
+    PermPlan(int rank, const int* dims, 
+             const long* sstr, const long* dstr);
+    };
+
+PermPlan::
+PermPlan(int rank, const int* dims, 
+         const long* sstr, const long* dstr)
+    :
+    nloop(0),
+    nitem(1),
+    tiled(false),
+    run(1),
+    srun(1), drun(1),
+    na(1), nb(1), ssb(1), dsa(1)
+    {
+    //Drop extent 1 dimensions and fuse neighbors 
+    //which are contiguous in both src and dst
+    int f = 0;
+    array<long,NMAX> fm, fs, fd;
+    for(int j = 0; j < rank; ++j)
+        {
+        if(dims[j] == 1) continue;
+        if(f > 0 && sstr[j] == fs[f-1]*fm[f-1] 
+                 && dstr[j] == fd[f-1]*fm[f-1])
+            {
+            fm[f-1] *= dims[j];
+            continue;
+            }
+        fm[f] = dims[j];
+        fs[f] = sstr[j];
+        fd[f] = dstr[j];
+        ++f;
+        }
+
+    if(f == 0)
+        {
+        return;
+        }
+
+    //a: smallest src stride, b: smallest dst stride
+    int a = 0, 
+        b = 0;
+    for(int j = 1; j < f; ++j)
+        {
+        if(fs[j] < fs[a]) a = j;
+        if(fd[j] < fd[b]) b = j;
+        }
+
+    int skip = -1;
+    if(fs[a] == 1 && fd[a] == 1)
+        {
+        run = fm[a];
+        skip = a;
+        }
+    else
+    if(fs[a] == 1 && fd[b] == 1)
+        {
+        tiled = true;
+        na = fm[a];
+        nb = fm[b];
+        ssb = fs[b];
+        dsa = fd[a];
+
+        n[0] = (na+PermuteTile-1)/PermuteTile;
+        ss[0] = PermuteTile;
+        ds[0] = PermuteTile*dsa;
+
+        n[1] = (nb+PermuteTile-1)/PermuteTile;
+        ss[1] = PermuteTile*ssb;
+        ds[1] = PermuteTile;
+
+        nloop = 2;
+        }
+    else
+        {
+        run = fm[b];
+        srun = fs[b];
+        drun = fd[b];
+        skip = b;
+        }
+
+    for(int j = 0; j < f; ++j)
+        {
+        if(j == skip || (tiled && (j == a || j == b))) continue;
+        n[nloop] = fm[j];
+        ss[nloop] = fs[j];
+        ds[nloop] = fd[j];
+        ++nloop;
+        }
+
+    for(int l = 0; l < nloop; ++l)
+        nitem *= n[l];
+    }
+
+//
+// Copy one na x nb tile: dst(ia*dsa+ib) = src(ia+ib*ssb)
+//
+template <class Op>
+void static
+permTile(const Real* src, long ssb,
+         Real* dst, long dsa,
+         long na, long nb,
+         const Op& op)
+    {
+    long ia = 0;
+#ifdef __SSE2__
+    //2x2 register transposes: two contiguous
+    //loads from src give two contiguous stores to dst
+    for(; ia+1 < na; ia += 2)
+        {
+        const Real* s0 = src+ia;
+        Real* d0 = dst+ia*dsa;
+        Real* d1 = d0+dsa;
+        long ib = 0;
+        for(; ib+1 < nb; ib += 2)
+            {
+            const __m128d x = _mm_loadu_pd(s0+ib*ssb),
+                          y = _mm_loadu_pd(s0+(ib+1)*ssb);
+            op.store2(d0+ib,_mm_unpacklo_pd(x,y));
+            op.store2(d1+ib,_mm_unpackhi_pd(x,y));
+            }
+        for(; ib < nb; ++ib)
+            {
+            op(d0[ib],s0[ib*ssb]);
+            op(d1[ib],s0[ib*ssb+1]);
+            }
+        }
+#endif
+    for(; ia < na; ++ia)
+        {
+        const Real* s0 = src+ia;
+        Real* d0 = dst+ia*dsa;
+        for(long ib = 0; ib < nb; ++ib)
+            op(d0[ib],s0[ib*ssb]);
+        }
+    }
+
+//
+// Do work items [begin,end) of the plan
+//
+template <class Op>
+void static
+permRange(const PermPlan& p, long begin, long end,
+          const Real* src, Real* dst, const Op& op)
+    {
+    if(begin >= end) return;
+
+    array<long,PermuteMaxLoops> i;
+    long soff = 0,
+         doff = 0,
+         rem = begin;
+    for(int l = 0; l < p.nloop; ++l)
+        {
+        i[l] = rem % p.n[l];
+        rem /= p.n[l];
+        soff += i[l]*p.ss[l];
+        doff += i[l]*p.ds[l];
+        }
+
+    for(long w = begin; w < end; ++w)
+        {
+        if(p.tiled)
+            {
+            const long ta = std::min<long>(PermuteTile,p.na-i[0]*PermuteTile),
+                       tb = std::min<long>(PermuteTile,p.nb-i[1]*PermuteTile);
+            permTile(src+soff,p.ssb,dst+doff,p.dsa,ta,tb,op);
+            }
+        else
+        if(p.srun == 1 && p.drun == 1)
+            {
+            op.run(dst+doff,src+soff,p.run);
+            }
+        else
+            {
+            Real* d = dst+doff;
+            const Real* s = src+soff;
+            for(long k = 0; k < p.run; ++k)
+                op(d[k*p.drun],s[k*p.srun]);
+            }
+
+        //Advance the odometer
+        for(int l = 0; l < p.nloop; ++l)
+            {
+            ++i[l];
+            soff += p.ss[l];
+            doff += p.ds[l];
+            if(i[l] < p.n[l]) break;
+            soff -= p.n[l]*p.ss[l];
+            doff -= p.n[l]*p.ds[l];
+            i[l] = 0;
+            }
+        }
+    }
+
+template <class Op>
+void static
+permuteImpl(int rank, const int* dims, 
+            const long* sstr, const long* dstr,
+            const Real* src, Real* dst, const Op& op)
+    {
+    const PermPlan p(rank,dims,sstr,dstr);
+
+#ifdef _OPENMP
+    long size = 1;
+    for(int j = 0; j < rank; ++j) size *= dims[j];
+    if(size >= PermuteParallelSize && p.nitem > 1 && omp_get_max_threads() > 1)
+        {
+#pragma omp parallel
+            {
+            const long nt = omp_get_num_threads(),
+                       t = omp_get_thread_num();
+            permRange(p,(t*p.nitem)/nt,((t+1)*p.nitem)/nt,src,dst,op);
+            }
+        return;
+        }
+#endif
+
+    permRange(p,0,p.nitem,src,dst,op);
+    }
+
+//Strides of src (the first index fastest) and of
+//dst (index j of src moved to dest[j])
+void static
+permStrides(int rank, const int* dims, const int* dest,
+            array<long,NMAX>& sstr, array<long,NMAX>& dstr)
+    {
+    array<long,NMAX> ddims;
+    long s = 1;
+    for(int j = 0; j < rank; ++j)
+        {
+        sstr[j] = s;
+        s *= dims[j];
+        ddims[dest[j]] = dims[j];
+        }
+    array<long,NMAX> pos;
+    s = 1;
+    for(int k = 0; k < rank; ++k)
+        {
+        pos[k] = s;
+        s *= ddims[k];
+        }
+    for(int j = 0; j < rank; ++j)
+        dstr[j] = pos[dest[j]];
+    }
+
+void
+permuteData(int rank, const int* dims, const int* dest,
+            const Real* src, Real* dst)
+    {
+    array<long,NMAX> sstr, dstr;
+    permStrides(rank,dims,dest,sstr,dstr);
+    permuteImpl(rank,dims,sstr.data(),dstr.data(),src,dst,PermAssign());
+    }
+
+void
+permuteAdd(int rank, const int* dims, const int* dest,
+           Real fac, const Real* src, Real* dst)
+    {
+    array<long,NMAX> sstr, dstr;
+    permStrides(rank,dims,dest,sstr,dstr);
+    permuteImpl(rank,dims,sstr.data(),dstr.data(),src,dst,PermAddScaled(fac));
+    }
+
+void
+stridedCopy(int rank, const int* dims,
+            const long* sstr, const long* dstr,
+            const Real* src, Real* dst)
+    {
+    permuteImpl(rank,dims,sstr,dstr,src,dst,PermAssign());
+    }
+
+void
+stridedAdd(int rank, const int* dims,
+           const long* sstr, const long* dstr,
+           Real fac, const Real* src, Real* dst)
+    {
+    permuteImpl(rank,dims,sstr,dstr,src,dst,PermAddScaled(fac));
+    }
+
+}; //namespace itensor
@@ -0,0 +1,84 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PERMUTE_H
+#define __ITENSOR_PERMUTE_H
+#include "global.h"
+
+namespace itensor {
+
+//
+// Dense tensor transpose kernels.
+//
+// The data src is a tensor of rank "rank" with dimensions
+// dims[0], dims[1], ..., dims[rank-1], stored with the
+// first index varying fastest (the ITensor convention).
+//
+// Index j of src becomes index dest[j] of the result
+// (dest is zero-indexed, so dest[j] == 0 means the jth
+// index of src is the fastest-varying index of dst).
+//
+// Extents equal to 1 are dropped and neighboring indices
+// which remain neighbors are fused before the copy, so
+// for example any rank 3 permutation keeping the first
+// index in place reduces to a single strided memcpy loop.
+//
+// Permutations which move the fastest index are done in
+// cache-sized tiles over the two fastest-moving dimensions
+// of src and dst. When compiled with OpenMP, large tensors
+// are split across threads.
+//
+// src and dst must not overlap.
+//
+
+//dst = P(src)
+void
+permuteData(int rank,
+            const int* dims,
+            const int* dest,
+            const Real* src,
+            Real* dst);
+
+//dst += fac * P(src)
+void
+permuteAdd(int rank,
+           const int* dims,
+           const int* dest,
+           Real fac,
+           const Real* src,
+           Real* dst);
+
+//
+// General strided versions, for example to copy a tensor 
+// into (or out of) part of a larger tensor, or to fuse a 
+// permutation with a change of the shape of the result:
+//
+// dst[i_0*dstr[0]+...+i_{r-1}*dstr[r-1]] 
+//    = src[i_0*sstr[0]+...+i_{r-1}*sstr[r-1]]
+//
+// for all 0 <= i_j < dims[j]. The elements of dst
+// written to must be distinct.
+//
+
+void
+stridedCopy(int rank,
+            const int* dims,
+            const long* sstr,
+            const long* dstr,
+            const Real* src,
+            Real* dst);
+
+//dst[...] += fac * src[...]
+void
+stridedAdd(int rank,
+           const int* dims,
+           const long* sstr,
+           const long* dstr,
+           Real fac,
+           const Real* src,
+           Real* dst);
+
+}; //namespace itensor
+
+#endif
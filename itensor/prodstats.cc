@@ -0,0 +1,251 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#include "prodstats.h"
+#include <algorithm>
+#include <vector>
+
+namespace itensor {
+
+using std::string;
+using std::vector;
+using std::ostream;
+
+bool ProdKey::
+operator<(const ProdKey& o) const
+    {
+    if(tag != o.tag) return tag < o.tag;
+    if(kind != o.kind) return kind < o.kind;
+    if(rL != o.rL) return rL < o.rL;
+    if(rR != o.rR) return rR < o.rR;
+    if(nc != o.nc) return nc < o.nc;
+    if(permL != o.permL) return permL < o.permL;
+    return permR < o.permR;
+    }
+
+string ProdKey::
+shape() const
+    {
+    string res = format("%dx%d/%d",rL,rR,nc);
+    if(permL && permR) res += " (L,R perm)";
+    else if(permL)     res += " (L perm)";
+    else if(permR)     res += " (R perm)";
+    return res;
+    }
+
+bool& Prodstats::
+enabled()
+    {
+    static bool enabled_ = false;
+    return enabled_;
+    }
+
+Prodstats& Prodstats::
+stats()
+    {
+    static Prodstats stats_;
+    return stats_;
+    }
+
+void Prodstats::
+record(const ProdKey& key,
+       Real flops,
+       Real bytes,
+       Real reshape_time,
+       Real mult_time)
+    {
+#ifdef _OPENMP
+#pragma omp critical(itensor_prodStats)
+#endif
+    {
+    ProdEntry& e = table_[key];
+    ++e.count;
+    e.flops += flops;
+    e.bytes += bytes;
+    e.reshape_time += reshape_time;
+    e.mult_time += mult_time;
+    }
+    }
+
+ProdEntry Prodstats::
+total() const
+    {
+    ProdEntry tot;
+    for(Table::const_iterator it = table_.begin(); it != table_.end(); ++it)
+        {
+        const ProdEntry& e = it->second;
+        tot.count += e.count;
+        tot.flops += e.flops;
+        tot.bytes += e.bytes;
+        tot.reshape_time += e.reshape_time;
+        tot.mult_time += e.mult_time;
+        }
+    return tot;
+    }
+
+void Prodstats::
+reset()
+    {
+#ifdef _OPENMP
+#pragma omp critical(itensor_prodStats)
+#endif
+    table_.clear();
+    }
+
+typedef std::pair<ProdKey,ProdEntry>
+ProdItem;
+
+struct ProdOrder
+    {
+    string sortby;
+
+    ProdOrder(const string& sortby_) : sortby(sortby_) { }
+
+    Real
+    value(const ProdEntry& e) const
+        {
+        if(sortby == "flops") return e.flops;
+        if(sortby == "bytes") return e.bytes;
+        if(sortby == "count") return e.count;
+        return e.time();
+        }
+
+    bool
+    operator()(const ProdItem& a, const ProdItem& b) const
+        {
+        return value(a.second) > value(b.second);
+        }
+    };
+
+void Prodstats::
+report(ostream& s, const string& sortby) const
+    {
+    if(sortby != "time" && sortby != "flops" && sortby != "bytes" && sortby != "count")
+        {
+        Error("Prodstats::report: sortby must be time, flops, bytes or count");
+        }
+
+    vector<ProdItem> items(table_.begin(),table_.end());
+    std::stable_sort(items.begin(),items.end(),ProdOrder(sortby));
+
+    const ProdEntry tot = total();
+
+    s << format("Contraction profile (%d contractions, %.3f GFlop, %.3f s), sorted by %s\n",
+                tot.count,tot.flops/1E9,tot.time(),sortby);
+    s << format("%-24s %-8s %-18s %10s %10s %10s %9s %9s %8s %6s\n",
+                "Tag","Kind","Shape","Count","GFlop","MB","Reshape s","Mult s","GFlop/s","%Time");
+    Foreach(const ProdItem& it, items)
+        {
+        const ProdKey& k = it.first;
+        const ProdEntry& e = it.second;
+        const Real t = e.time();
+        s << format("%-24s %-8s %-18s %10d %10.3f %10.1f %9.3f %9.3f %8.2f %6.1f\n",
+                    (k.tag.empty() ? string("(none)") : k.tag),
+                    k.kind,
+                    k.shape(),
+                    e.count,
+                    e.flops/1E9,
+                    e.bytes/1E6,
+                    e.reshape_time,
+                    e.mult_time,
+                    (t > 0 ? e.flops/t/1E9 : 0.),
+                    (tot.time() > 0 ? 100*t/tot.time() : 0.));
+        }
+    }
+
+void Prodstats::
+writeJSON(ostream& s) const
+    {
+    s << "[";
+    bool first = true;
+    for(Table::const_iterator it = table_.begin(); it != table_.end(); ++it)
+        {
+        const ProdKey& k = it->first;
+        const ProdEntry& e = it->second;
+        s << (first ? "\n" : ",\n");
+        first = false;
+        s << format("  {\"tag\": \"%s\", \"kind\": \"%s\", \"rankL\": %d, \"rankR\": %d, \"ncontracted\": %d, ",
+                    k.tag,k.kind,k.rL,k.rR,k.nc);
+        s << format("\"permL\": %s, \"permR\": %s, ",
+                    (k.permL ? "true" : "false"),(k.permR ? "true" : "false"));
+        s << format("\"count\": %d, \"flops\": %.6e, \"bytes\": %.6e, \"reshape_time\": %.6e, \"mult_time\": %.6e}",
+                    e.count,e.flops,e.bytes,e.reshape_time,e.mult_time);
+        }
+    s << "\n]\n";
+    }
+
+//
+// ProdTag
+//
+
+static const char* prod_tag_ = "";
+#ifdef _OPENMP
+#pragma omp threadprivate(prod_tag_)
+#endif
+
+ProdTag::
+ProdTag(const char* tag)
+    :
+    prev_(prod_tag_)
+    {
+    prod_tag_ = tag;
+    }
+
+ProdTag::
+~ProdTag()
+    {
+    prod_tag_ = prev_;
+    }
+
+const char* ProdTag::
+current()
+    {
+    return prod_tag_;
+    }
+
+//
+// Turn on collection if ITENSOR_PRODSTATS is set,
+// reporting at exit
+//
+
+void static
+prodStatsAtExit()
+    {
+    const char* val = std::getenv("ITENSOR_PRODSTATS");
+    if(!val) return;
+    const string sval(val);
+    const string json = ".json";
+    if(sval.size() > json.size()
+       && sval.compare(sval.size()-json.size(),json.size(),json) == 0)
+        {
+        std::ofstream f(val);
+        if(!f.good())
+            {
+            std::cerr << "Prodstats: couldn't open file \"" << sval << "\" for writing" << std::endl;
+            return;
+            }
+        Prodstats::stats().writeJSON(f);
+        return;
+        }
+    const bool sortkey = (sval == "time" || sval == "flops"
+                          || sval == "bytes" || sval == "count");
+    Prodstats::stats().report(std::cout,(sortkey ? sval : string("time")));
+    }
+
+struct ProdStatsInit
+    {
+    ProdStatsInit()
+        {
+        if(!std::getenv("ITENSOR_PRODSTATS")) return;
+        Prodstats::enabled() = true;
+        //Construct the table before registering the
+        //exit handler, so it is destroyed after the report
+        Prodstats::stats();
+        std::atexit(prodStatsAtExit);
+        }
+    };
+
+static ProdStatsInit prod_stats_init_;
+
+}; //namespace itensor
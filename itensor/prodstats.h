@@ -0,0 +1,180 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PRODSTATS_H
+#define __ITENSOR_PRODSTATS_H
+#include "global.h"
+#include <map>
+
+namespace itensor {
+
+//
+// Contraction profiler.
+//
+// When the library is compiled with COLLECT_PRODSTATS defined
+// (the default for the CMake build, see the PRODSTATS option)
+// and Prodstats::enabled() is true, every dense ITensor
+// contraction done by ITensor::operator*= (including the
+// block products of IQTensor contractions) is recorded in
+// Prodstats::stats(). Contractions are grouped by
+//
+//  o the caller tag set by the innermost ProdTag in scope
+//    on the calling thread (for example "LocalOp::product")
+//  o the kind of kernel used: "gemm" (reshape to matrices
+//    and call dgemm), "direct" (directMultiply, for small
+//    products) or "diag" (one or both tensors of type Diag).
+//    A complex product is recorded as the real products
+//    it is made of
+//  o the number of m!=1 indices of each tensor and the number
+//    contracted, and whether each tensor had to be permuted
+//    into matrix form first (its "permutation class")
+//
+// For each group the number of calls, floating point
+// operations, bytes read and written and the time spent
+// reshaping (permuting) and multiplying are accumulated.
+//
+// If the environment variable ITENSOR_PRODSTATS is set when
+// the program starts, collection is turned on and a report
+// is written at exit: to a JSON file if the value ends in
+// ".json", otherwise as a table to standard output sorted by
+// the value ("time", "flops", "bytes" or "count"; default "time").
+//
+// Example:
+//
+//   Prodstats::enabled() = true;
+//   dmrg(psi,H,sweeps);
+//   Prodstats::stats().report(std::cout,"flops");
+//
+
+//
+// Key identifying a group of contractions
+//
+struct ProdKey
+    {
+    std::string tag,
+                kind;
+    int rL,     //number of m!=1 indices of the left tensor
+        rR,     //number of m!=1 indices of the right tensor
+        nc;     //number of those contracted
+    bool permL, //whether the left tensor was permuted
+         permR; //whether the right tensor was permuted
+
+    ProdKey()
+        :
+        rL(0),
+        rR(0),
+        nc(0),
+        permL(false),
+        permR(false)
+        { }
+
+    bool
+    operator<(const ProdKey& o) const;
+
+    //Short description of the shape,
+    //e.g. "3x4/2 (L perm)"
+    std::string
+    shape() const;
+    };
+
+struct ProdEntry
+    {
+    long count;
+    Real flops,
+         bytes,
+         reshape_time,
+         mult_time;
+
+    ProdEntry()
+        :
+        count(0),
+        flops(0),
+        bytes(0),
+        reshape_time(0),
+        mult_time(0)
+        { }
+
+    Real
+    time() const { return reshape_time+mult_time; }
+    };
+
+class Prodstats
+    {
+    public:
+
+    typedef std::map<ProdKey,ProdEntry>
+    Table;
+
+    //Runtime switch for collecting (default false)
+    static bool&
+    enabled();
+
+    static Prodstats&
+    stats();
+
+    void
+    record(const ProdKey& key,
+           Real flops,
+           Real bytes,
+           Real reshape_time,
+           Real mult_time);
+
+    const Table&
+    table() const { return table_; }
+
+    //Sum over all entries
+    ProdEntry
+    total() const;
+
+    void
+    reset();
+
+    //Prints a table of all entries sorted by sortby, which
+    //can be "time", "flops", "bytes" or "count" (all largest first)
+    void
+    report(std::ostream& s, const std::string& sortby = "time") const;
+
+    //Writes all entries as a JSON array
+    void
+    writeJSON(std::ostream& s) const;
+
+    private:
+
+    Prodstats() { }
+
+    Table table_;
+    };
+
+//
+// Sets the caller tag of contractions recorded by the
+// current thread for as long as it is in scope,
+// restoring the previous tag when destroyed.
+// The tag must be a string literal (or otherwise
+// outlive the ProdTag).
+//
+class ProdTag
+    {
+    public:
+
+    explicit
+    ProdTag(const char* tag);
+
+    ~ProdTag();
+
+    //Tag currently set for this thread ("" if none)
+    static const char*
+    current();
+
+    private:
+
+    const char* prev_;
+
+    //Not copyable
+    ProdTag(const ProdTag&);
+    void operator=(const ProdTag&);
+    };
+
+}; //namespace itensor
+
+#endif
@@ -0,0 +1,290 @@
+//
+// Distributed under the ITensor Library License, Version 1.1.
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_SPARSEMPO_H
+#define __ITENSOR_SPARSEMPO_H
+#include "iqtensor.h"
+
+namespace itensor {
+
+template <class Tensor>
+class MPOt;
+
+//
+// SparseMPOTensor
+//
+// An MPO site tensor W viewed as a matrix, indexed by the
+// values a, b of its left and right link indices, whose
+// elements are operators on the site:
+//
+//        |
+//   a -- W -- b   =   W_ab
+//        |
+//
+// Only the nonzero elements are kept, and those proportional
+// to the identity are stored as just their coefficient.
+// The MPO tensors made by the classes in hams/ or by AutoMPO
+// have mostly zero or identity elements, so applying them
+// element by element (see the LocalMPO option "SparseMPO")
+// costs time proportional to the number of non-identity
+// elements instead of k^2 for a bond dimension k.
+//
+// If W has no left (or right) link index, as at the ends of
+// an MPO, the row (column) number of each element is 0.
+//
+
+template <class Tensor>
+class SparseMPOTensor
+    {
+    public:
+
+    typedef typename Tensor::IndexT
+    IndexT;
+
+    struct Elem
+        {
+        int row,
+            col;
+        Real coef; //coefficient of the identity if op is null
+        Tensor op;
+
+        Elem() : row(0), col(0), coef(0) { }
+        };
+
+    SparseMPOTensor() { }
+
+    SparseMPOTensor(const Tensor& W,
+                    const IndexT& left,
+                    const IndexT& right);
+
+    //Link indices (as on W, possibly null)
+    const IndexT&
+    left() const { return left_; }
+    const IndexT&
+    right() const { return right_; }
+
+    //Unprimed site index (as on W)
+    const IndexT&
+    site() const { return site_; }
+
+    const std::vector<Elem>&
+    elems() const { return elems_; }
+
+    int
+    nidentity() const;
+
+    bool
+    valid() const { return bool(site_); }
+
+    private:
+
+    IndexT left_,
+           right_,
+           site_;
+    std::vector<Elem> elems_;
+    };
+
+//
+// Sets S[j] (j = 1,...,H.N()) to the sparse form of the
+// site tensors of H. S[0] is left default constructed.
+//
+template <class Tensor>
+void
+sparseMPO(const MPOt<Tensor>& H,
+          std::vector<SparseMPOTensor<Tensor> >& S);
+
+//
+// Given tensors X[a] for each row a of S (a null X[a] is
+// taken to be zero), sets
+//
+//   Y[b] = sum_a W_ab X[a]
+//
+// for each column b of S, with the site index of S primed
+// (Y[b] is null if no element of column b contributes)
+//
+template <class Tensor>
+void
+applySparse(const SparseMPOTensor<Tensor>& S,
+            const std::vector<Tensor>& X,
+            std::vector<Tensor>& Y);
+
+
+//
+//
+// Implementations
+//
+
+//Positions of the states of link index I which
+//may have nonzero elements in T
+std::vector<int> inline
+linkVals(const ITensor& T, const Index& I)
+    {
+    std::vector<int> res(I.m());
+    for(int j = 1; j <= I.m(); ++j) res[j-1] = j;
+    return res;
+    }
+
+std::vector<int> inline
+linkVals(const IQTensor& T, const IQIndex& I)
+    {
+    std::vector<int> res;
+    int offset = 0;
+    for(int n = 1; n <= I.nindex(); ++n)
+        {
+        const Index& i = I.index(n);
+        bool found = false;
+        Foreach(const ITensor& t, T.blocks())
+            {
+            if(hasindex(t,i))
+                {
+                found = true;
+                break;
+                }
+            }
+        if(found)
+            {
+            for(int j = 1; j <= i.m(); ++j) res.push_back(offset+j);
+            }
+        offset += i.m();
+        }
+    return res;
+    }
+
+template <class Tensor>
+SparseMPOTensor<Tensor>::
+SparseMPOTensor(const Tensor& W,
+                const IndexT& left,
+                const IndexT& right)
+    :
+    left_(left),
+    right_(right)
+    {
+    Foreach(const IndexT& I, W.indices())
+        {
+        if(I.type() == Site && I.primeLevel() == 0)
+            {
+            site_ = I;
+            break;
+            }
+        }
+    if(!site_) Error("SparseMPOTensor: no site index found");
+
+    const IndexT sP = dag(prime(site_));
+    Tensor id(site_,sP);
+    for(int j = 1; j <= site_.m(); ++j) id(site_(j),sP(j)) = 1;
+
+    std::vector<int> rows(1,0);
+    if(left_) rows = linkVals(W,left_);
+
+    Foreach(int a, rows)
+        {
+        const Tensor Wa = (left_ ? W*Tensor(dag(left_)(a)) : W);
+        if(Wa.norm() == 0) continue;
+
+        std::vector<int> cols(1,0);
+        if(right_) cols = linkVals(Wa,right_);
+
+        Foreach(int b, cols)
+            {
+            Elem e;
+            e.row = a;
+            e.col = b;
+            e.op = (right_ ? Wa*Tensor(dag(right_)(b)) : Wa);
+            const Real nrm = e.op.norm();
+            if(nrm == 0) continue;
+
+            if(!e.op.isComplex())
+                {
+                const Real c = (e.op*dag(id)).toReal()/site_.m();
+                Tensor diff = e.op;
+                diff -= c*id;
+                if(diff.norm() <= 1E-14*nrm)
+                    {
+                    e.coef = c;
+                    e.op = Tensor();
+                    }
+                }
+            elems_.push_back(e);
+            }
+        }
+    }
+
+template <class Tensor>
+int SparseMPOTensor<Tensor>::
+nidentity() const
+    {
+    int n = 0;
+    Foreach(const Elem& e, elems_)
+        {
+        if(!e.op) ++n;
+        }
+    return n;
+    }
+
+template <class Tensor>
+void
+sparseMPO(const MPOt<Tensor>& H,
+          std::vector<SparseMPOTensor<Tensor> >& S)
+    {
+    typedef typename Tensor::IndexT
+    IndexT;
+
+    const int N = H.N();
+    S.assign(N+1,SparseMPOTensor<Tensor>());
+    for(int j = 1; j <= N; ++j)
+        {
+        const Tensor& W = H.A(j);
+        IndexT left = (j > 1 ? commonIndex(W,H.A(j-1),Link) : IndexT()),
+               right = (j < N ? commonIndex(W,H.A(j+1),Link) : IndexT());
+        //At the ends, a link index not shared with the
+        //neighboring tensor goes to a boundary tensor
+        Foreach(const IndexT& I, W.indices())
+            {
+            if(I.type() != Link || I == left || I == right) continue;
+            if(j == 1 && !left) left = I;
+            else
+            if(j == N && !right) right = I;
+            }
+        S[j] = SparseMPOTensor<Tensor>(W,left,right);
+        }
+    }
+
+template <class Tensor>
+void
+applySparse(const SparseMPOTensor<Tensor>& S,
+            const std::vector<Tensor>& X,
+            std::vector<Tensor>& Y)
+    {
+    typedef typename SparseMPOTensor<Tensor>::Elem
+    Elem;
+
+    Y.assign((S.right() ? S.right().m() : 0)+1,Tensor());
+    Foreach(const Elem& e, S.elems())
+        {
+        const Tensor& x = X.at(e.row);
+        if(!x) continue;
+        Tensor& y = Y.at(e.col);
+        if(e.op)
+            {
+            if(!y) y = x*e.op;
+            else   y += x*e.op;
+            }
+        else
+            {
+            if(!y)
+                {
+                y = e.coef*x;
+                y.prime(S.site());
+                }
+            else
+                {
+                y += e.coef*prime(x,S.site());
+                }
+            }
+        }
+    }
+
+}; //namespace itensor
+
+#endif
@@ -34,12 +34,15 @@ truncate(Vector& D,
          int minm,
          Real cutoff,
          bool absoluteCutoff,
-         bool doRelCutoff)
+         bool doRelCutoff,
+         Real discarded = 0)
     {
     int m = D.Length();
-    if(m == 1) return 0;
+    if(m == 1) return discarded;
 
-    Real truncerr = 0;
+    //Weight of eigenvalues already discarded
+    //(not computed) by a truncated decomposition
+    Real truncerr = discarded;
 
     //Zero out any negative weight
     for(int zerom = m; zerom > 0; --zerom)
@@ -78,17 +81,18 @@ truncate(vector<Real>& alleig,
          int minm,
          Real cutoff,
          bool absoluteCutoff,
-         bool doRelCutoff)
+         bool doRelCutoff,
+         Real discarded = 0)
     {
     m = (int)alleig.size();
     if(m == 1)
         {
         docut = alleig.front()/2.;
-        return 0;
+        return discarded;
         }
     int mdisc = 0;
 
-    Real truncerr = 0;
+    Real truncerr = discarded;
 
     if(absoluteCutoff)
         {
@@ -135,12 +139,77 @@ truncate(vector<Real>& alleig,
 
 
 
+//
+// Call the SVD routine selected by the "SVDMethod" option:
+// "Iterative" (the default, see SVD in matrix/svd.h), 
+// "gesdd" (LAPACK divide and conquer), or "Jacobi" 
+// (QR then one-sided Jacobi: slowest but most accurate
+// for small singular values), or "Randomized" (only the 
+// largest maxm+"SVDOversample" singular values, found by
+// a random range finder with "SVDPowerIters" iterations).
+// For complex matrices "gesdd", "Jacobi" and "Randomized"
+// all use zgesdd.
+//
+// Returns the weight (sum of squared singular values)
+// which was not computed.
+//
+
+struct SVDParams
+    {
+    string method;
+    Real thresh;
+    int maxm,
+        oversample,
+        niter;
+
+    SVDParams(const OptSet& opts)
+        :
+        method(opts.getString("SVDMethod","Iterative")),
+        thresh(opts.getReal("SVDThreshold",1E-4)),
+        maxm(opts.getInt("Maxm",MAX_M)),
+        oversample(opts.getInt("SVDOversample",10)),
+        niter(opts.getInt("SVDPowerIters",2))
+        { }
+    };
+
+Real static
+doSVD(const MatrixRef& M, 
+      Matrix& U, Vector& D, Matrix& V,
+      const SVDParams& p)
+    {
+    if(p.method == "Iterative")
+        SVD(M,U,D,V,p.thresh);
+    else if(p.method == "gesdd")
+        SVDgesdd(M,U,D,V);
+    else if(p.method == "Jacobi")
+        SVDJacobi(M,U,D,V);
+    else if(p.method == "Randomized")
+        return SVDRandomized(M,U,D,V,p.maxm,p.oversample,p.niter);
+    else
+        Error("Unrecognized SVDMethod " + p.method);
+    return 0;
+    }
+
+void static
+doSVD(const MatrixRef& Mre, const MatrixRef& Mim, 
+      Matrix& Ure, Matrix& Uim, 
+      Vector& D, 
+      Matrix& Vre, Matrix& Vim,
+      const SVDParams& p)
+    {
+    if(p.method == "Iterative")
+        SVD(Mre,Mim,Ure,Uim,D,Vre,Vim,p.thresh);
+    else if(p.method == "gesdd" || p.method == "Jacobi" || p.method == "Randomized")
+        SVDComplex(Mre,Mim,Ure,Uim,D,Vre,Vim);
+    else
+        Error("Unrecognized SVDMethod " + p.method);
+    }
+
 Spectrum 
 svdRank2(ITensor A, const Index& ui, const Index& vi,
          ITensor& U, ITensor& D, ITensor& V,
          const OptSet& opts)
     {
-    const Real thresh = opts.getReal("SVDThreshold",1E-4);
     const Real cutoff = opts.getReal("Cutoff",MIN_CUT);
     const int maxm = opts.getInt("Maxm",MAX_M);
     const int minm = opts.getInt("Minm",1);
@@ -148,22 +217,29 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
     const bool doRelCutoff = opts.getBool("DoRelCutoff",false);
     const bool absoluteCutoff = opts.getBool("AbsoluteCutoff",false);
     const bool cplx = A.isComplex();
+    const SVDParams params(opts);
 
     if(A.r() != 2)
         {
         Error("A must be matrix-like");
         }
 
+    //The cutoff is applied to the singular values of A
+    //without its scale factor, which are those of A/|A|
+    //unless the contraction making A skipped scaleOutNorm
+    if(Global::lazyScale()) A.scaleOutNorm();
+
     Matrix UU,VV,
            iUU,iVV;
     Vector DD;
+    Real discarded = 0;
 
     if(!cplx)
         {
         Matrix M;
         A.toMatrix11NoScale(ui,vi,M);
 
-        SVD(M,UU,DD,VV,thresh);
+        discarded = doSVD(M,UU,DD,VV,params);
         }
     else
         {
@@ -175,8 +251,7 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
         Are.toMatrix11NoScale(ui,vi,Mre);
         Aim.toMatrix11NoScale(ui,vi,Mim);
 
-        //SVDComplex(Mre,Mim,UU,iUU,DD,VV,iVV);
-        SVD(Mre,Mim,UU,iUU,DD,VV,iVV,thresh);
+        doSVD(Mre,Mim,UU,iUU,DD,VV,iVV,params);
         }
 
     //Truncate
@@ -190,7 +265,7 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
         Vector sqrD(DD);
         for(int j = 1; j <= sqrD.Length(); ++j)
             sqrD(j) = sqr(DD(j));
-        terr = truncate(sqrD,maxm,minm,cutoff,absoluteCutoff,doRelCutoff);
+        terr = truncate(sqrD,maxm,minm,cutoff,absoluteCutoff,doRelCutoff,discarded);
         m = sqrD.Length();
         DD.ReduceDimension(m);
         }
@@ -236,13 +311,6 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
     U = ITensor(ui,uL,UU.Columns(1,m));
     V = ITensor(vL,vi,VV.Rows(1,m));
 
-    //Fix for cases where A.scale() may be negative
-    if(A.scale().sign() == -1)
-        {
-        D *= -1;
-        U *= -1;
-        }
-
     if(cplx)
         {
         ITensor iU(ui,uL,iUU.Columns(1,m)),
@@ -253,6 +321,15 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
             V = V + iV*Complex_i;
         }
 
+    //Fix for cases where A.scale() may be negative
+    //(done after adding the imaginary part of U
+    //so that all of U changes sign)
+    if(A.scale().sign() == -1)
+        {
+        D *= -1;
+        U *= -1;
+        }
+
     //Square all singular values
     //since convention is to report
     //density matrix eigs
@@ -285,13 +362,32 @@ svdRank2(ITensor A, const Index& ui, const Index& vi,
 
     } // void svdRank2
 
+//Fills order with the positions of the blocks
+//sorted from largest to smallest, so that when blocks 
+//are decomposed in parallel the largest ones are started 
+//first and the smallest ones fill in at the end
+void static
+largestFirst(const vector<const ITensor*>& blocks, vector<int>& order)
+    {
+    vector<pair<long,int> > sizes(blocks.size());
+    for(size_t b = 0; b < blocks.size(); ++b)
+        {
+        sizes[b] = make_pair(-long(blocks[b]->indices().dim()),int(b));
+        }
+    sort(sizes.begin(),sizes.end());
+    order.resize(blocks.size());
+    for(size_t n = 0; n < sizes.size(); ++n)
+        {
+        order[n] = sizes[n].second;
+        }
+    }
+
 Spectrum
 svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
          IQTensor& U, IQTensor& D, IQTensor& V,
          const OptSet& opts)
     {
     const bool cplx = A.isComplex();
-    const Real thresh = opts.getReal("SVDThreshold",1E-4);
     const Real cutoff = opts.getReal("Cutoff",MIN_CUT);
     const int maxm = opts.getInt("Maxm",MAX_M);
     const int minm = opts.getInt("Minm",1);
@@ -299,6 +395,11 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
     const bool doRelCutoff = opts.getBool("DoRelCutoff",false);
     const bool absoluteCutoff = opts.getBool("AbsoluteCutoff",false);
     const Real logrefNorm = opts.getReal("LogRefNorm",0.);
+    const SVDParams params(opts);
+#ifdef _OPENMP
+    const bool threaded = opts.getBool("ThreadedBlocks",
+                                       Global::opts().getBool("ThreadedBlocks",false));
+#endif
 
     if(A.r() != 2)
         {
@@ -320,6 +421,7 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
         }
 
     vector<Vector> dvector(Nblock);
+    vector<Real> discarded(Nblock,0.);
 
     vector<Real> alleig;
     alleig.reserve(min(uI.m(),vI.m()));
@@ -344,9 +446,28 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
 
     //1. SVD each ITensor within A.
     //   Store results in mmatrix and mvector.
-    int itenind = 0;
+    //   If threaded, blocks are done in parallel
+    //   starting from the largest.
+    vector<const ITensor*> Ablocks;
+    Ablocks.reserve(Nblock);
     Foreach(const ITensor& t, A.blocks())
         {
+        Ablocks.push_back(&t);
+        }
+    vector<int> order;
+    largestFirst(Ablocks,order);
+
+    const char* tag = ProdTag::current();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(threaded)
+#endif
+    for(int n = 0; n < Nblock; ++n)
+        {
+        //Keep the caller's tag in worker threads
+        ProdTag ptag(tag);
+        const int itenind = order[n];
+        const ITensor& t = *(Ablocks[itenind]);
+
         Matrix &UU = Umatrix.at(itenind);
         Matrix &VV = Vmatrix.at(itenind);
         Vector &d =  dvector.at(itenind);
@@ -375,7 +496,7 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
             Matrix M(ui->m(),vi->m());
             t.toMatrix11NoScale(*ui,*vi,M);
 
-            SVD(M,UU,d,VV,thresh);
+            discarded.at(itenind) = doSVD(M,UU,d,VV,params);
             }
         else
             {
@@ -388,23 +509,25 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
             ret.toMatrix11NoScale(*ui,*vi,Mre);
             imt.toMatrix11NoScale(*ui,*vi,Mim);
 
-            //SVDComplex(Mre,Mim,
-            //           UU,iUmatrix.at(itenind),
-            //           d,
-            //           VV,iVmatrix.at(itenind));
-            SVD(Mre,Mim,
-                UU,iUmatrix.at(itenind),
-                d,
-                VV,iVmatrix.at(itenind),
-                thresh);
+            doSVD(Mre,Mim,
+                  UU,iUmatrix.at(itenind),
+                  d,
+                  VV,iVmatrix.at(itenind),
+                  params);
             }
+        }
 
-        //Store the squared singular values
-        //(denmat eigenvalues) in alleig
+    //Store the squared singular values
+    //(denmat eigenvalues) in alleig
+    Foreach(const Vector& d, dvector)
+        {
         for(int j = 1; j <= d.Length(); ++j) 
             alleig.push_back(sqr(d(j)));
-
-        ++itenind;
+        }
+    Real totdiscarded = 0;
+    Foreach(Real w, discarded)
+        {
+        totdiscarded += w;
         }
 
     //2. Truncate eigenvalues
@@ -421,7 +544,7 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
         sort(alleig.begin(),alleig.end());
 
         svdtruncerr = truncate(alleig,m,docut,maxm,minm,cutoff,
-                               absoluteCutoff,doRelCutoff);
+                               absoluteCutoff,doRelCutoff,totdiscarded);
         }
 
     if(opts.getBool("ShowEigs",false))
@@ -490,7 +613,7 @@ svdRank2(IQTensor A, const IQIndex& uI, const IQIndex& vI,
     vector<ITensor> Dblock;
     Dblock.reserve(Nblock);
 
-    itenind = 0;
+    int itenind = 0;
     int total_m = 0;
     Foreach(const ITensor& t, A.blocks())
         {
@@ -629,6 +752,9 @@ diag_hermitian(ITensor rho, ITensor& U, ITensor& D,
         }
 #endif
 
+    //See svdRank2
+    if(Global::lazyScale()) rho.scaleOutNorm();
+
     Index active;
     Foreach(const Index& I, rho.indices())
         {
@@ -772,6 +898,10 @@ diag_hermitian(IQTensor rho, IQTensor& U, IQTensor& D,
     const bool doRelCutoff = opts.getBool("DoRelCutoff",false);
     const bool absoluteCutoff = opts.getBool("AbsoluteCutoff",false);
     const bool cplx = rho.isComplex();
+#ifdef _OPENMP
+    const bool threaded = opts.getBool("ThreadedBlocks",
+                                       Global::opts().getBool("ThreadedBlocks",false));
+#endif
 
     if(rho.r() != 2)
         {
@@ -819,9 +949,29 @@ diag_hermitian(IQTensor rho, IQTensor& U, IQTensor& D,
 
     //1. Diagonalize each ITensor within rho.
     //   Store results in mmatrix and mvector.
-    int itenind = 0;
+    //   If threaded, blocks are done in parallel
+    //   starting from the largest.
+    vector<const ITensor*> rblocks;
+    rblocks.reserve(rho.blocks().size());
     Foreach(const ITensor& t, rho.blocks())
         {
+        rblocks.push_back(&t);
+        }
+    vector<int> order;
+    largestFirst(rblocks,order);
+    const int Nblock = rblocks.size();
+
+    const char* tag = ProdTag::current();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(threaded)
+#endif
+    for(int nb = 0; nb < Nblock; ++nb)
+        {
+        //Keep the caller's tag in worker threads
+        ProdTag ptag(tag);
+        const int itenind = order[nb];
+        const ITensor& t = *(rblocks[itenind]);
+
         Index a;
         Foreach(const Index& I, t.indices())
             {
@@ -871,11 +1021,6 @@ diag_hermitian(IQTensor rho, IQTensor& U, IQTensor& D,
             if(flipSign) d *= -1;
             }
 
-        for(int j = 1; j <= n; ++j) 
-            alleig.push_back(d(j));
-
-        ++itenind;
-
 #ifdef STRONG_DEBUG
 	Real maxM = 1.0;
         for(int r = 1; r <= n; ++r)
@@ -904,6 +1049,12 @@ diag_hermitian(IQTensor rho, IQTensor& U, IQTensor& D,
 #endif //STRONG_DEBUG
         }
 
+    Foreach(const Vector& d, mvector)
+        {
+        for(int j = 1; j <= d.Length(); ++j) 
+            alleig.push_back(d(j));
+        }
+
     //2. Truncate eigenvalues
 
     //Determine number of states to keep m
@@ -983,7 +1134,7 @@ diag_hermitian(IQTensor rho, IQTensor& U, IQTensor& D,
     IQIndex::Storage iq;
     iq.reserve(rho.blocks().size());
 
-    itenind = 0;
+    int itenind = 0;
     Foreach(const ITensor& t, rho.blocks())
         {
         Vector& thisD = mvector.at(itenind);
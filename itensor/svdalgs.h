@@ -18,6 +18,13 @@ namespace itensor {
 // Factors a tensor AA such that AA=U*D*V
 // with D diagonal, real, and non-negative.
 //
+// The option "SVDMethod" selects the dense SVD routine:
+// "Iterative" (default), "gesdd" or "Jacobi" (see matrix/svd.h).
+// "Randomized" only computes the largest Maxm (plus "SVDOversample",
+// default 10) singular values of each block using "SVDPowerIters" 
+// (default 2) power iterations; the weight of the rest is included 
+// in the truncation error.
+//
 template<class Tensor>
 Spectrum 
 svd(Tensor AA, Tensor& U, Tensor& D, Tensor& V, 
@@ -32,6 +39,10 @@ svd(Tensor AA, Tensor& U, Tensor& D, Tensor& V,
 // Implementation is faster than SVD, though, and allows the
 // noise term to be used.
 //
+// If the option SVDMethod is "Randomized" and no noise term
+// is used, calls svd instead (forming and diagonalizing the
+// density matrix would cost more than the randomized svd).
+//
 // To determine which indices end up on which factors (i.e. on A versus B),
 // the method examines the initial indices of A and B.
 // If a given index is present on, say, A, then it will on A 
@@ -272,6 +283,16 @@ denmatDecomp(const Tensor& AA, Tensor& A, Tensor& B,
         dir = (mid.dir() == Out ? Fromright : Fromleft);
         }
 
+    if((noise == 0 || PH.isNull()) 
+       && opts.getString("SVDMethod","Iterative") == "Randomized")
+        {
+        Tensor D;
+        Spectrum spec = svd(AA,A,D,B,opts);
+        if(dir == Fromleft) B *= D;
+        else                A *= D;
+        return spec;
+        }
+
     Tensor& to_orth = (dir==Fromleft ? A : B);
     Tensor& newoc   = (dir==Fromleft ? B : A);
     
@@ -19,6 +19,24 @@ namespace itensor {
 //
 // Options recognized:
 //     Verbose - print useful information to stdout
+//     Normalize - normalize psi after each time step (default true)
+//     Parallel - if true, apply gates acting on disjoint bonds
+//                concurrently (default false); see below
+//     Maxm, Cutoff - truncation of each gate application
+//
+// If Parallel is true, psi is kept in the canonical (Vidal) form
+// psi = B_1 B_2 ... B_N with the B_j for j > 1 right orthogonal
+// along with the normalized singular values Lambda_j on each bond,
+// and a gate on sites (i,i+1) is applied using only B_i, B_{i+1}
+// and Lambda_{i-1} (Hastings, PRB 79, 052402). Each gate is moved 
+// as early in the gate list as possible without passing a gate 
+// it shares a site with; gates which end up in the same layer 
+// (e.g. the even or odd bonds of a brickwork gate list) are then 
+// applied and truncated in parallel. A gate list which sweeps 
+// bond by bond gains nothing from this. All gates must act on 
+// nearest-neighbor sites. For imaginary-time gates the form is 
+// only approximately preserved, so the result can differ from the
+// serial algorithm by more than the truncation error for large tstep.
 //
 template <class Iterable, class Tensor>
 Real
@@ -63,6 +81,79 @@ imagTEvol(const MPOt<Tensor>& H,
 // Implementations
 //
 
+//
+// Brings psi into the form used by gateTEvol when Parallel=true:
+// psi = B_1 B_2 ... B_N with the B_j, j > 1, right orthogonal and
+// Lambda_j the normalized singular values on bond j (B and Lambda
+// are 1-indexed; Lambda_j shares an index with B_{j+1}).
+//
+template <class Tensor>
+void
+tebdForm(MPSt<Tensor>& psi, 
+         std::vector<Tensor>& B, 
+         std::vector<Tensor>& Lambda,
+         const OptSet& opts)
+    {
+    const int N = psi.N();
+    B.assign(N+1,Tensor());
+    Lambda.assign(N+1,Tensor());
+
+    psi.position(N);
+    B.at(N) = psi.A(N);
+    for(int j = N-1; j >= 1; --j)
+        {
+        Tensor AA = psi.A(j)*B.at(j+1);
+        AA.scaleTo(1);
+        Tensor U = psi.A(j), D, V;
+        svd(AA,U,D,V,opts);
+        const Real nrm = D.norm();
+        D /= nrm;
+        Lambda.at(j) = D;
+        B.at(j+1) = V;
+        B.at(j) = U*D;
+        }
+    }
+
+//
+// Applies the gate G to sites (i,i+1) of psi in the form made by
+// tebdForm, keeping the form (exactly so for a unitary gate, up to
+// truncation). Returns the factor by which the norm of psi changed.
+//
+template <class Tensor>
+Real
+tebdUpdate(const BondGate<Tensor>& G,
+           std::vector<Tensor>& B, 
+           std::vector<Tensor>& Lambda,
+           const OptSet& opts)
+    {
+    const int i = G.i1();
+
+    Tensor theta = B.at(i) * B.at(i+1) * Tensor(G);
+    theta.noprime();
+
+    //Splitting Lambda_{i-1}*theta instead of theta puts
+    //the singular values of bond i on S without having 
+    //to divide by Lambda_{i-1} afterwards
+    Tensor phi = (i > 1 ? Lambda.at(i-1)*theta : theta);
+    //Dividing by the norms makes the scale factors of
+    //Lambda and B grow, and the svd cutoff is applied to
+    //the elements of phi without the scale factor
+    phi.scaleTo(1);
+
+    Tensor X, S, Y = B.at(i+1);
+    svd(phi,X,S,Y,opts);
+
+    const Real nrm = S.norm();
+    S /= nrm;
+    Lambda.at(i) = S;
+    B.at(i+1) = Y;
+    theta *= dag(Y);
+    theta /= nrm;
+    B.at(i) = theta;
+
+    return nrm;
+    }
+
 template <class Iterable, class Tensor>
 Real
 gateTEvol(const Iterable& gatelist, 
@@ -74,6 +165,7 @@ gateTEvol(const Iterable& gatelist,
     {
     const bool verbose = opts.getBool("Verbose",false);
     const bool normalize = opts.getBool("Normalize",true);
+    const bool parallel = opts.getBool("Parallel",false);
 
     const int nt = int(ttotal/tstep+(1e-9*(ttotal/tstep)));
     if(fabs(nt*tstep-ttotal) > 1E-9)
@@ -81,26 +173,93 @@ gateTEvol(const Iterable& gatelist,
         Error("Timestep not commensurate with total time");
         }
 
+    //For Parallel=true, layers[l] holds gates on disjoint
+    //bonds; each gate goes in the layer after the last one 
+    //holding a gate it shares a site with
+    std::vector<std::vector<const BondGate<Tensor>*> > layers;
+    if(parallel)
+        {
+        std::vector<int> lastlayer(psi.N()+1,-1);
+        Foreach(const BondGate<Tensor>& G, gatelist)
+            {
+            if(G.i2() != G.i1()+1)
+                {
+                Error("gateTEvol: Parallel=true requires nearest-neighbor gates");
+                }
+            const int l = std::max(lastlayer.at(G.i1()),lastlayer.at(G.i2()))+1;
+            if(l == int(layers.size())) layers.push_back(std::vector<const BondGate<Tensor>*>());
+            layers.at(l).push_back(&G);
+            lastlayer.at(G.i1()) = lastlayer.at(G.i2()) = l;
+            }
+        }
+
+    //Only the truncation options are passed on to the 
+    //gate updates (applyGate, or tebdForm and tebdUpdate), 
+    //so other options given for the time evolution or
+    //the observer do not affect them
+    OptSet gate_opts;
+    if(opts.defined("Maxm")) gate_opts.add(opts.get("Maxm"));
+    if(opts.defined("Cutoff")) gate_opts.add(opts.get("Cutoff"));
+
     Real tsofar = 0;
     Real tot_norm = psi.normalize();
-    psi.position(gatelist.front().i());
+    std::vector<Tensor> B, Lambda;
+    if(parallel)
+        {
+        tebdForm(psi,B,Lambda,gate_opts);
+        }
+    else
+        {
+        psi.position(gatelist.front().i());
+        }
     if(verbose) 
         {
         printfln("Taking %d steps of timestep %.5f, total time %.5f",nt,tstep,ttotal);
+        if(parallel) printfln("Applying gates in %d parallel layers",int(layers.size()));
         }
+    //Norm of psi relative to the normalized B's 
+    //(when not normalizing, parallel case only)
+    Real scale = 1;
     for(int tt = 1; tt <= nt; ++tt)
         {
-        Foreach(const BondGate<Tensor>& G, gatelist)
+        if(parallel)
             {
-            const int lastpos = psi.orthoCenter();
-            const int closest = abs(lastpos-G.i1()) < abs(lastpos-G.i2()) ? G.i1() : G.i2();
-            psi.position(closest);
-            applyGate(G,psi);
-            }
+            Real step_norm = 1;
+            for(size_t l = 0; l < layers.size(); ++l)
+                {
+                const std::vector<const BondGate<Tensor>*>& layer = layers[l];
+                const int ng = layer.size();
+                std::vector<Real> nrm(ng);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+                for(int n = 0; n < ng; ++n)
+                    {
+                    nrm[n] = tebdUpdate(*(layer[n]),B,Lambda,gate_opts);
+                    }
+                for(int n = 0; n < ng; ++n) step_norm *= nrm[n];
+                }
+
+            if(normalize) tot_norm *= step_norm;
+            else          scale *= step_norm;
 
-        if(normalize)
+            for(int j = 1; j <= psi.N(); ++j) psi.Anc(j) = B.at(j);
+            psi.Anc(1) *= scale;
+            }
+        else
             {
-            tot_norm *= psi.normalize();
+            Foreach(const BondGate<Tensor>& G, gatelist)
+                {
+                const int lastpos = psi.orthoCenter();
+                const int closest = abs(lastpos-G.i1()) < abs(lastpos-G.i2()) ? G.i1() : G.i2();
+                psi.position(closest);
+                applyGate(G,psi,gate_opts);
+                }
+
+            if(normalize)
+                {
+                tot_norm *= psi.normalize();
+                }
             }
 
         tsofar += tstep;
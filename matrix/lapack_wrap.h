@@ -68,6 +68,8 @@ LAPACK_COMPLEX;
 
 #endif
 
+#include <vector>
+
 #ifdef FORTRAN_NO_TRAILING_UNDERSCORE
 #define F77NAME(x) x
 #else
@@ -105,6 +107,28 @@ void F77NAME(zgesdd)(char *jobz, LAPACK_INT *m, LAPACK_INT *n, LAPACK_COMPLEX *a
              LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *iwork, LAPACK_INT *info);
 #endif
 
+#ifdef PLATFORM_acml
+void F77NAME(dgesdd)(char *jobz, int *m, int *n, double *a, int *lda, double *s, 
+             double *u, int *ldu, double *vt, int *ldvt, 
+             double *work, int *lwork, int *iwork, int *info, 
+             int jobz_len);
+#else
+void F77NAME(dgesdd)(char *jobz, LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, double *s, 
+             double *u, LAPACK_INT *ldu, double *vt, LAPACK_INT *ldvt, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *info);
+#endif
+
+#ifdef PLATFORM_acml
+void F77NAME(dgesvj)(char *joba, char *jobu, char *jobv, int *m, int *n, double *a, 
+             int *lda, double *sva, int *mv, double *v, int *ldv, 
+             double *work, int *lwork, int *info, 
+             int joba_len, int jobu_len, int jobv_len);
+#else
+void F77NAME(dgesvj)(char *joba, char *jobu, char *jobv, LAPACK_INT *m, LAPACK_INT *n, double *a, 
+             LAPACK_INT *lda, double *sva, LAPACK_INT *mv, double *v, LAPACK_INT *ldv, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *info);
+#endif
+
 void F77NAME(dgeqrf)(LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
                      double *tau, double *work, LAPACK_INT *lwork, LAPACK_INT *info);
 
@@ -212,6 +236,85 @@ zgesdd_wrapper(char *jobz,           //char* specifying how much of U, V to comp
 #endif
     }
 
+//
+// dgesdd
+//
+// Singular value decomposition of a real matrix A
+// by the divide and conquer method
+//
+void inline
+dgesdd_wrapper(char *jobz,           //char* specifying how much of U, V to compute
+                                     //choosing *jobz=='S' computes min(m,n) cols of U, V
+               LAPACK_INT *m,        //number of rows of input matrix *A
+               LAPACK_INT *n,        //number of cols of input matrix *A
+               LAPACK_REAL *A,       //contents of input matrix A (destroyed on return)
+               LAPACK_REAL *s,       //on return, singular values of A
+               LAPACK_REAL *u,       //on return, orthogonal matrix U
+               LAPACK_REAL *vt,      //on return, orthogonal matrix V transpose
+               LAPACK_INT *info)
+    {
+    LAPACK_INT l = min(*m,*n),
+               g = max(*m,*n);
+    LAPACK_INT ldvt = (*jobz == 'A' ? *n : l);
+    std::vector<LAPACK_INT> iwork(8*l);
+#ifdef PLATFORM_acml
+    LAPACK_INT jobz_len = 1;
+#endif
+    //Query the optimal workspace size (lwork == -1), which
+    //lets LAPACK use its blocked algorithms; fall back to
+    //the minimal size from the LAPACK docs if it is smaller
+    LAPACK_INT lwork = -1;
+    LAPACK_REAL wkopt = 0;
+#ifdef PLATFORM_acml
+    F77NAME(dgesdd)(jobz,m,n,A,m,s,u,m,vt,&ldvt,&wkopt,&lwork,&iwork[0],info,jobz_len);
+#else
+    F77NAME(dgesdd)(jobz,m,n,A,m,s,u,m,vt,&ldvt,&wkopt,&lwork,&iwork[0],info);
+#endif
+    lwork = max(LAPACK_INT(wkopt),4*l*l+6*l+g+100);
+    //Workspace can be large, so allocate it on the heap
+    std::vector<LAPACK_REAL> work(lwork);
+#ifdef PLATFORM_acml
+    F77NAME(dgesdd)(jobz,m,n,A,m,s,u,m,vt,&ldvt,&work[0],&lwork,&iwork[0],info,jobz_len);
+#else
+    F77NAME(dgesdd)(jobz,m,n,A,m,s,u,m,vt,&ldvt,&work[0],&lwork,&iwork[0],info);
+#endif
+    }
+
+//
+// dgesvj
+//
+// Singular value decomposition of a real matrix A (m >= n)
+// by the one-sided Jacobi method, which computes small
+// singular values to high relative accuracy
+//
+void inline
+dgesvj_wrapper(char *joba,           //'G' for general A, 'U' ('L') if upper (lower) triangular
+               LAPACK_INT *m,        //number of rows of input matrix *A
+               LAPACK_INT *n,        //number of cols of input matrix *A, n <= m
+               LAPACK_REAL *A,       //contents of input matrix A
+                                     //on return, the n left singular vectors
+               LAPACK_REAL *s,       //on return, singular values of A
+               LAPACK_REAL *v,       //on return, n x n orthogonal matrix V
+               LAPACK_INT *info)
+    {
+    char jobu = 'U',
+         jobv = 'V';
+    LAPACK_INT mv = 0;
+    LAPACK_INT lwork = max(6,*m+*n);
+    std::vector<LAPACK_REAL> work(lwork);
+#ifdef PLATFORM_acml
+    F77NAME(dgesvj)(joba,&jobu,&jobv,m,n,A,m,s,&mv,v,n,&work[0],&lwork,info,1,1,1);
+#else
+    F77NAME(dgesvj)(joba,&jobu,&jobv,m,n,A,m,s,&mv,v,n,&work[0],&lwork,info);
+#endif
+    //Singular values are returned scaled by work[0]
+    //to avoid overflow/underflow
+    if(*info == 0 && work[0] != 1.)
+        {
+        for(LAPACK_INT j = 0; j < *n; ++j) s[j] *= work[0];
+        }
+    }
+
 //
 // dgeqrf
 //
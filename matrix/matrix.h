@@ -158,6 +158,7 @@ public:
     inline Vector (const VectorRef &);
     inline Vector (const Vector &);
     void CopyPointer(const Vector &);	// Reference-count copy of pointer
+    inline void UseStorage(const StoreLink &, int); // Refer to existing storage
     inline void CopyDestroy(Vector &);
     inline void MakeTemp();
 
@@ -226,7 +227,7 @@ inline Matrix::Matrix(const MatrixRef &M)
 inline Matrix::~Matrix ()
     { 
         makematrix(0, 0); 
-        Matrix::numcon()--; 
+        __sync_sub_and_fetch(&Matrix::numcon(),1); 
     }
 
 inline void Matrix::ReDimension(int s1, int s2)
@@ -313,7 +314,7 @@ inline void Vector::init()
     { 
         VectorRef::init(); 
         temporary = 0; 
-        Vector::numcon()++; 
+        __sync_add_and_fetch(&Vector::numcon(),1); 
     }
 
 inline void Vector::fixref()		
@@ -347,7 +348,7 @@ inline Vector::Vector (const VectorRef &V)
 inline Vector::~Vector ()
     { 
         makevector(0); 
-        Vector::numcon()--; 
+        __sync_sub_and_fetch(&Vector::numcon(),1); 
     }
 
 inline int Vector::Storage() const
@@ -359,6 +360,9 @@ inline void Vector::ReDimension(int s)
 inline VectorRef& Vector::operator = (const Vector &V)
     { if (&V != this) copy(V); return *this; }
 
+inline void Vector::UseStorage(const StoreLink &S, int s)
+    { slink << S; length = s; fixref(); temporary = 0; }
+
 inline void Vector::CopyDestroy(Vector &V)
     { if (&V != this) copytransfer(V); }
 
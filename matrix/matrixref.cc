@@ -525,9 +525,15 @@ VectorRef &
 VectorRef::Randomize()
     {
     static int idum = abs((int) ((long)this));
+    //idum is shared by all threads
+#ifdef _OPENMP
+#pragma omp critical(itensor_quickran)
+#endif
+    {
     quickran(idum);
     for (VIter v(*this); v.test(); v.inc())
 	v.val() = quickran(idum)+0.012345;
+    }
     return *this;
     }
 
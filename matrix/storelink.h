@@ -16,13 +16,26 @@ typedef double Real;
 // etc. for allocation.
 
 class StoreReport;
+class ExternalStore;
 
 // Actual StoreLink structure
 struct storerep
     {
     int storage;			// Size of storage
     int numref;				// Number of references 
-    storerep() : storage(0), numref(1) {}
+    ExternalStore* owner;		// Owner of storage not made by new
+    storerep() : storage(0), numref(1), owner(0) {}
+    };
+
+// Owner of storage not allocated by StoreLink (e.g. part of a
+// memory-mapped file). The storerep header must be placed in
+// the HeaderBytes() bytes just before the storage itself.
+// release is called when the last StoreLink to it is deleted.
+class ExternalStore
+    {
+public:
+    virtual ~ExternalStore() { }
+    virtual void release(storerep* p) = 0;
     };
 
 class StoreLink
@@ -38,6 +51,8 @@ public:
 							// copy new one.
 // Commands for new storage, used by storage classes only.
     inline StoreLink(int);		// Negative int treated as 0.
+    inline StoreLink(Real*, int, ExternalStore*); // Use storage at Real*
+    inline static int HeaderBytes();	// Size of header before storage
     inline void makestorage(int);	// Resize storage to int.
     inline void increasestorage(int);	// Increase size to int, no reduce.
     	
@@ -85,6 +100,7 @@ private:
     enum { offset = (sizeof(storerep)-1) / sizeof(Real) + 1 };
     inline void donew(int s);
     inline void dodelete();
+    inline void incref();
 // " =" is private, not allowed.  Put in to replace default shallow copy.
     inline StoreLink & operator = (const StoreLink &); 
     };
@@ -118,20 +134,30 @@ inline void StoreLink::donew(int s)
     if (s > 0)
 	{
 	p = (storerep *) new Real[s + offset];
-	p->numref = 1; p->storage = s; StoreLink::storageinuse() += s;
-    StoreLink::numberofobjects()++;
+	p->numref = 1; p->storage = s; p->owner = 0; 
+    __sync_add_and_fetch(&StoreLink::storageinuse(),s);
+    __sync_add_and_fetch(&StoreLink::numberofobjects(),1);
 	// cout << "Making storage address " << (long)(p) << endl;
 	}
     else  
-	{ p = StoreLink::pnullrep(); p->numref++; }
+	{ p = StoreLink::pnullrep(); incref(); }
     }
 
+// Reference counts (including that of the shared null storage
+// used by every empty Matrix and Vector) are changed atomically,
+// so Matrix and Vector objects may be made and destroyed by
+// several threads at once
+inline void StoreLink::incref()
+    { __sync_add_and_fetch(&p->numref,1); }
+
 inline void StoreLink::dodelete()
     { 
-    if(--p->numref == 0) 
+    if(__sync_sub_and_fetch(&p->numref,1) == 0) 
 	{
+    if(p->owner != 0) { p->owner->release(p); return; }
 	// cout << "Deleting storage address " << (long)(p) << endl;
-    StoreLink::storageinuse() -= p->storage; StoreLink::numberofobjects()--;
+    __sync_sub_and_fetch(&StoreLink::storageinuse(),p->storage); 
+    __sync_sub_and_fetch(&StoreLink::numberofobjects(),1);
 	delete [] ((Real *) p);
 //	if(StoreLink::storageinuse() <= 0)
 //	    cout << "Storage in use is now " << StoreLink::storageinuse() << endl;
@@ -139,7 +165,7 @@ inline void StoreLink::dodelete()
     }
 
 inline StoreLink::StoreLink() : p(StoreLink::pnullrep())
-    { p->numref++; }
+    { incref(); }
 
 inline Real * StoreLink::Store() const
     { return ((Real *)p)+offset; }
@@ -151,17 +177,24 @@ inline int StoreLink::Storage() const { return p->storage; }
 inline StoreLink::~StoreLink() { dodelete(); }
 
 inline StoreLink::StoreLink(const StoreLink & S) : p(S.p)
-    { p->numref++; }
+    { incref(); }
 
 inline StoreLink & StoreLink::operator<<(const StoreLink & S)		
     { 			
-    if(this != &S) { dodelete(); p = S.p; p->numref++; }
+    if(this != &S) { dodelete(); p = S.p; incref(); }
     return *this; 
     }
 
 inline StoreLink::StoreLink(int s) 
     { donew(s); }
 
+// The HeaderBytes() bytes before st are overwritten 
+inline StoreLink::StoreLink(Real* st, int s, ExternalStore* owner) 
+    : p((storerep *) (st - offset))
+    { p->numref = 1; p->storage = s; p->owner = owner; }
+
+inline int StoreLink::HeaderBytes() { return sizeof(Real)*offset; }
+
 inline void StoreLink::makestorage(int s)	// Negative s treated as 0
     {
     if(p->storage != s) { dodelete(); donew(s); }
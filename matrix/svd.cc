@@ -1,6 +1,7 @@
 #include "svd.h"
 
 #include <fstream>
+#include <algorithm>
 
 #include "lapack_wrap.h"
 
@@ -327,4 +328,182 @@ SVDComplex(const MatrixRef& Are, const MatrixRef& Aim,
         }
     }
 
+void 
+SVDgesdd(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V)
+    {
+    LAPACK_INT n = A.Nrows(), 
+               m = A.Ncols(); 
+    LAPACK_INT k = min(n,m);
+
+    //The row-major storage of A is the column-major
+    //storage of A.t(), so compute A.t() = u * D * vt; 
+    //then U = vt.t() and V = u.t(), which are just
+    //u and vt read back in row-major order
+    Matrix AA(A);
+    U.ReDimension(n,k);
+    V.ReDimension(k,m);
+    D.ReDimension(k);
+
+    char jobz = 'S';
+    LAPACK_INT info = 0;
+    dgesdd_wrapper(&jobz,&m,&n,AA.Store(),D.Store(),V.Store(),U.Store(),&info);
+
+    if(info != 0) 
+        {
+        cout << "info = " << info << endl;
+        Error("Error condition in dgesdd");
+        }
+    }
+
+void 
+SVDJacobi(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V)
+    {
+    const int n = A.Nrows(), 
+              m = A.Ncols();
+
+    if(n > m)
+        {
+        Matrix At = A.t(), Ut, Vt;
+        SVDJacobi(At,Vt,D,Ut);
+        U = Ut.t();
+        V = Vt.t();
+        return;
+        }
+
+    //As in SVDgesdd, work with the column-major 
+    //m x n matrix A.t() (m >= n), stored in Q
+
+    //1. QR factorize A.t() = Q*R, 
+    //   Q is m x n and R is n x n
+    Matrix Q(A);
+    Vector tau(n);
+    LAPACK_INT lm = m, 
+               ln = n,
+               info = 0;
+    dgeqrf_wrapper(&lm,&ln,Q.Store(),&lm,tau.Store(),&info);
+    if(info != 0) Error("Error condition in dgeqrf");
+
+    //Copy R (column-major, upper triangular) 
+    Matrix R(n,n);
+    R = 0;
+    Real *pr = R.Store(),
+         *pq = Q.Store();
+    for(int j = 0; j < n; ++j)
+    for(int i = 0; i <= j; ++i)
+        {
+        pr[i+j*n] = pq[i+j*m];
+        }
+
+    dorgqr_wrapper(&lm,&ln,&ln,Q.Store(),&lm,tau.Store(),&info);
+    if(info != 0) Error("Error condition in dorgqr");
+
+    //2. R = ur * D * vr.t() by one-sided Jacobi:
+    //   on return R holds ur and vr holds vr
+    //   (both column-major)
+    Matrix vr(n,n);
+    D.ReDimension(n);
+    char joba = 'U';
+    dgesvj_wrapper(&joba,&ln,&ln,R.Store(),D.Store(),vr.Store(),&info);
+    if(info < 0) 
+        {
+        cout << "info = " << info << endl;
+        Error("Error condition in dgesvj");
+        }
+
+    //3. A.t() = (Q*ur) * D * vr.t() so U = vr and 
+    //   V = ur.t() * Q.t(). Column-major vr, ur and Q 
+    //   read as row-major matrices are vr.t(), ur.t() and Q.t()
+    Matrix Vt(n,m);
+    Vt = R * Q;
+
+    //dgesvj sorts singular values, but make sure 
+    //they are in decreasing order
+    vector<pair<Real,int> > order(n);
+    for(int j = 1; j <= n; ++j) order[j-1] = make_pair(-D(j),j);
+    sort(order.begin(),order.end());
+
+    U.ReDimension(n,n);
+    V.ReDimension(n,m);
+    for(int j = 1; j <= n; ++j)
+        {
+        const int o = order[j-1].second;
+        D(j) = -order[j-1].first;
+        U.Column(j) = vr.Row(o);
+        V.Row(j) = Vt.Row(o);
+        }
+    }
+
+//Orthonormalize the rows of the l x n matrix Qt (l <= n)
+void static
+orthoRows(Matrix& Qt)
+    {
+    //The row-major storage of Qt is the column-major
+    //storage of the n x l matrix Qt.t(), so a QR
+    //factorization of it replaces the rows of Qt
+    //by an orthonormal basis of their span
+    LAPACK_INT n = Qt.Ncols(),
+               l = Qt.Nrows(),
+               info = 0;
+    Vector tau(l);
+    dgeqrf_wrapper(&n,&l,Qt.Store(),&n,tau.Store(),&info);
+    if(info != 0) Error("Error condition in dgeqrf");
+    dorgqr_wrapper(&n,&l,&l,Qt.Store(),&n,tau.Store(),&info);
+    if(info != 0) Error("Error condition in dorgqr");
+    }
+
+Real 
+SVDRandomized(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V,
+              int k, int oversample, int niter)
+    {
+    const int n = A.Nrows(), 
+              m = A.Ncols(),
+              l = min(k+oversample,min(n,m));
+
+    if(l >= min(n,m))
+        {
+        SVDgesdd(A,U,D,V);
+        return 0;
+        }
+
+    //Random test matrix with entries uniform in [-1/2,1/2)
+    Matrix Om(m,l);
+    Om.Randomize();
+    Om.TreatAsVector() += -0.512345;
+
+    //Qt.t() is an orthonormal basis for the range of A*Om
+    Matrix Qt = (A*Om).t();
+    orthoRows(Qt);
+
+    //Power iterations: Qt -> range of (A*A.t())^niter * A*Om
+    //which suppresses the contribution of the small 
+    //singular values
+    Matrix Zt;
+    for(int it = 0; it < niter; ++it)
+        {
+        Zt = Qt*A;
+        orthoRows(Zt);
+        Qt = Zt*A.t();
+        orthoRows(Qt);
+        }
+
+    //Project A onto the basis, B = Qt*A is l x m,
+    //and do an exact SVD of B = ub*D*V
+    Matrix B = Qt*A, ub;
+    SVDgesdd(B,ub,D,V);
+    U = Qt.t()*ub;
+
+    //|A - U*D*V|^2 = |A|^2 - |B|^2 since U*D*V = Q*Q.t()*A
+    Real Anrm2 = 0;
+    for(int r = 1; r <= n; ++r)
+        {
+        const Real nr = Norm(A.Row(r));
+        Anrm2 += nr*nr;
+        }
+    for(int j = 1; j <= l; ++j)
+        {
+        Anrm2 -= D(j)*D(j);
+        }
+    return max(0.,Anrm2);
+    }
+
 };
@@ -41,6 +41,45 @@ SVDComplex(const MatrixRef& Are, const MatrixRef& Aim,
            Matrix& Ure, Matrix& Uim, 
            Vector& D, 
            Matrix& Vre, Matrix& Vim);
+
+//
+// SVD of a real n x m Matrix A = U * D * V using
+// the LAPACK divide and conquer routine dgesdd.
+// U is n x k and V is k x m where k = min(n,m).
+// Singular values are in decreasing order.
+//
+
+void 
+SVDgesdd(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V);
+
+//
+// SVD of a real n x m Matrix A = U * D * V using
+// a QR factorization followed by the one-sided 
+// Jacobi method (LAPACK dgesvj) applied to R.
+// Slower than SVDgesdd but computes small singular
+// values (and their vectors) to high relative accuracy.
+// Same conventions as SVDgesdd.
+//
+
+void 
+SVDJacobi(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V);
+
+//
+// Randomized truncated SVD of a real n x m Matrix A,
+// approximating A ~= U * D * V with U n x l and V l x m,
+// where l = k + oversample (or min(n,m) if smaller).
+// The range of A is found from A times a random l column
+// matrix, refined by niter power iterations, so the cost
+// is O(n*m*l) instead of O(n*m*min(n,m)).
+// Only the leading k singular values are reliable.
+//
+// Returns the squared norm of A - U*D*V (the weight of
+// the singular values which were not computed).
+//
+
+Real 
+SVDRandomized(const MatrixRef& A, Matrix& U, Vector& D, Matrix& V,
+              int k, int oversample = 10, int niter = 2);
            
 
 };
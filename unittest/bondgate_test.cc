@@ -1,5 +1,5 @@
 #include "test.h"
-#include "bondgate.h"
+#include "tevol.h"
 #include "sites/spinhalf.h"
 
 using std::vector;
@@ -98,4 +98,64 @@ SECTION("RealTimeGate")
         }
     }
 
+SECTION("ParallelTEvol")
+    {
+    //Long enough for the scale factors of the
+    //singular values to become large
+    const int Nt = 20;
+    SpinHalf tsites(Nt);
+
+    //Brickwork list: odd bonds then even bonds
+    vector<Gate> gates;
+    vector<IQGate> qgates;
+    const Real tau = 0.05;
+    for(int start = 1; start <= 2; ++start)
+    for(int b = start; b < Nt; b += 2)
+        {
+        ITensor hh = tsites.op("Sz",b)*tsites.op("Sz",b+1);
+        hh += tsites.op("Sm",b)*tsites.op("Sp",b+1) * 0.5;
+        hh += tsites.op("Sp",b)*tsites.op("Sm",b+1) * 0.5;
+        gates.push_back(Gate(tsites,b,b+1,Gate::tReal,tau,hh));
+
+        IQTensor qhh = tsites.op("Sz",b)*tsites.op("Sz",b+1);
+        qhh += tsites.op("Sm",b)*tsites.op("Sp",b+1) * 0.5;
+        qhh += tsites.op("Sp",b)*tsites.op("Sm",b+1) * 0.5;
+        qgates.push_back(IQGate(tsites,b,b+1,IQGate::tReal,tau,qhh));
+        }
+
+    InitState neel(tsites);
+    for(int j = 1; j <= Nt; ++j) neel.set(j,(j%2==1 ? "Up" : "Dn"));
+
+    const OptSet opts = Opt("Cutoff",1E-14) & Opt("Maxm",200);
+
+    MPS psi(neel),
+        ppsi(psi);
+    gateTEvol(gates,0.5,tau,psi,opts);
+    gateTEvol(gates,0.5,tau,ppsi,opts & Opt("Parallel"));
+    CHECK(linkInd(ppsi,Nt/2).m() > 1);
+    CHECK_CLOSE(std::abs(psiphiC(psi,ppsi)),1,1E-8);
+    CHECK_CLOSE(std::abs(psiphiC(ppsi,ppsi)),1,1E-8);
+
+    IQMPS qpsi(neel),
+          qppsi(qpsi);
+    gateTEvol(qgates,0.5,tau,qpsi,opts);
+    gateTEvol(qgates,0.5,tau,qppsi,opts & Opt("Parallel"));
+    CHECK(checkQNs(qppsi));
+    CHECK_CLOSE(std::abs(psiphiC(qpsi,qppsi)),1,1E-8);
+
+    //Gates which do not commute are done one layer at a time
+    vector<Gate> sgates;
+    for(int b = 1; b < Nt; ++b) 
+        {
+        const int n = (b%2 == 1 ? (b-1)/2 : Nt/2+(b-2)/2);
+        CHECK(gates.at(n).i1() == b);
+        sgates.push_back(gates.at(n));
+        }
+    MPS spsi(neel);
+    ppsi = MPS(neel);
+    gateTEvol(sgates,0.2,tau,spsi,opts);
+    gateTEvol(sgates,0.2,tau,ppsi,opts & Opt("Parallel"));
+    CHECK_CLOSE(std::abs(psiphiC(spsi,ppsi)),1,1E-8);
+    }
+
 }
@@ -0,0 +1,112 @@
+#include "test.h"
+#include "contract.h"
+#include "sites/spinhalf.h"
+#include "hams/Heisenberg.h"
+
+using namespace itensor;
+using namespace std;
+
+TEST_CASE("ContractTest")
+{
+
+SECTION("Plan")
+    {
+    //A(a,b) B(b,c) C(c,d) with a,c large and b,d small:
+    //B*C first costs 800 instead of 40000 for (A*B)*C
+    ContractNet net;
+    net.m.push_back(100);
+    net.m.push_back(2);
+    net.m.push_back(100);
+    net.m.push_back(2);
+    net.inds.resize(3);
+    net.inds[0].push_back(0); net.inds[0].push_back(1);
+    net.inds[1].push_back(1); net.inds[1].push_back(2);
+    net.inds[2].push_back(2); net.inds[2].push_back(3);
+    net.density.assign(3,1.);
+
+    ContractPlan plan = contractPlan(net);
+    CHECK(plan.first.size() == 2);
+    CHECK(plan.first.at(0) == 1);
+    CHECK(plan.second.at(0) == 2);
+    CHECK(plan.first.at(1) == 0);
+    CHECK(plan.second.at(1) == 1);
+    CHECK(plan.result == 0);
+    }
+
+SECTION("ITensor")
+    {
+    Index a("a",37),
+          b("b",2),
+          c("c",41),
+          d("d",3);
+    ITensor A(a,b),
+            B(b,c),
+            C(c,d),
+            D(d,a);
+    A.randomize();
+    B.randomize();
+    C.randomize();
+    D.randomize();
+
+    const ITensor ABC = A*B*C;
+    const ITensor ABCD = A*B*C*D;
+
+    resetContractStats();
+    ITensor R = contract(A,B,C);
+    const int nplan = contractStats().nplanned+contractStats().ncached;
+    CHECK(nplan == 1);
+    CHECK(hasindex(R,a));
+    CHECK(hasindex(R,d));
+    CHECK(R.r() == 2);
+    CHECK_CLOSE((R-ABC).norm(),0,1E-10*ABC.norm());
+
+    //Same shape: order is taken from the cache
+    resetContractStats();
+    R = contract(A*2,B,C);
+    CHECK(contractStats().ncached == 1);
+    CHECK(contractStats().nplanned == 0);
+    CHECK_CLOSE((R-2*ABC).norm(),0,1E-10*ABC.norm());
+
+    //Null tensors are skipped
+    R = contract(ITensor(),A,B,C,D);
+    CHECK_CLOSE(R.toReal(),ABCD.toReal(),1E-10*fabs(ABCD.toReal()));
+    }
+
+SECTION("PlanCache")
+    {
+    //Networks of two tensors sharing an index 
+    //of dimension 2^(n+1), each with its own key
+    std::vector<ContractNet> nets(MaxCachedPlans+1);
+    for(size_t n = 0; n < nets.size(); ++n)
+        {
+        ContractNet& net = nets[n];
+        net.m.assign(1,pow(2.,int(n)+1));
+        net.inds.assign(2,std::vector<int>(1,0));
+        net.density.assign(2,1.);
+        contractPlan(net);
+        }
+
+    //Least recently used plan was dropped, others kept
+    resetContractStats();
+    contractPlan(nets.back());
+    contractPlan(nets.at(1));
+    CHECK(contractStats().ncached == 2);
+    contractPlan(nets.front());
+    CHECK(contractStats().nplanned == 1);
+    }
+
+SECTION("IQTensor")
+    {
+    const int N = 4;
+    SpinHalf sites(N);
+    IQMPO H = Heisenberg(sites);
+
+    const IQTensor W = H.A(1)*H.A(2)*H.A(3);
+    IQTensor R = contract(H.A(1),H.A(2),H.A(3));
+    CHECK_CLOSE((R-W).norm(),0,1E-10*W.norm());
+
+    CHECK(contractDensity(H.A(2)) < 1);
+    CHECK_CLOSE(contractDensity(H.A(2).toITensor()),1,1E-12);
+    }
+
+}
@@ -3,6 +3,9 @@
 #include "hams/Heisenberg.h"
 #include "sites/spinhalf.h"
 #include "localmpo.h"
+#include "dmrg.h"
+#include "pdmrg.h"
+#include "quietobserver.h"
 
 using namespace itensor;
 using namespace std;
@@ -138,4 +141,199 @@ SECTION("IQFourSite")
 
     }
 
+
+SECTION("BlockDavidson")
+    {
+    const int N = 8;
+    SpinHalf sites(N);
+    IQMPO H = Heisenberg(sites);
+
+    InitState initState(sites);
+    for(int i = 1; i <= N; ++i)
+        initState.set(i,i%2==1 ? "Up" : "Dn");
+
+    IQMPS psi(initState);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,H,sweeps,obs,"Quiet");
+
+    MPS rpsi(initState);
+    MPO rH = Heisenberg(sites);
+    QuietObserver<ITensor> robs(rpsi);
+    dmrg(rpsi,rH,sweeps,robs,"Quiet");
+
+    rpsi.position(4);
+    LocalMPO<ITensor> PH(rH);
+    PH.position(4,rpsi);
+    ITensor phi = rpsi.A(4)*rpsi.A(5);
+
+    //Block product agrees with separate products
+    vector<ITensor> v(3,phi),
+                    Av;
+    v[1].randomize();
+    v[2].randomize();
+    PH.product(v,Av);
+    for(int j = 0; j < 3; ++j)
+        {
+        ITensor Avj;
+        PH.product(v[j],Avj);
+        CHECK((Av[j]-Avj).norm() < 1E-10*Avj.norm());
+        }
+
+    OptSet opts("MaxIter=40,ErrGoal=1E-10");
+    ITensor phi1 = phi;
+    const Real En1 = davidson(PH,phi1,opts);
+
+    resetDavidsonStats();
+    opts.add("EigenSolver",string("BlockDavidson"));
+    ITensor phi2 = phi;
+    const Real En2 = davidson(PH,phi2,opts);
+    CHECK_CLOSE(En2,En1,1E-8);
+    CHECK_CLOSE(fabs(Dot(phi1,phi2)),1,1E-6);
+    CHECK(davidsonStats().ncall == 1);
+    CHECK(davidsonStats().nproduct > 0);
+
+    //Lowest two eigenvalues, compared to 
+    //deflating the lowest one from H
+    vector<ITensor> vv(2,phi);
+    vv[1].randomize();
+    opts.add("BlockSize",3);
+    const vector<Real> eigs = blockDavidson(PH,vv,opts);
+    CHECK_CLOSE(eigs[0],En1,1E-8);
+    CHECK(eigs[1] > eigs[0]-1E-10);
+    CHECK_CLOSE(fabs(Dot(vv[0],vv[1])),0,1E-8);
+    ITensor Av1;
+    PH.product(vv[1],Av1);
+    CHECK_CLOSE((Av1-eigs[1]*vv[1]).norm(),0,1E-6);
+
+    psi.position(4);
+    LocalMPO<IQTensor> IPH(H);
+    IPH.position(4,psi);
+    IQTensor iphi = psi.A(4)*psi.A(5);
+    IQTensor iphi2 = iphi;
+    const Real En3 = davidson(IPH,iphi2,opts);
+    CHECK_CLOSE(En3,En1,1E-8);
+    }
+
+SECTION("ParallelDMRG")
+    {
+    const int N = 20;
+    SpinHalf sites(N);
+
+    InitState initState(sites);
+    for(int i = 1; i <= N; ++i)
+        initState.set(i,i%2==1 ? "Up" : "Dn");
+
+    Sweeps sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-10;
+
+    IQMPO H = Heisenberg(sites);
+    IQMPS psi(initState);
+    QuietObserver<IQTensor> obs(psi);
+    const Real En = dmrg(psi,H,sweeps,obs,"Quiet");
+
+    //Four blocks of 5 sites (swept in turn by 
+    //one thread when built without OpenMP)
+    const Partition P(N,4,5);
+    IQMPS ppsi(initState);
+    const Real pEn = parallelDMRG(ppsi,H,P,sweeps,"Quiet");
+    CHECK_CLOSE(pEn,En,1E-6);
+    CHECK_CLOSE(psiHphi(ppsi,H,ppsi),pEn,1E-10);
+    CHECK_CLOSE(psiphi(ppsi,ppsi),1,1E-10);
+
+    MPO rH = Heisenberg(sites);
+    MPS rpsi(initState);
+    const Real rEn = parallelDMRG(rpsi,rH,sweeps,"Quiet,NumBlocks=3");
+    CHECK_CLOSE(rEn,En,1E-6);
+    }
+
+SECTION("PackedStorage")
+    {
+    const int N = 20;
+    SpinHalf sites(N);
+
+    InitState initState(sites);
+    for(int i = 1; i <= N; ++i)
+        initState.set(i,i%2==1 ? "Up" : "Dn");
+
+    Sweeps sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-10;
+
+    IQMPO H = Heisenberg(sites);
+    IQMPS psi(initState);
+    QuietObserver<IQTensor> obs(psi);
+    const Real En = dmrg(psi,H,sweeps,obs,"Quiet");
+
+    resetPackStats();
+    IQMPS fpsi(initState);
+    QuietObserver<IQTensor> fobs(fpsi);
+    const OptSet fopts = OptSet("Quiet") & Opt("EnvPrecision","Float") 
+                                         & Opt("KrylovPrecision","Float");
+    const Real fEn = dmrg(fpsi,H,sweeps,fobs,fopts);
+    CHECK_CLOSE(fEn,En,1E-5);
+    CHECK(packStats().npack > 0);
+    CHECK(packStats().max_err < 1E-6);
+
+    MPO rH = Heisenberg(sites);
+    MPS rpsi(initState);
+    QuietObserver<ITensor> robs(rpsi);
+    const OptSet hopts = OptSet("Quiet") & Opt("EnvPrecision","BFloat16")
+                                         & Opt("KrylovPrecision","BFloat16");
+    const Real rEn = dmrg(rpsi,rH,sweeps,robs,hopts);
+    CHECK_CLOSE(rEn,En,1E-3);
+    CHECK_CLOSE(psiHphi(rpsi,rH,rpsi),rEn,1E-3);
+    }
+
+SECTION("SingleSiteDMRG")
+    {
+    const int N = 20;
+    SpinHalf sites(N);
+
+    InitState initState(sites);
+    for(int i = 1; i <= N; ++i)
+        initState.set(i,i%2==1 ? "Up" : "Dn");
+
+    Sweeps sweeps(8);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-10;
+
+    IQMPO H = Heisenberg(sites);
+    IQMPS psi(initState);
+    QuietObserver<IQTensor> obs(psi);
+    const Real En = dmrg(psi,H,sweeps,obs,"Quiet");
+
+    //Starting from a product state, the bond
+    //dimensions grow only through the expansion
+    IQMPS spsi(initState);
+    QuietObserver<IQTensor> sobs(spsi);
+    const Real sEn = dmrg(spsi,H,sweeps,sobs,"Quiet,NumCenter=1");
+    CHECK_CLOSE(sEn,En,1E-6);
+    CHECK_CLOSE(psiHphi(spsi,H,spsi),sEn,1E-8);
+    CHECK(linkInd(spsi,N/2).m() > 10);
+
+    IQMPS npsi(initState);
+    QuietObserver<IQTensor> nobs(npsi);
+    dmrg(npsi,H,sweeps,nobs,OptSet("Quiet,NumCenter=1") & Opt("ExpandWeight",0.));
+    CHECK_EQUAL(linkInd(npsi,N/2).m(),1);
+
+    MPO rH = Heisenberg(sites);
+    MPS rpsi(initState);
+    QuietObserver<ITensor> robs(rpsi);
+    const Real rEn = dmrg(rpsi,rH,sweeps,robs,"Quiet,NumCenter=1");
+    CHECK_CLOSE(rEn,En,1E-6);
+
+    //First excited state, orthogonal to spsi
+    std::vector<IQMPS> psis(1,spsi);
+    IQMPS xpsi(initState), 
+          x2psi(initState);
+    QuietObserver<IQTensor> xobs(x2psi),
+                            sxobs(xpsi);
+    const Real xEn = dmrg(x2psi,H,psis,sweeps,xobs,"Quiet,Weight=20");
+    const Real sxEn = dmrg(xpsi,H,psis,sweeps,sxobs,"Quiet,Weight=20,NumCenter=1");
+    CHECK_CLOSE(sxEn,xEn,1E-5);
+    CHECK(std::fabs(psiphi(xpsi,spsi)) < 1E-4);
+    }
 }
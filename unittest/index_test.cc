@@ -1,5 +1,6 @@
 #include "test.h"
 #include "index.h"
+#include <set>
 
 using namespace itensor;
 using namespace std;
@@ -54,4 +55,23 @@ TEST_CASE("IndexTest")
         else    CHECK(true);
 
         }
+
+    SECTION("Unique IDs")
+        {
+        //Indices made on different threads must not share ids
+        const int N = 20000;
+        std::vector<Index> inds(N);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int n = 0; n < N; ++n)
+            {
+            inds[n] = Index("i",2);
+            }
+        std::set<Real> ids;
+        for(int n = 0; n < N; ++n) ids.insert(inds[n].uniqueReal());
+        CHECK_EQUAL(int(ids.size()),N);
+        //no id equals that of the null Index
+        CHECK(ids.count(Index().uniqueReal()) == 0);
+        }
     }
@@ -1,5 +1,6 @@
 #include "test.h"
 #include "iqtensor.h"
+#include "packedtensor.h"
 
 using namespace itensor;
 using namespace std;
@@ -110,6 +111,79 @@ SECTION("NonContractProd")
 
     }
 
+SECTION("ContractProd")
+    {
+    IQTensor res = dag(phi) * A;
+    CHECK_EQUAL(res.r(),1);
+    CHECK(hasindex(res,L1));
+
+    ITensor dres = dag(phi).toITensor() * A.toITensor();
+    CHECK((res.toITensor()-dres).norm() < 1E-12);
+
+    //Block lookup must still work after
+    //changing the indices of every block
+    IQTensor pA = primed(A);
+    pA += primed(A);
+    for(int j1 = 1; j1 <= L1.m(); ++j1)
+    for(int j2 = 1; j2 <= L2.m(); ++j2)
+    for(int k1 = 1; k1 <= S1.m(); ++k1)
+    for(int k2 = 1; k2 <= S2.m(); ++k2)
+        {
+        CHECK_CLOSE(pA(prime(L1)(j1),prime(S1)(k1),prime(L2)(j2),prime(S2)(k2)),
+                    2*A(L1(j1),S1(k1),L2(j2),S2(k2)),1E-10);
+        }
+    }
+
+SECTION("ThreadedBlocks")
+    {
+    IQTensor res1 = dag(phi) * A,
+             res2 = A / B;
+
+    //Threaded block products must give exactly the same result
+    Global::opts("ThreadedBlocks",true);
+    IQTensor tres1 = dag(phi) * A,
+             tres2 = A / B;
+    Global::opts("ThreadedBlocks",false);
+
+    CHECK_EQUAL((tres1-res1).norm(),0);
+    CHECK_EQUAL((tres2-res2).norm(),0);
+    CHECK(res1.norm() > 0);
+
+    //Compare with the same products of dense ITensors,
+    //which do not go through the block products at all
+    ITensor dres1 = dag(phi).toITensor() * A.toITensor(),
+            dres2 = A.toITensor() / B.toITensor();
+    CHECK(dres1.norm() > 0);
+    CHECK_CLOSE((tres1.toITensor()-dres1).norm(),0,1E-12*dres1.norm());
+    CHECK_CLOSE((tres2.toITensor()-dres2).norm(),0,1E-12);
+    }
+
+#ifdef COLLECT_PRODSTATS
+SECTION("ThreadedProdTag")
+    {
+    Prodstats& ps = Prodstats::stats();
+    ps.reset();
+
+    //Block products done by worker threads
+    //are recorded under the caller's tag
+    Global::opts("ThreadedBlocks",true);
+    Prodstats::enabled() = true;
+        {
+        ProdTag tag("threaded");
+        IQTensor res = dag(phi) * A;
+        }
+    Prodstats::enabled() = false;
+    Global::opts("ThreadedBlocks",false);
+
+    CHECK(ps.total().count > 1);
+    Foreach(const Prodstats::Table::value_type& e, ps.table())
+        {
+        CHECK(e.first.tag == "threaded");
+        }
+    ps.reset();
+    }
+#endif
+
 SECTION("ComplexNonContractingProduct")
     {
     IQTensor Lr(L1(1),S1(2),L2(4)), Li(L1(1),S1(2),L2(4)),
@@ -360,6 +434,69 @@ SECTION("ComplexAdd")
 
     }
 
+SECTION("LinearComb")
+    {
+    //Terms with different sets of blocks
+    std::vector<IQTensor> T(3);
+    T[0] = phi;
+    T[1] = IQTensor(S1(2),S2(1),L2(2));
+    T[1].randomize();
+    T[2] = IQTensor(S2(2),L2(2),S1(1));
+    T[2].randomize();
+
+    std::vector<Real> c(3);
+    c[0] = 0.5; c[1] = -2; c[2] = 3;
+    const IQTensor exact = c[0]*T[0] + c[1]*T[1] + c[2]*T[2];
+
+    IQTensor res;
+    linearComb(c,T,res);
+    CHECK_CLOSE((res-exact).norm(),0,1E-12*exact.norm());
+
+    multiAxpy(c,T,res);
+    CHECK_CLOSE((res-2*exact).norm(),0,1E-12*exact.norm());
+
+    Global::opts("ThreadedBlocks",true);
+    std::vector<Complex> z(2);
+    z[0] = Complex(1,2); z[1] = Complex_i;
+    linearComb(z,T,res);
+    Global::opts("ThreadedBlocks",false);
+    CHECK_CLOSE((res-(z[0]*T[0]+z[1]*T[1])).norm(),0,1E-12*exact.norm());
+    }
+
+SECTION("PackedTensor")
+    {
+    resetPackStats();
+
+    IQTensor iT = phi;
+    iT.randomize();
+    IQTensor T = phi;
+    T += Complex_i*iT;
+
+    PackedTensor fT(T,FloatPrec);
+    IQTensor uT;
+    fT.unpack(uT);
+    CHECK(uT.isComplex());
+    CHECK_CLOSE((uT-T).norm(),0,1E-6*T.norm());
+    CHECK(packStats().max_err < 1E-6);
+
+    PackedTensor hT(T,BFloat16Prec);
+    CHECK_EQUAL(2*hT.nbytes(),fT.nbytes());
+    hT.unpack(uT);
+    CHECK_CLOSE((uT-T).norm(),0,1E-2*T.norm());
+    CHECK(packStats().max_err > 1E-6);
+    CHECK(packStats().max_err < 1E-2);
+
+    ITensor t = phi.toITensor();
+    t *= -4.5;
+    PackedTensor ft(t,FloatPrec);
+    ITensor ut;
+    ft.unpack(ut);
+    CHECK_CLOSE((ut-t).norm(),0,1E-6*t.norm());
+
+    CHECK_EQUAL(packStats().npack,3);
+    CHECK_EQUAL(packStats().nunpack,3);
+    }
+
 SECTION("RandomizeTest")
     {
     IQTensor T(L1(1),S1(1),L2(4),S2(2));
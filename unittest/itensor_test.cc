@@ -620,6 +620,48 @@ SECTION("SumDifference")
 
 }
 
+SECTION("PermutedSum")
+    {
+    //Adding tensors with different Index orders
+    //goes through the general permutation code
+    ITensor T(b2,b3,b4,b5,l1);
+    T.randomize();
+    ITensor P(l1,b4,b2,b5,b3);
+    P.randomize();
+    const Real f = -2.5;
+    ITensor S = P;
+    S += f*T;
+    for(int j2 = 1; j2 <= 2; ++j2)
+    for(int j3 = 1; j3 <= 3; ++j3)
+    for(int j4 = 1; j4 <= 4; ++j4)
+    for(int j5 = 1; j5 <= 5; ++j5)
+    for(int k1 = 1; k1 <= 2; ++k1)
+        {
+        CHECK_CLOSE(S(b2(j2),b3(j3),b4(j4),b5(j5),l1(k1)),
+                    P(b2(j2),b3(j3),b4(j4),b5(j5),l1(k1))
+                    +f*T(b2(j2),b3(j3),b4(j4),b5(j5),l1(k1)),1E-10);
+        }
+
+    //Contracting over an inner pair of indices
+    //requires T to be reshaped before the dgemm
+    ITensor Q(b3,b5,l2);
+    Q.randomize();
+    ITensor R = T * Q;
+    for(int j2 = 1; j2 <= 2; ++j2)
+    for(int j4 = 1; j4 <= 4; ++j4)
+    for(int k1 = 1; k1 <= 2; ++k1)
+    for(int k2 = 1; k2 <= 2; ++k2)
+        {
+        Real val = 0;
+        for(int j3 = 1; j3 <= 3; ++j3)
+        for(int j5 = 1; j5 <= 5; ++j5)
+            {
+            val += T(b2(j2),b3(j3),b4(j4),b5(j5),l1(k1))*Q(b3(j3),b5(j5),l2(k2));
+            }
+        CHECK_CLOSE(R(b2(j2),b4(j4),l1(k1),l2(k2)),val,1E-10);
+        }
+    }
+
 SECTION("ContractingProduct")
     {
 
@@ -977,6 +1019,111 @@ SECTION("ComplexTieIndices")
         }
     }
 
+SECTION("ExpandSliceEmbed")
+    {
+    Index B7("B7",7),
+          B9("B9",9);
+
+    ITensor T(b3,l1,b4);
+    T.randomize();
+    T *= 2.5;
+
+    //Expand b4 into B7 at offset 2, then slice it back out
+    ITensor E(T);
+    E.expandIndex(b4,B7,2);
+    CHECK(hasindex(E,B7));
+    CHECK_CLOSE(E.norm(),T.norm(),1E-10);
+    for(int i = 1; i <= 3; ++i)
+    for(int k = 1; k <= 4; ++k)
+        {
+        CHECK_CLOSE(E(b3(i),l1(2),B7(k+2)),T(b3(i),l1(2),b4(k)),1E-10);
+        }
+
+    ITensor S(E);
+    S.sliceIndex(B7,b4,2);
+    CHECK(hasindex(S,b4));
+    CHECK_CLOSE((S-T).norm(),0,1E-10);
+
+    //Combine b3 and l1 (b3 fastest) into B9 at offset 2,
+    //with the indices of the result in a different order
+    ITensor R(b4,B9,b5);
+    itensor::array<Index,NMAX+1> group;
+    group[1] = b3;
+    group[2] = l1;
+    ITensor T5 = T * ITensor(b5(3));
+    R.embed(T5,group,2,B9,2);
+    CHECK_CLOSE(R.norm(),T.norm(),1E-10);
+    for(int i = 1; i <= 3; ++i)
+    for(int j = 1; j <= 2; ++j)
+    for(int k = 1; k <= 4; ++k)
+        {
+        CHECK_CLOSE(R(b4(k),B9(2+i+3*(j-1)),b5(3)),T(b3(i),l1(j),b4(k)),1E-10);
+        }
+
+    //Complex tensors
+    ITensor Ti(b3,l1,b4);
+    Ti.randomize();
+    ITensor Z = T + Complex_i*Ti;
+    ITensor ZE(Z);
+    ZE.expandIndex(b4,B7,3);
+    ZE.sliceIndex(B7,b4,3);
+    CHECK_CLOSE(realPart(ZE-Z).norm(),0,1E-10);
+    CHECK_CLOSE(imagPart(ZE-Z).norm(),0,1E-10);
+    }
+
+SECTION("LazyScale")
+    {
+    ITensor L(b3,l1,b4),
+            M(b4,s1,b5),
+            R(b5,s1,b3);
+    L.randomize();
+    M.randomize();
+    R.randomize();
+
+    const ITensor eager = L*M*R;
+
+    Global::lazyScale() = true;
+    resetScaleStats();
+    const ITensor lazy = L*M*R;
+    CHECK(scaleStats().nskipped == 2);
+    CHECK(scaleStats().nscaled == 0);
+    CHECK_CLOSE((lazy-eager).norm(),0,1E-10*eager.norm());
+
+    //Elements of 1E40 times 1E40: the 
+    //product's norm must be scaled out
+    Vector V(4);
+    V = 1E40;
+    ITensor T(b4,V),
+            TT(b4,V);
+    resetScaleStats();
+    ITensor P = T*TT;
+    CHECK(scaleStats().nscaled == 1);
+    CHECK_CLOSE(P.normNoScale(),1,1E-12);
+    CHECK_CLOSE(P.normLogNum().logNum(),log(4.)+80*log(10.),1E-8);
+
+    //A single large element among ordinary ones
+    //must also be found
+    Index a("a",32),
+          t("t",2);
+    ITensor A(a,t),
+            D(t);
+    A.randomize();
+    A(a(2),t(1)) = 1E60;
+    D(t(1)) = 1;
+    D(t(2)) = 1;
+    resetScaleStats();
+    ITensor AD = A*D;
+    CHECK(scaleStats().nscaled == 1);
+    CHECK_CLOSE(AD.normNoScale(),1,1E-12);
+    CHECK_CLOSE(AD(a(2))/(1E60+A(a(2),t(2))),1,1E-12);
+
+    Global::lazyScale() = false;
+    resetScaleStats();
+    P = L*M;
+    CHECK(scaleStats().nscaled == 1);
+    CHECK(scaleStats().nskipped == 0);
+    }
+
 SECTION("Trace")
     {
 
@@ -1333,6 +1480,55 @@ SECTION("CC_ComplexAddition")
     CHECK_CLOSE(I.norm(),0,1E-5);
     }
 
+SECTION("LinearComb")
+    {
+    std::vector<ITensor> T(4);
+    T[0] = ITensor(b3,l1,b4);
+    T[1] = ITensor(b4,b3,l1);
+    T[2] = ITensor(l1,b4,b3);
+    T[3] = ITensor(b3,l1,b4);
+    Foreach(ITensor& t, T) t.randomize();
+    T[2] *= 1E30;
+    T[3] *= Complex_i;
+
+    std::vector<Real> c(3);
+    c[0] = 0.5; c[1] = -2; c[2] = 3E-30;
+    const ITensor exact = c[0]*T[0] + c[1]*T[1] + c[2]*T[2];
+
+    //Only the first c.size() tensors are used
+    ITensor res;
+    linearComb(c,T,res);
+    CHECK_CLOSE((res-exact).norm(),0,1E-12*exact.norm());
+    CHECK(!res.isComplex());
+
+    //Storage of res is reused
+    const Real* store = &res(b3(1),l1(1),b4(1));
+    c[1] = 1;
+    linearComb(c,T,res);
+    CHECK(&res(b3(1),l1(1),b4(1)) == store);
+    CHECK_CLOSE((res-(c[0]*T[0]+T[1]+c[2]*T[2])).norm(),0,1E-12*exact.norm());
+
+    res = T[1];
+    multiAxpy(c,T,res);
+    CHECK_CLOSE((res-(c[0]*T[0]+2*T[1]+c[2]*T[2])).norm(),0,1E-12*exact.norm());
+
+    std::vector<Complex> z(4);
+    z[0] = Complex(1,2); z[1] = Complex(0,-1); z[2] = 0; z[3] = Complex(3,1);
+    const ITensor zexact = z[0]*T[0] + z[1]*T[1] + z[3]*T[3];
+    linearComb(z,T,res);
+    CHECK(res.isComplex());
+    CHECK_CLOSE((res-zexact).norm(),0,1E-12*zexact.norm());
+
+    //res may also be one of the terms
+    res = T[0];
+    std::vector<ITensor> S(2);
+    S[0] = T[1];
+    S[1] = res;
+    c.resize(2);
+    linearComb(c,S,S[1]);
+    CHECK_CLOSE((S[1]-(c[0]*T[1]+c[1]*T[0])).norm(),0,1E-12*exact.norm());
+    }
+
 SECTION("ComplexScalar")
     {
     ITensor A(b4,s1),
@@ -1486,4 +1682,132 @@ SECTION("DiagMethod")
     CHECK(Norm(v-t2.diag()) < 1E-12);
     }
 
+SECTION("ReadWriteMapped")
+    {
+    const string dir = mkTempDir("RW","/tmp");
+    const string fname = dir+"/T";
+
+    //Large enough for page-aligned storage, plus
+    //a small complex tensor in the same file
+    Index i("i",40),j("j",30);
+    ITensor T(i,j), 
+            S(b3,b4);
+    T.randomize();
+    S.randomize();
+    S += Complex_i*S;
+    ITensor TS = T*S;
+    writeToFile(fname,TS);
+
+    //Data is used in place, not allocated
+    const int stored = StoreLink::TotalStorage();
+    ITensor R;
+    readFromFile(fname,R);
+    CHECK_EQUAL(StoreLink::TotalStorage(),stored);
+    CHECK_EQUAL((R-TS).norm(),0);
+
+    //Modifying R (data used in place) or rewriting 
+    //the file must not change either one
+    R *= 2;
+    R += T*S;
+    CHECK_CLOSE((R-3*TS).norm(),0,1E-10);
+    writeToFile(fname,T);
+    CHECK_CLOSE((R-3*TS).norm(),0,1E-10);
+    ITensor R2;
+    readFromFile(fname,R2);
+    CHECK_EQUAL((R2-T).norm(),0);
+
+    //Version 0 storage format
+    stringstream ss;
+    const int size = 3;
+    const Real dat[] = { 1.5, -2., 3.25 };
+    ss.write((char*)&size,sizeof(size));
+    ss.write((char*)dat,sizeof(dat));
+    ITDat d;
+    d.read(ss);
+    CHECK_EQUAL(d.v.Length(),3);
+    CHECK_EQUAL(d.v(3),3.25);
+    }
+
+#ifdef COLLECT_PRODSTATS
+SECTION("ContractionProfile")
+    {
+    Prodstats& ps = Prodstats::stats();
+    ps.reset();
+
+    Index a("a",20),
+          b("b",30),
+          c("c",40),
+          s("s",2),
+          t("t",3);
+    ITensor A(a,b),
+            B(b,c),
+            S(s,t,s),
+            T(t);
+    A.randomize();
+    B.randomize();
+    S.randomize();
+    T.randomize();
+
+    //Nothing recorded unless enabled
+    ITensor C = A*B;
+    CHECK_EQUAL(ps.total().count,0);
+
+    Prodstats::enabled() = true;
+        {
+        ProdTag tag("outer");
+        C = A*B;
+            {
+            ProdTag inner("inner");
+            C = S*T;
+            }
+        C = B*A;
+        }
+    C = A*B;
+    Prodstats::enabled() = false;
+
+    CHECK_EQUAL(ps.total().count,4);
+
+    ProdKey k;
+    k.tag = "outer";
+    k.kind = "gemm";
+    k.rL = 2;
+    k.rR = 2;
+    k.nc = 1;
+    //A*B and B*A both need no permutation
+    CHECK(ps.table().count(k) == 1);
+    CHECK_EQUAL(ps.table().find(k)->second.count,2);
+    CHECK_CLOSE(ps.table().find(k)->second.flops,2*2.*20*30*40,1E-10);
+
+    //Small product with the contracted index t
+    //in the middle of S: no reshape, directMultiply
+    k.tag = "inner";
+    k.kind = "direct";
+    k.rL = 3;
+    k.rR = 1;
+    k.nc = 1;
+    k.permL = true;
+    CHECK(ps.table().count(k) == 1);
+    CHECK_CLOSE(ps.table().find(k)->second.flops,2.*4*3,1E-10);
+
+    //Tag restored after each ProdTag goes out of scope
+    CHECK(std::string(ProdTag::current()) == "");
+    k.tag = "";
+    k.kind = "gemm";
+    k.rL = 2;
+    k.rR = 2;
+    k.permL = false;
+    CHECK(ps.table().count(k) == 1);
+
+    stringstream rep,
+                 json;
+    ps.report(rep,"flops");
+    ps.writeJSON(json);
+    CHECK(rep.str().find("outer") != string::npos);
+    CHECK(json.str().find("\"tag\": \"inner\"") != string::npos);
+
+    ps.reset();
+    CHECK_EQUAL(ps.total().count,0);
+    }
+#endif
+
 }
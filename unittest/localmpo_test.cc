@@ -1,6 +1,10 @@
 #include "test.h"
 #include "localmpo.h"
 #include "sites/spinhalf.h"
+#include "hams/Heisenberg.h"
+#include "sweeps.h"
+#include "dmrg.h"
+#include "quietobserver.h"
 
 using namespace itensor;
 
@@ -25,3 +29,162 @@ TEST_CASE("LocalMPOAsMPS")
     }
 
 
+
+TEST_CASE("DiskCache")
+    {
+    const std::string dir = mkTempDir("DC","/tmp");
+    Index i("i",3),j("j",4);
+    ITensor A(i,j),B(i,j);
+    A.randomize();
+    B.randomize();
+
+    for(int async = 0; async < 2; ++async)
+        {
+        DiskCache<ITensor> dc(async == 1);
+        const std::string fa = dir+"/A", 
+                          fb = dir+"/B";
+        dc.put(fa,A);
+        dc.put(fb,B);
+
+        //Possibly still in memory
+        ITensor T;
+        dc.get(fa,T);
+        CHECK_EQUAL((T-A).norm(),0);
+
+        //Read back after the writes finish
+        dc.flush();
+        dc.prefetch(fb);
+        dc.get(fb,T);
+        CHECK_EQUAL((T-B).norm(),0);
+
+        //Later put supersedes earlier one
+        dc.prefetch(fa);
+        dc.put(fa,B);
+        dc.get(fa,T);
+        CHECK_EQUAL((T-B).norm(),0);
+        dc.flush();
+        dc.get(fa,T);
+        CHECK_EQUAL((T-B).norm(),0);
+
+        CHECK_EQUAL(dc.stats().nwrite,3);
+        CHECK_EQUAL(dc.stats().nread,4);
+        }
+
+    //Failed background writes are reported in the calling thread
+    DiskCache<ITensor> dc;
+    const std::string fbad = dir+"/missing_dir/A";
+    dc.put(fbad,A);
+    CHECK_THROWS_AS(dc.flush(),ITError);
+    ITensor T;
+    CHECK_THROWS_AS(dc.get(fbad,T),ITError);
+    //Reported once; later writes work as before
+    dc.flush();
+    dc.put(dir+"/A",B);
+    dc.flush();
+    dc.get(dir+"/A",T);
+    CHECK_EQUAL((T-B).norm(),0);
+    }
+
+TEST_CASE("LocalMPOWrite")
+    {
+    static const int N = 10;
+    SpinHalf sites(N);
+    IQMPO H = Heisenberg(sites);
+
+    InitState init(sites);
+    for(int j = 1; j <= N; ++j)
+        {
+        init.set(j,j%2==1 ? "Up" : "Dn");
+        }
+    IQMPS psi(init);
+
+    const std::string dir = Global::opts().getString("WriteDir","./");
+    Global::opts("WriteDir",std::string("/tmp"));
+
+    for(int async = 0; async < 2; ++async)
+        {
+        Global::opts("WriteAsync",async == 1);
+
+        LocalMPO<IQTensor> PH(H),
+                           PHw(H);
+        PHw.doWrite(true);
+
+        //Sweep back and forth twice
+        for(int sw = 1; sw <= 2; ++sw)
+        for(int b = 1, ha = 1; ha <= 2; sweepnext(b,ha,N))
+            {
+            psi.position(b);
+            PH.position(b,psi);
+            PHw.position(b,psi);
+            if(PH.L()) CHECK((PH.L()-PHw.L()).norm() < 1E-12);
+            if(PH.R()) CHECK((PH.R()-PHw.R()).norm() < 1E-12);
+            }
+
+        const DiskStats ds = PHw.diskStats();
+        CHECK(ds.nwrite > 0);
+        CHECK(ds.nread > 0);
+        }
+
+    Global::opts("WriteAsync",true);
+    Global::opts("WriteDir",dir);
+    }
+
+TEST_CASE("SparseMPO")
+    {
+    static const int N = 10;
+    SpinHalf sites(N);
+    IQMPO H = Heisenberg(sites);
+
+    std::vector<SparseMPOTensor<IQTensor> > S;
+    sparseMPO(H,S);
+    CHECK_EQUAL(int(S.size()),N+1);
+    CHECK(!S.at(0).valid());
+    //Bulk W has 2 identities, S+, S-, Sz in the first 
+    //column and S-, S+, Sz in the last row
+    CHECK_EQUAL(int(S.at(N/2).elems().size()),8);
+    CHECK_EQUAL(S.at(N/2).nidentity(),2);
+
+    InitState init(sites);
+    for(int j = 1; j <= N; ++j)
+        {
+        init.set(j,j%2==1 ? "Up" : "Dn");
+        }
+    IQMPS psi(init);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10,20;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,H,sweeps,obs,Opt("Quiet"));
+
+    for(int nc = 1; nc <= 2; ++nc)
+        {
+        const OptSet opts = Opt("NumCenter",nc);
+        LocalMPO<IQTensor> PH(H,opts),
+                           PHs(H,opts & Opt("SparseMPO",true));
+        for(int b = 1; b <= N-nc+1; ++b)
+            {
+            psi.position(b);
+            PH.position(b,psi);
+            PHs.position(b,psi);
+            IQTensor phi = (nc == 2 ? psi.A(b)*psi.A(b+1) : psi.A(b)),
+                     r, rs;
+            PH.product(phi,r);
+            PHs.product(phi,rs);
+            CHECK((r-rs).norm() < 1E-12*r.norm());
+            }
+        }
+
+    MPO Hd = H.toMPO();
+    MPS psid(init);
+    QuietObserver<ITensor> dobs(psid);
+    dmrg(psid,Hd,sweeps,dobs,Opt("Quiet"));
+    LocalMPO<ITensor> PH(Hd),
+                      PHs(Hd,Opt("SparseMPO",true));
+    psid.position(N/2);
+    PH.position(N/2,psid);
+    PHs.position(N/2,psid);
+    ITensor phi = psid.A(N/2)*psid.A(N/2+1),
+            r, rs;
+    PH.product(phi,r);
+    PHs.product(phi,rs);
+    CHECK((r-rs).norm() < 1E-12*r.norm());
+    }
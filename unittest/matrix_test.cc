@@ -90,6 +90,126 @@ SECTION("TestSVD")
     REQUIRE(sumerrsq < 1E-12);
     }
 
+SECTION("TestSVDgesdd")
+    {
+    //Check both n < m and n > m cases
+    for(int t = 0; t < 2; ++t)
+        {
+        const int n = (t == 0 ? 20 : 35),
+                  m = (t == 0 ? 35 : 20),
+                  k = min(n,m);
+        Matrix A(n,m);
+        A.Randomize();
+
+        Matrix U,V;  Vector D;
+        SVDgesdd(A,U,D,V);
+
+        CHECK_EQUAL(U.Nrows(),n);
+        CHECK_EQUAL(U.Ncols(),k);
+        CHECK_EQUAL(V.Nrows(),k);
+        CHECK_EQUAL(V.Ncols(),m);
+        for(int i = 2; i <= k; ++i) CHECK(D(i) <= D(i-1));
+
+        Matrix DD(k,k); DD = 0.0; DD.Diagonal() = D;
+        Matrix err = A - U * DD * V;
+        CHECK(Norm(err.TreatAsVector()) < 1E-10);
+        }
+    }
+
+SECTION("TestSVDJacobi")
+    {
+    //Singular values spanning 14 orders of magnitude
+    const int n = 30, m = 50;
+    Matrix uu(n,n), vv(n,m), rr(n,n);
+    uu.Randomize(); 
+    vv.Randomize();
+    Vector d;
+    //Orthogonal matrices from eigenvectors
+    //of random symmetric matrices
+    rr = uu+uu.t(); EigenValues(rr,d,uu);
+    Matrix ss(m,m); ss.Randomize(); ss += ss.t();
+    Matrix ww; EigenValues(ss,d,ww);
+    vv = ww.t().SubMatrix(1,n,1,m);
+
+    Vector exact(n);
+    Matrix dd(n,n); dd = 0.0;
+    for(int i = 1; i <= n; ++i) 
+        {
+        exact(i) = pow(10.,-14.*(i-1)/(n-1));
+        dd(i,i) = exact(i);
+        }
+    Matrix A = uu * dd * vv;
+
+    for(int t = 0; t < 2; ++t)
+        {
+        Matrix U,V;  Vector D;
+        if(t == 0) SVDJacobi(A,U,D,V);
+        else       SVDJacobi(A.t(),V,D,U);
+        if(t == 1) { U = U.t(); V = V.t(); }
+
+        CHECK_EQUAL(D.Length(),n);
+        Matrix DD(n,n); DD = 0.0; DD.Diagonal() = D;
+        Matrix err = A - U * DD * V;
+        CHECK(Norm(err.TreatAsVector()) < 1E-12);
+
+        //Largest singular values accurate to high relative precision
+        for(int i = 1; i <= n/2; ++i)
+            {
+            CHECK_CLOSE(D(i)/exact(i),1.,1E-6);
+            }
+        }
+    }
+
+SECTION("TestSVDRandomized")
+    {
+    //Rapidly decaying singular values
+    const int n = 120, m = 90, k = 15;
+    Matrix uu(n,n), ss(m,m);
+    uu.Randomize(); uu += uu.t();
+    ss.Randomize(); ss += ss.t();
+    Vector d;
+    Matrix U0, V0;
+    EigenValues(uu,d,U0);
+    EigenValues(ss,d,V0);
+
+    Matrix dd(m,m); dd = 0.0;
+    Vector exact(m);
+    for(int i = 1; i <= m; ++i) 
+        {
+        exact(i) = pow(0.7,i-1);
+        dd(i,i) = exact(i);
+        }
+    Matrix A = U0.SubMatrix(1,n,1,m) * dd * V0.t();
+
+    Matrix U,V;  Vector D;
+    Real w = SVDRandomized(A,U,D,V,k,10,2);
+
+    CHECK_EQUAL(D.Length(),k+10);
+    CHECK_EQUAL(U.Ncols(),k+10);
+    CHECK_EQUAL(V.Nrows(),k+10);
+
+    for(int i = 1; i <= k; ++i)
+        {
+        CHECK_CLOSE(D(i)/exact(i),1.,1E-8);
+        }
+
+    //Returned weight is the squared error of the approximation
+    Matrix DD(D.Length(),D.Length()); DD = 0.0; DD.Diagonal() = D;
+    Matrix err = A - U * DD * V;
+    const Real nerr = Norm(err.TreatAsVector());
+    CHECK_CLOSE(w,nerr*nerr,1E-14);
+
+    Real exactw = 0;
+    for(int i = k+11; i <= m; ++i) exactw += sqr(exact(i));
+    //and at least the optimal (discarded) weight
+    CHECK(w > 0.999*exactw);
+    CHECK(w < 2*exactw);
+
+    Matrix Id(k+10,k+10); Id = 1.0;
+    Matrix ou = U.t()*U - Id;
+    CHECK(Norm(ou.TreatAsVector()) < 1E-12);
+    }
+
 SECTION("TestSVDComplex")
     {
     const int n = 10,
@@ -1,6 +1,13 @@
 #include "test.h"
+#include "dmrg.h"
+#include "quietobserver.h"
+#include "autompo.h"
 #include "sites/spinone.h"
+#include "sites/spinhalf.h"
+#include "sites/hubbard.h"
+#include "sites/spinless.h"
 #include "hams/Heisenberg.h"
+#include "hams/HubbardChain.h"
 
 using namespace itensor;
 using namespace std;
@@ -18,4 +25,219 @@ SECTION("Position")
     CHECK_EQUAL(H.orthoCenter(),1);
     }
 
+SECTION("AutoMPOHeisenberg")
+    {
+    //Width 4 cylinder
+    const int Ny = 4,
+              Nx = 3,
+              Ns = Nx*Ny;
+    SpinHalf sites(Ns);
+
+    AutoMPO ampo(sites);
+    for(int n = 1; n <= Ns; ++n)
+        {
+        const int x = (n-1)/Ny+1, 
+                  y = (n-1)%Ny+1;
+        std::vector<int> nn;
+        if(y < Ny) nn.push_back(n+1);
+        if(y == 1) nn.push_back(n+Ny-1);
+        if(x < Nx) nn.push_back(n+Ny);
+        Foreach(int m, nn)
+            {
+            ampo += 0.5,"S+",n,"S-",m;
+            ampo += 0.5,"S-",n,"S+",m;
+            ampo +=     "Sz",n,"Sz",m;
+            }
+        }
+    CHECK_EQUAL(ampo.numTerms(),3*(2*Ns-Ny));
+
+    IQMPO H = ampo;
+    IQMPO Hh = Heisenberg(sites,Opt("Ny",Ny));
+
+    for(int b = 1; b < Ns; ++b)
+        {
+        CHECK(linkInd(H,b).m() <= linkInd(Hh,b).m());
+        }
+
+    InitState init(sites);
+    for(int j = 1; j <= Ns; ++j) init.set(j,(j%2==1 ? "Up" : "Dn"));
+    IQMPS psi(init);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10,20;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,Hh,sweeps,obs,Opt("Quiet"));
+
+    CHECK_CLOSE(psiHphi(psi,H,psi),psiHphi(psi,Hh,psi),1E-10);
+
+    //Chain: near-optimal bond dimension
+    SpinHalf csites(8);
+    AutoMPO campo(csites);
+    for(int j = 1; j < 8; ++j)
+        {
+        campo += 0.5,"S+",j,"S-",j+1;
+        campo += 0.5,"S-",j,"S+",j+1;
+        campo +=     "Sz",j,"Sz",j+1;
+        }
+    IQMPO Hc = campo;
+    CHECK_EQUAL(linkInd(Hc,4).m(),5);
+    }
+
+SECTION("AutoMPOHubbard")
+    {
+    const int Ns = 6;
+    const Real t = 1, U = 4;
+    Hubbard sites(Ns);
+
+    AutoMPO ampo(sites);
+    for(int j = 1; j < Ns; ++j)
+        {
+        ampo += -t,"Cdagup",j,"Cup",j+1;
+        ampo += -t,"Cdagup",j+1,"Cup",j;
+        ampo += -t,"Cdagdn",j,"Cdn",j+1;
+        ampo += -t,"Cdagdn",j+1,"Cdn",j;
+        }
+    for(int j = 1; j <= Ns; ++j)
+        {
+        ampo += U,"Nupdn",j;
+        }
+    IQMPO H = ampo;
+    IQMPO Hh = HubbardChain(sites,Opt("t",t) & Opt("U",U));
+
+    CHECK_EQUAL(linkInd(H,Ns/2).m(),6);
+
+    InitState init(sites);
+    for(int j = 1; j <= Ns; ++j) init.set(j,(j%2==1 ? "Up" : "Dn"));
+    IQMPS psi(init);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10,20;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,Hh,sweeps,obs,Opt("Quiet"));
+
+    CHECK_CLOSE(psiHphi(psi,H,psi),psiHphi(psi,Hh,psi),1E-10);
+    }
+
+SECTION("AutoMPOFermions")
+    {
+    //Spinless fermions with nearest and next-nearest 
+    //neighbor hopping, the latter written with the 
+    //operators out of site order
+    const int Ns = 8;
+    Spinless sites(Ns);
+
+    AutoMPO ampo(sites);
+    Matrix h(Ns,Ns);
+    h = 0;
+    for(int j = 1; j < Ns; ++j)
+        {
+        ampo += -1,"Cdag",j,"C",j+1;
+        ampo += -1,"Cdag",j+1,"C",j;
+        h(j,j+1) = h(j+1,j) = -1;
+        }
+    for(int j = 1; j+2 <= Ns; ++j)
+        {
+        ampo += +0.5,"C",j+2,"Cdag",j;
+        ampo += -0.5,"Cdag",j+2,"C",j;
+        h(j,j+2) = h(j+2,j) = -0.5;
+        }
+    IQMPO H = ampo;
+
+    Vector evals;
+    Matrix evecs;
+    EigenValues(h,evals,evecs);
+    Real exact = 0;
+    for(int j = 1; j <= Ns/2; ++j) exact += evals(j);
+
+    InitState init(sites);
+    for(int j = 1; j <= Ns; ++j) init.set(j,(j%2==1 ? "Occ" : "Emp"));
+    IQMPS psi(init);
+    Sweeps sweeps(5);
+    sweeps.maxm() = 10,20,40;
+    sweeps.cutoff() = 1E-12;
+    QuietObserver<IQTensor> obs(psi);
+    const Real E = dmrg(psi,H,sweeps,obs,Opt("Quiet"));
+
+    CHECK_CLOSE(E,exact,1E-8);
+    }
+
+SECTION("ApplyMPOContext")
+    {
+    const int Ns = 10;
+    SpinHalf sites(Ns);
+    IQMPO H = Heisenberg(sites);
+
+    InitState init(sites);
+    for(int j = 1; j <= Ns; ++j) init.set(j,(j%2==1 ? "Up" : "Dn"));
+    IQMPS psi(init);
+    Sweeps sweeps(3);
+    sweeps.maxm() = 10,20;
+    sweeps.cutoff() = 1E-12;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,H,sweeps,obs,Opt("Quiet"));
+    psi.position(1);
+
+    const OptSet opts = Opt("Normalize",false) & Opt("Cutoff",1E-12);
+    const Real E = psiHphi(psi,H,psi);
+
+    IQMPS res(psi),
+          resf(psi);
+    fitApplyMPO(1.,psi,H,resf,opts);
+
+    ApplyMPOContext<IQTensor> ctx(H);
+    ctx.apply(1.,psi,res,opts);
+    CHECK_EQUAL(ctx.nreused(),0);
+    CHECK_EQUAL(ctx.nrebuilt(),Ns-2);
+    CHECK_CLOSE(psiphi(psi,res),psiphi(psi,resf),1E-10);
+
+    //Same psi: all environments are reused
+    ctx.apply(1.,psi,res,opts);
+    CHECK_EQUAL(ctx.nreused(),Ns-2);
+    CHECK_EQUAL(ctx.nrebuilt(),Ns-2);
+    CHECK_CLOSE(psiphi(psi,res),E,1E-8);
+
+    //|psi> - tau*H|psi>: environments of <res|psi> are
+    //computed for the first time, those of <res|H|psi> reused
+    const Real tau = 0.1;
+    IQMPS res2(res),
+          res2f(res);
+    const Real olp = ctx.apply(1.,psi,-tau,psi,res2,opts);
+    CHECK_EQUAL(ctx.nreused(),2*(Ns-2));
+    CHECK_EQUAL(ctx.nrebuilt(),2*(Ns-2));
+    const Real olpf = fitApplyMPO(1.,psi,-tau,psi,H,res2f,opts);
+    CHECK_CLOSE(olp,olpf,1E-10);
+    CHECK_CLOSE(olp,1-tau*E,1E-8);
+    }
+
+SECTION("FitMultMPO")
+    {
+    const int Ns = 10;
+    SpinHalf sites(Ns);
+    IQMPO H = Heisenberg(sites);
+
+    InitState init(sites);
+    for(int j = 1; j <= Ns; ++j) init.set(j,(j%2==1 ? "Up" : "Dn"));
+    IQMPS psi(init);
+    Sweeps sweeps(2);
+    sweeps.maxm() = 10,20;
+    QuietObserver<IQTensor> obs(psi);
+    dmrg(psi,H,sweeps,obs,Opt("Quiet"));
+
+    const Real H2 = psiHKphi(psi,H,H,psi);
+
+    IQMPO HH;
+    fitMultMPO(H,H,HH,Opt("Cutoff",1E-14));
+    CHECK_CLOSE(psiHphi(psi,HH,psi),H2,1E-10);
+
+    //Result of nmultMPO as the initial guess
+    IQMPO HHz;
+    nmultMPO(H,H,HHz,Opt("Cutoff",1E-14));
+    fitMultMPO(H,H,HHz,Opt("Cutoff",1E-14) & Opt("Nsweep",1));
+    CHECK_CLOSE(psiHphi(psi,HHz,psi),H2,1E-10);
+
+    MPS psid(init);
+    MPO Hd = H.toMPO(),
+        HHd;
+    fitMultMPO(Hd,Hd,HHd,Opt("Cutoff",1E-14));
+    CHECK_CLOSE(psiHphi(psid,HHd,psid),psiHKphi(psid,Hd,Hd,psid),1E-10);
+    }
+
 }
@@ -1,5 +1,6 @@
 #include "test.h"
 #include "mps.h"
+#include "correlation.h"
 #include "sites/spinhalf.h"
 #include "sites/spinless.h"
 
@@ -75,5 +76,80 @@ SECTION("PositionTest")
     CHECK_EQUAL(findCenter(psi),4);
     }
 
+SECTION("CorrelationMatrix")
+    {
+    //Compare each entry against <psi|phi> where phi
+    //is psi with the operators applied directly
+    const int Nc = 6;
+
+    SpinHalf ssites(Nc);
+    InitState s1(ssites),
+              s2(ssites),
+              s3(ssites);
+    for(int j = 1; j <= Nc; ++j)
+        {
+        s1.set(j,j%2==1 ? "Up" : "Dn");
+        s2.set(j,j%2==1 ? "Dn" : "Up");
+        s3.set(j,j <= Nc/2 ? "Up" : "Dn");
+        }
+    IQMPS spsi = sum(0.6*IQMPS(s1),sum(0.3*IQMPS(s2),-0.5*IQMPS(s3)));
+
+    Matrix C = correlationMatrix(spsi,"Sz","Sz");
+    const Real snrm = psiphi(spsi,spsi);
+    for(int i = 1; i <= Nc; ++i)
+    for(int j = 1; j <= Nc; ++j)
+        {
+        IQMPS phi(spsi);
+        if(i == j)
+            {
+            phi.Anc(i) = noprime(ssites.op("Sz*Sz",i)*phi.A(i),Site);
+            }
+        else
+            {
+            phi.Anc(i) = noprime(ssites.op("Sz",i)*phi.A(i),Site);
+            phi.Anc(j) = noprime(ssites.op("Sz",j)*phi.A(j),Site);
+            }
+        CHECK_CLOSE(C(i,j),psiphi(spsi,phi)/snrm,1E-10);
+        }
+
+    //Two spinless fermions, with Jordan-Wigner strings
+    Spinless fsites(Nc);
+    InitState f1(fsites,"Emp"),
+              f2(fsites,"Emp"),
+              f3(fsites,"Emp");
+    f1.set(1,"Occ"); f1.set(3,"Occ");
+    f2.set(2,"Occ"); f2.set(5,"Occ");
+    f3.set(3,"Occ"); f3.set(6,"Occ");
+    MPS fpsi = sum(0.7*MPS(f1),sum(-0.4*MPS(f2),0.2*MPS(f3)));
+
+    Matrix G = correlationMatrix(fpsi,"Adag","A",Opt("String","F"));
+    const Real fnrm = psiphi(fpsi,fpsi);
+    for(int i = 1; i <= Nc; ++i)
+    for(int j = 1; j <= Nc; ++j)
+        {
+        MPS phi(fpsi);
+        if(i == j)
+            {
+            phi.Anc(i) = noprime(fsites.op("N",i)*phi.A(i),Site);
+            }
+        else
+            {
+            phi.Anc(i) = noprime(fsites.op("Adag",i)*phi.A(i),Site);
+            phi.Anc(j) = noprime(fsites.op("A",j)*phi.A(j),Site);
+            for(int k = std::min(i,j)+1; k < std::max(i,j); ++k)
+                {
+                phi.Anc(k) = noprime(fsites.op("F",k)*phi.A(k),Site);
+                }
+            }
+        CHECK_CLOSE(G(i,j),psiphi(fpsi,phi)/fnrm,1E-10);
+        }
+
+    //Total particle number on the diagonal
+    Real ntot = 0;
+    for(int i = 1; i <= Nc; ++i) ntot += G(i,i);
+    CHECK_CLOSE(ntot,2,1E-10);
+    }
+
+
 
 }
@@ -146,6 +146,39 @@ SECTION("StringConstructor")
     CHECK(fabs(o4.getReal("Val")-(-4.235235)) < 1E-12);
     }
 
+SECTION("ThreadOpts")
+    {
+    Global::opts("TestThreadOpt",1);
+        {
+        ThreadOpts topts;
+        CHECK(topts.opts().getInt("TestThreadOpt") == 1);
+        Global::opts("TestThreadOpt",2);
+        CHECK(Global::opts().getInt("TestThreadOpt") == 2);
+        CHECK(OptSet().getInt("TestThreadOpt") == 2);
+            {
+            ThreadOpts inner(Opt("TestThreadOpt",3));
+            CHECK(OptSet().getInt("TestThreadOpt") == 3);
+            }
+        CHECK(OptSet().getInt("TestThreadOpt") == 2);
+        }
+    CHECK(OptSet().getInt("TestThreadOpt") == 1);
+
+    //Each thread sees only the options it set
+    const int N = 8;
+    std::vector<int> got(N,0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int n = 0; n < N; ++n)
+        {
+        ThreadOpts topts;
+        Global::opts("TestThreadOpt",10+n);
+        got[n] = OptSet().getInt("TestThreadOpt");
+        }
+    for(int n = 0; n < N; ++n) CHECK(got[n] == 10+n);
+    CHECK(OptSet().getInt("TestThreadOpt") == 1);
+    }
+
 #ifdef USE_CPP11
 SECTION("VariadicConstructor")
     {
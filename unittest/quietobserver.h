@@ -0,0 +1,27 @@
+#ifndef __ITENSOR_UNITTEST_QUIETOBSERVER_H
+#define __ITENSOR_UNITTEST_QUIETOBSERVER_H
+
+#include "dmrg.h"
+
+//
+// DMRGObserver which prints nothing (DMRGObserver prints
+// the energy and entropy after each sweep even if "Quiet"
+// is set), so tests running dmrg keep the output short
+//
+template <class Tensor>
+class QuietObserver : public itensor::DMRGObserver<Tensor>
+    {
+    public:
+
+    QuietObserver(const itensor::MPSt<Tensor>& psi)
+        : itensor::DMRGObserver<Tensor>(psi)
+        { }
+
+    void virtual
+    measure(const itensor::OptSet&) { }
+
+    bool virtual
+    checkDone(const itensor::OptSet&) { return false; }
+    };
+
+#endif
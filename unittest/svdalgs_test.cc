@@ -186,6 +186,94 @@ SECTION("BondSVD")
     
     }
 
+SECTION("SVDMethod")
+    {
+    const char* methods[] = { "Iterative", "gesdd", "Jacobi" };
+    for(int n = 0; n < 3; ++n)
+        {
+        OptSet opts;
+        opts.add("SVDMethod",string(methods[n]));
+
+        ITensor l(L1,S1,Mid),r(Mid,S2,L2);
+        ITensor v(Mid);
+        csvd(phi0,l,v,r,opts);
+        CHECK(((l*v*r)-phi0).norm() < 1E-12);
+
+        IQTensor L(L1,S1,Mid),R(Mid,S2,L2);
+        IQTensor V(Mid);
+        csvd(Phi0,L,V,R,opts);
+        CHECK(((L*V*R)-Phi0).norm() < 1E-12);
+
+        //Complex case
+        IQTensor cPhi = Phi0 + Complex_i*Phi0;
+        IQTensor U(L1,S1),D,W;
+        svd(cPhi,U,D,W,opts);
+        CHECK(((U*D*W)-cPhi).norm() < 1E-12);
+        }
+    }
+
+SECTION("RandomizedSVD")
+    {
+    OptSet opts;
+    opts.add("SVDMethod",string("Randomized"));
+    opts.add("Maxm",3);
+    opts.add("Cutoff",0);
+    opts.add("SVDOversample",2);
+
+    //Truncation error includes the weight of the 
+    //singular values not computed
+    IQTensor L(L1,S1,Mid),R(Mid,S2,L2);
+    IQTensor V(Mid);
+    Spectrum spec = csvd(Phi0,L,V,R,opts);
+    Real diff = ((L*V*R)-Phi0).norm();
+    CHECK_CLOSE(spec.truncerr(),sqr(diff),1E-10);
+
+    ITensor l(L1,S1,Mid),r(Mid,S2,L2);
+    ITensor v(Mid);
+    spec = csvd(phi0,l,v,r,opts);
+    diff = ((l*v*r)-phi0).norm();
+    CHECK_CLOSE(spec.truncerr(),sqr(diff),1E-10);
+
+    //denmatDecomp uses the randomized svd
+    IQTensor A(L1,S1),B(S2,L2);
+    spec = denmatDecomp(Phi0,A,B,Fromleft,opts);
+    CHECK_EQUAL(commonIndex(A,B,Link).m(),spec.numEigsKept());
+    diff = ((A*B)-Phi0).norm();
+    CHECK_CLOSE(spec.truncerr(),sqr(diff),1E-10);
+    }
+
+SECTION("ThreadedBlocks")
+    {
+    OptSet opts;
+    opts.add("Maxm",12);
+    opts.add("Cutoff",1E-8);
+
+    //svdRank2 via csvd
+    IQTensor L(L1,S1,Mid),R(Mid,S2,L2);
+    IQTensor V(Mid);
+    Spectrum spec = csvd(Phi0,L,V,R,opts);
+
+    IQTensor tL(L1,S1,Mid),tR(Mid,S2,L2);
+    IQTensor tV(Mid);
+    opts.add("ThreadedBlocks",true);
+    Spectrum tspec = csvd(Phi0,tL,tV,tR,opts);
+
+    CHECK_EQUAL(spec.truncerr(),tspec.truncerr());
+    CHECK_EQUAL(((L*V*R)-(tL*tV*tR)).norm(),0);
+
+    //diag_hermitian via denmatDecomp
+    opts.add("ThreadedBlocks",false);
+    IQTensor A(L1,S1),B(S2,L2);
+    spec = denmatDecomp(Phi0,A,B,Fromleft,opts);
+
+    IQTensor tA(L1,S1),tB(S2,L2);
+    opts.add("ThreadedBlocks",true);
+    tspec = denmatDecomp(Phi0,tA,tB,Fromleft,opts);
+
+    CHECK_EQUAL(spec.truncerr(),tspec.truncerr());
+    CHECK_EQUAL(((A*B)-(tA*tB)).norm(),0);
+    }
+
 SECTION("CSVDNorm")
     {
     //
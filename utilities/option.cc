@@ -146,6 +146,18 @@ OptSet(const string& ostring)
     processString(ostring);
     }
 
+//Set by ThreadOpts; each thread has its own copy
+//(__thread is supported by gcc, clang and icc)
+static __thread OptSet* threadGlobalOpts_ = 0;
+
+OptSet& OptSet::
+GlobalOpts()
+    {
+    if(threadGlobalOpts_) return *threadGlobalOpts_;
+    static OptSet gos_;
+    return gos_;
+    }
+
 OptSet::
 OptSet(const OptSet& other)
     { 
@@ -373,6 +385,38 @@ operator+=(const OptSet& oset)
     }
 
 
+ThreadOpts::
+ThreadOpts()
+    {
+    install();
+    }
+
+ThreadOpts::
+ThreadOpts(const OptSet& extra)
+    {
+    install();
+    opts_ += extra;
+    }
+
+void ThreadOpts::
+install()
+    {
+    //Copying an OptSet leaves out the global
+    //options, so add them one by one
+    Foreach(const Opt& x, OptSet::GlobalOpts())
+        {
+        opts_.add(x);
+        }
+    prev_ = threadGlobalOpts_;
+    threadGlobalOpts_ = &opts_;
+    }
+
+ThreadOpts::
+~ThreadOpts()
+    {
+    threadGlobalOpts_ = prev_;
+    }
+
 OptSet
 operator+(const Opt& opt1, const Opt& opt2)
     {
@@ -232,12 +232,11 @@ class OptSet
     bool
     isGlobal() const { return (this == &GlobalOpts()); }
 
+    //The global options of the calling thread:
+    //those of its innermost ThreadOpts if any,
+    //otherwise the ones shared by the whole process
     static OptSet&
-    GlobalOpts()
-        {
-        static OptSet gos_;
-        return gos_;
-        }
+    GlobalOpts();
 
     private:
 
@@ -282,6 +281,57 @@ class OptSet
 
     };
 
+//
+// ThreadOpts
+//
+// While a ThreadOpts exists, OptSet::GlobalOpts() (and
+// so Global::opts()) on the thread that made it refers
+// to the ThreadOpts's own option set instead of the one
+// shared by the process. The set starts as a copy of the
+// global options in effect when the ThreadOpts is made,
+// so independent calculations on different threads can
+// each set global options without affecting the others:
+//
+//  #pragma omp parallel for
+//  for(int n = 0; n < nrun; ++n)
+//      {
+//      ThreadOpts topts;
+//      Global::opts("MyOption",n);
+//      ...
+//      }
+//
+// ThreadOpts may be nested; the enclosing global options
+// are restored when a ThreadOpts is destroyed.
+//
+class ThreadOpts
+    {
+    public:
+
+    ThreadOpts();
+
+    //Start from the enclosing global options
+    //with those in extra added
+    explicit
+    ThreadOpts(const OptSet& extra);
+
+    ~ThreadOpts();
+
+    OptSet&
+    opts() { return opts_; }
+
+    private:
+
+    OptSet opts_;
+    OptSet* prev_;
+
+    void
+    install();
+
+    //Not copyable
+    ThreadOpts(const ThreadOpts&);
+    void operator=(const ThreadOpts&);
+    };
+
 OptSet
 operator+(const Opt& opt1, const Opt& opt2);
 